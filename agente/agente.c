@@ -29,7 +29,7 @@
 
 /************************************************************************************************************
  *                                                                                                          *
- *  int registrar_agente(const char *nombre, const char *pipe_srv, const char *pipe_resp);                  *
+ *  int registrar_agente(const char *nombre, const char *pipe_srv, const char *pipe_resp, int parque);      *
  *                                                                                                          *
  *  Proposito: Enviar al controlador un mensaje indicando que este proceso agente ha iniciado y esta listo. *
  *             Se envia el nombre del agente y el pipe donde debe recibir las respuestas.                   *
@@ -37,12 +37,13 @@
  *  Parametros: nombre     : nombre unico del agente.                                                       *
  *              pipe_srv   : ruta del FIFO del controlador donde se envian mensajes.                        *
  *              pipe_resp  : ruta del FIFO donde este agente recibira respuestas.                           *
+ *              parque     : parque destino en un controlador multi-parque (-1 = no enviar el campo).       *
  *                                                                                                          *
  *  Retorno:    0 si el registro fue enviado correctamente.                                                 *
  *              -1 si ocurre un error al abrir o escribir en el pipe del controlador.                       *
  *                                                                                                          *
  ************************************************************************************************************/
-int registrar_agente(const char *nombre, const char *pipe_srv, const char *pipe_resp)
+int registrar_agente(const char *nombre, const char *pipe_srv, const char *pipe_resp, int parque)
 {
     int fd;
     char msg[MAXLINE];
@@ -55,7 +56,11 @@ int registrar_agente(const char *nombre, const char *pipe_srv, const char *pipe_
     }
 
     /* ---- Construir mensaje de registro ---- */
-    snprintf(msg, sizeof(msg), "REGISTRO;%s;%s\n", nombre, pipe_resp);
+    if (parque >= 0) {
+        snprintf(msg, sizeof(msg), "REGISTRO;%s;%s;%d\n", nombre, pipe_resp, parque);
+    } else {
+        snprintf(msg, sizeof(msg), "REGISTRO;%s;%s\n", nombre, pipe_resp);
+    }
 
     /* ---- Enviar registro ---- */
     write(fd, msg, strlen(msg));
@@ -69,7 +74,7 @@ int registrar_agente(const char *nombre, const char *pipe_srv, const char *pipe_
 /************************************************************************************************************
  *                                                                                                          *
  *  int enviar_solicitud(const char *familia, int personas, int hora_inicio,                                *
- *                       const char *pipe_srv, const char *pipe_resp);                                      *
+ *                       const char *pipe_srv, const char *pipe_resp, int parque);                          *
  *                                                                                                          *
  *  Proposito: Construir y enviar al controlador una solicitud de reserva.                                  *
  *             Cada solicitud incluye la familia, numero de personas, hora de inicio y hora de fin.         *
@@ -80,13 +85,16 @@ int registrar_agente(const char *nombre, const char *pipe_srv, const char *pipe_
  *              hora_inicio : hora de comienzo solicitada.                                                   *
  *              pipe_srv    : FIFO del controlador donde se escriben solicitudes.                           *
  *              pipe_resp   : FIFO del agente donde recibira la respuesta.                                  *
+ *              parque      : parque destino (-1 = no enviar el campo).                                     *
+ *              id          : identificador de la solicitud (-1 = no enviar el campo). Si se envia, el      *
+ *                            campo de parque tambien va (0 si parque es -1).                               *
  *                                                                                                          *
  *  Retorno:    0 si el mensaje fue enviado correctamente.                                                  *
  *              -1 si ocurre un error al abrir el pipe del controlador.                                     *
  *                                                                                                          *
  ************************************************************************************************************/
 int enviar_solicitud(const char *familia, int personas, int hora_inicio,
-                     const char *pipe_srv, const char *pipe_resp)
+                     const char *pipe_srv, const char *pipe_resp, int parque, long id)
 {
     int fd;
     char msg[MAXLINE];
@@ -102,9 +110,19 @@ int enviar_solicitud(const char *familia, int personas, int hora_inicio,
     int hora_fin = hora_inicio + 2;
 
     /* ---- Construccion del mensaje ---- */
-    snprintf(msg, sizeof(msg),
-             "SOLICITUD;%s;%d;%d;%d;%s\n",
-             familia, personas, hora_inicio, hora_fin, pipe_resp);
+    if (id >= 0) {
+        snprintf(msg, sizeof(msg),
+                 "SOLICITUD;%s;%d;%d;%d;%s;%d;%ld\n",
+                 familia, personas, hora_inicio, hora_fin, pipe_resp, (parque >= 0) ? parque : 0, id);
+    } else if (parque >= 0) {
+        snprintf(msg, sizeof(msg),
+                 "SOLICITUD;%s;%d;%d;%d;%s;%d\n",
+                 familia, personas, hora_inicio, hora_fin, pipe_resp, parque);
+    } else {
+        snprintf(msg, sizeof(msg),
+                 "SOLICITUD;%s;%d;%d;%d;%s\n",
+                 familia, personas, hora_inicio, hora_fin, pipe_resp);
+    }
 
     /* ---- Enviar mensaje ---- */
     write(fd, msg, strlen(msg));
@@ -114,3 +132,229 @@ int enviar_solicitud(const char *familia, int personas, int hora_inicio,
 
     return 0;
 }
+
+/************************************************************************************************************
+ *                                                                                                          *
+ *  int consultar_disponibilidad(const char *pipe_srv, const char *pipe_resp, int parque);                  *
+ *                                                                                                          *
+ *  Proposito: Pedir al controlador la instantanea de cupos libres. Es una consulta de solo lectura: el     *
+ *             controlador responde sin tomar el mutex del parque.                                          *
+ *                                                                                                          *
+ *  Retorno:    0 si la consulta fue enviada; -1 si no se pudo abrir el pipe del controlador.               *
+ *                                                                                                          *
+ ************************************************************************************************************/
+int consultar_disponibilidad(const char *pipe_srv, const char *pipe_resp, int parque)
+{
+    int fd;
+    char msg[MAXLINE];
+
+    fd = open(pipe_srv, O_WRONLY);
+    if (fd < 0) {
+        perror("open pipe controlador");
+        return -1;
+    }
+
+    if (parque >= 0) {
+        snprintf(msg, sizeof(msg), "DISPONIBILIDAD;%s;%d\n", pipe_resp, parque);
+    } else {
+        snprintf(msg, sizeof(msg), "DISPONIBILIDAD;%s\n", pipe_resp);
+    }
+
+    write(fd, msg, strlen(msg));
+    close(fd);
+
+    return 0;
+}
+
+/************************************************************************************************************
+ *                                                                                                          *
+ *  int enviar_cancelacion(const char *familia, const char *pipe_srv, const char *pipe_resp, int parque,    *
+ *                         long id);                                                                        *
+ *                                                                                                          *
+ *  Proposito: Pedir al controlador que cancele la reserva mas reciente de la familia que aun no empieza.   *
+ *             El cupo liberado puede promover solicitudes de la lista de espera.                           *
+ *                                                                                                          *
+ *  Retorno:    0 si la cancelacion fue enviada; -1 si no se pudo abrir el pipe del controlador.            *
+ *                                                                                                          *
+ ************************************************************************************************************/
+int enviar_cancelacion(const char *familia, const char *pipe_srv, const char *pipe_resp, int parque,
+                       long id)
+{
+    int fd;
+    char msg[MAXLINE];
+
+    fd = open(pipe_srv, O_WRONLY);
+    if (fd < 0) {
+        perror("open pipe controlador");
+        return -1;
+    }
+
+    if (id >= 0) {
+        snprintf(msg, sizeof(msg), "CANCELACION;%s;%s;%d;%ld\n", familia, pipe_resp,
+                 (parque >= 0) ? parque : 0, id);
+    } else if (parque >= 0) {
+        snprintf(msg, sizeof(msg), "CANCELACION;%s;%s;%d\n", familia, pipe_resp, parque);
+    } else {
+        snprintf(msg, sizeof(msg), "CANCELACION;%s;%s\n", familia, pipe_resp);
+    }
+
+    write(fd, msg, strlen(msg));
+    close(fd);
+
+    return 0;
+}
+
+/************************************************************************************************************
+ *                                                                                                          *
+ *  int es_aviso_espera(const char *respuesta);                                                             *
+ *                                                                                                          *
+ *  Proposito: Reconocer los avisos asincronos de la lista de espera ("PROMOVIDA: ..." y "VENCIDA: ..."),   *
+ *             que pueden llegar en cualquier momento y no responden a la ultima solicitud enviada.         *
+ *                                                                                                          *
+ ************************************************************************************************************/
+int es_aviso_espera(const char *respuesta)
+{
+    return strncmp(respuesta, "PROMOVIDA:", 10) == 0 || strncmp(respuesta, "VENCIDA:", 8) == 0;
+}
+
+/************************************************************************************************************
+ *                                                                                                          *
+ *  void lector_respuesta_inicializar(lector_respuesta_t *lector, int fd_resp);                             *
+ *                                                                                                          *
+ ************************************************************************************************************/
+void lector_respuesta_inicializar(lector_respuesta_t *lector, int fd_resp)
+{
+    lector->fd     = fd_resp;
+    lector->usados = 0;
+}
+
+/* ---- Sacar del buffer la primera linea completa, si la hay ---- */
+static int extraer_linea(lector_respuesta_t *lector, char *buffer, size_t tam)
+{
+    char *fin = memchr(lector->buffer, '\n', (size_t) lector->usados);
+    if (fin == NULL) {
+        return -1;
+    }
+
+    size_t largo = (size_t) (fin - lector->buffer);
+    size_t copia = (largo < tam - 1) ? largo : tam - 1;
+
+    memcpy(buffer, lector->buffer, copia);
+    buffer[copia] = '\0';
+
+    lector->usados -= (int) (largo + 1);
+    memmove(lector->buffer, fin + 1, (size_t) lector->usados);
+    return (int) copia;
+}
+
+/************************************************************************************************************
+ *                                                                                                          *
+ *  int leer_respuesta(lector_respuesta_t *lector, char *buffer, size_t tam, int timeout_ms);               *
+ *                                                                                                          *
+ *  Proposito: Entregar la siguiente respuesta del controlador. El controlador agrupa las respuestas de un  *
+ *             agente y las escribe juntas, cada una terminada en '\n', asi que un read() puede traer      *
+ *             varias (o una a medias): se entregan de a una y el resto queda en el lector. Solo cuando no  *
+ *             hay una linea completa se espera con poll(). El FIFO se mantiene abierto durante toda la     *
+ *             sesion, asi que nunca se bloquea en open() y la espera queda acotada por timeout_ms.         *
+ *                                                                                                          *
+ *  Parametros: lector     : lector del FIFO de respuesta del agente.                                       *
+ *              buffer     : destino de la respuesta (sin el '\n', terminada en '\0').                      *
+ *              tam        : tamaño del buffer.                                                             *
+ *              timeout_ms : espera maxima en milisegundos.                                                 *
+ *                                                                                                          *
+ *  Retorno:    Bytes de la respuesta, 0 si se agoto el tiempo, -1 ante error.                              *
+ *                                                                                                          *
+ ************************************************************************************************************/
+int leer_respuesta(lector_respuesta_t *lector, char *buffer, size_t tam, int timeout_ms)
+{
+    struct pollfd pfd;
+    ssize_t read_bytes;
+    int listo, largo;
+
+    pfd.fd     = lector->fd;
+    pfd.events = POLLIN;
+
+    for (;;) {
+        /* ---- Una respuesta ya recibida en una lectura anterior ---- */
+        largo = extraer_linea(lector, buffer, tam);
+        if (largo > 0) {
+            return largo;
+        }
+        if (largo == 0) {
+            continue;       /* linea vacia */
+        }
+
+        if (lector->usados >= (int) sizeof(lector->buffer)) {
+            fprintf(stderr, "Respuesta demasiado larga, descartada\n");
+            lector->usados = 0;
+        }
+
+        /* ---- Esperar datos como maximo timeout_ms ---- */
+        do {
+            listo = poll(&pfd, 1, timeout_ms);
+        } while (listo < 0 && errno == EINTR);
+
+        if (listo < 0) {
+            perror("poll respuesta");
+            return -1;
+        }
+        if (listo == 0) {
+            return 0;
+        }
+
+        read_bytes = read(lector->fd, lector->buffer + lector->usados,
+                          sizeof(lector->buffer) - (size_t) lector->usados);
+        if (read_bytes < 0) {
+            if (errno == EINTR) continue;
+            perror("read respuesta");
+            return -1;
+        }
+        lector->usados += (int) read_bytes;
+    }
+}
+
+/************************************************************************************************************
+ *                                                                                                          *
+ *  int calcular_espera_ms(int intento, int sugerida_ms);                                                   *
+ *                                                                                                          *
+ *  Proposito: Retroceso exponencial con "equal jitter": la mitad del tope es fija y la otra mitad          *
+ *             aleatoria, para que los agentes rechazados a la vez no reintenten todos juntos.              *
+ *                                                                                                          *
+ *  Retorno:   Milisegundos a esperar antes del siguiente intento.                                          *
+ *                                                                                                          *
+ ************************************************************************************************************/
+int calcular_espera_ms(int intento, int sugerida_ms)
+{
+    int tope = ESPERA_BASE_MS;
+    int i;
+
+    for (i = 0; i < intento && tope < ESPERA_MAXIMA_MS; i++) {
+        tope *= 2;
+    }
+    if (tope > ESPERA_MAXIMA_MS) {
+        tope = ESPERA_MAXIMA_MS;
+    }
+
+    int espera = tope / 2 + rand() % (tope / 2 + 1);
+
+    return (espera > sugerida_ms) ? espera : sugerida_ms;
+}
+
+/************************************************************************************************************
+ *                                                                                                          *
+ *  void dormir_ms(int ms);                                                                                 *
+ *                                                                                                          *
+ *  Proposito: Suspender el hilo ms milisegundos, reanudando si una señal interrumpe la espera.             *
+ *                                                                                                          *
+ ************************************************************************************************************/
+void dormir_ms(int ms)
+{
+    struct timespec espera, resto;
+
+    espera.tv_sec  = ms / 1000;
+    espera.tv_nsec = (long) (ms % 1000) * 1000000L;
+
+    while (nanosleep(&espera, &resto) == -1 && errno == EINTR) {
+        espera = resto;
+    }
+}
@@ -21,13 +21,31 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
 #include <sys/stat.h>
+#include <poll.h>
+#include <time.h>
+
+#include "../controlador/disponibilidad.h"
 
 /************************************************* Headers **************************************************/
 #include <stdio.h>
 
 #define MAXLINE 256   /* Tamaño maximo de buffer para mensajes */
 
+#define TIMEOUT_RESPUESTA_MS    5000    /* Espera maxima por una respuesta del controlador   */
+#define MAX_REINTENTOS          6       /* Reintentos ante respuestas "OCUPADO"              */
+#define ESPERA_BASE_MS          100     /* Base del retroceso exponencial                    */
+#define ESPERA_MAXIMA_MS        8000    /* Tope del retroceso exponencial                    */
+
+/* ---- FIFO de respuesta: el controlador agrupa varias respuestas en un solo write,
+ *      cada una terminada en '\n'; lo que sobra de un read() queda para el siguiente ---- */
+typedef struct {
+    int  fd;
+    char buffer[MAXLINE * 8];
+    int  usados;
+} lector_respuesta_t;
+
 /************************************************* Prototipos ************************************************/
 
 /*  
@@ -35,22 +53,67 @@
  * Envia al controlador un mensaje de registro con:
  *   - nombre del agente
  *   - pipe por donde recibira respuestas
+ *   - parque destino, si parque >= 0 (controlador multi-parque)
  */
-int registrar_agente(const char *nombre, const char *pipe_srv, const char *pipe_resp);
+int registrar_agente(const char *nombre, const char *pipe_srv, const char *pipe_resp, int parque);
 
 /*
  * enviar_solicitud()
  * Envia una solicitud de reserva en el formato:
- *   SOLICITUD;familia;personas;hora_inicio;hora_fin;pipe_respuesta
+ *   SOLICITUD;familia;personas;hora_inicio;hora_fin;pipe_respuesta[;parque[;id]]
+ * Con id >= 0 la respuesta llega como "#id texto\n" (ver lote.h).
  */
 int enviar_solicitud(const char *familia, int personas, int hora_inicio,
-                     const char *pipe_srv, const char *pipe_resp);
+                     const char *pipe_srv, const char *pipe_resp, int parque, long id);
+
+/*
+ * consultar_disponibilidad()
+ * Pide al controlador el cupo libre por hora:
+ *   DISPONIBILIDAD;pipe_respuesta[;parque]
+ */
+int consultar_disponibilidad(const char *pipe_srv, const char *pipe_resp, int parque);
+
+/*
+ * enviar_cancelacion()
+ * Cancela la reserva mas reciente de la familia que aun no empieza:
+ *   CANCELACION;familia;pipe_respuesta[;parque[;id]]
+ */
+int enviar_cancelacion(const char *familia, const char *pipe_srv, const char *pipe_resp, int parque,
+                       long id);
+
+/*
+ * es_aviso_espera()
+ * 1 si la respuesta es un aviso de la lista de espera (PROMOVIDA o VENCIDA).
+ */
+int es_aviso_espera(const char *respuesta);
+
+/*
+ * lector_respuesta_inicializar()
+ * Asocia el lector al FIFO de respuesta del agente (ya abierto).
+ */
+void lector_respuesta_inicializar(lector_respuesta_t *lector, int fd_resp);
 
 /*
  * leer_respuesta()
- * Lee la respuesta enviada por el Controlador desde el FIFO propio del agente.
+ * Entrega la siguiente respuesta del Controlador (una linea, sin el '\n').
+ * Si ya hay una completa en el buffer del lector no toca el FIFO; si no,
+ * espera a lo sumo timeout_ms milisegundos.
+ * Retorna los bytes de la respuesta, 0 si se agoto el tiempo o -1 ante error.
+ */
+int leer_respuesta(lector_respuesta_t *lector, char *buffer, size_t tam, int timeout_ms);
+
+/*
+ * calcular_espera_ms()
+ * Retroceso exponencial con jitter para el intento dado. Nunca es menor que
+ * la espera sugerida por el controlador en su respuesta "OCUPADO".
+ */
+int calcular_espera_ms(int intento, int sugerida_ms);
+
+/*
+ * dormir_ms()
+ * Suspende el hilo la cantidad de milisegundos indicada.
  */
-int leer_respuesta(const char *pipe_resp, char *buffer, size_t tam);
+void dormir_ms(int ms);
 
 /*
  * procesar_respuesta()
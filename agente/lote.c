@@ -0,0 +1,489 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 28/11/2025                                                                          *
+ *                                                                                                   *
+ * Archivo     : lote.c                                                                              *
+ *                                                                                                   *
+ * Descripcion : Modo lote del agente (ver lote.h): pool de hilos que procesa varios CSV con un solo *
+ *               registro, un hilo despachador que reparte las respuestas por identificador y el     *
+ *               resumen por archivo y total al terminar.                                            *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+/************************************************* Headers **************************************************/
+#include <dirent.h>
+
+#include "lote.h"
+
+/************************************************************************************************************
+ *  static uint64_t ahora_ns(void)                                                                          *
+ ************************************************************************************************************/
+static uint64_t ahora_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/************************************************************************************************************
+ *  static const char *nombre_base(const char *ruta)                                                        *
+ ************************************************************************************************************/
+static const char *nombre_base(const char *ruta)
+{
+    const char *barra = strrchr(ruta, '/');
+    return (barra != NULL) ? barra + 1 : ruta;
+}
+
+static int comparar_rutas(const void *a, const void *b)
+{
+    return strcmp(((const resumen_archivo_t *) a)->ruta, ((const resumen_archivo_t *) b)->ruta);
+}
+
+/************************************************************************************************************
+ *                                                                                                          *
+ *  int lote_agregar_ruta(resumen_archivo_t **archivos, int *num_archivos, const char *ruta);               *
+ *                                                                                                          *
+ *  Proposito: Agregar un CSV a la lista de archivos del lote. Si la ruta es un directorio se agregan sus   *
+ *             archivos .csv en orden alfabetico.                                                           *
+ *                                                                                                          *
+ *  Retorno:    0 si se agrego al menos un archivo; -1 ante error.                                          *
+ *                                                                                                          *
+ ************************************************************************************************************/
+int lote_agregar_ruta(resumen_archivo_t **archivos, int *num_archivos, const char *ruta)
+{
+    struct stat st;
+    int inicio = *num_archivos;
+
+    if (stat(ruta, &st) != 0) {
+        perror(ruta);
+        return -1;
+    }
+
+    if (*archivos == NULL) {
+        *archivos = calloc(MAX_ARCHIVOS_LOTE, sizeof(resumen_archivo_t));
+        if (*archivos == NULL) {
+            perror("calloc (archivos del lote)");
+            return -1;
+        }
+    }
+
+    if (!S_ISDIR(st.st_mode)) {
+        if (*num_archivos == MAX_ARCHIVOS_LOTE) {
+            fprintf(stderr, "Demasiados archivos (maximo %d)\n", MAX_ARCHIVOS_LOTE);
+            return -1;
+        }
+        snprintf((*archivos)[(*num_archivos)++].ruta, MAX_LONG_RUTA_LOTE, "%s", ruta);
+        return 0;
+    }
+
+    DIR *dir = opendir(ruta);
+    if (dir == NULL) {
+        perror(ruta);
+        return -1;
+    }
+
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        size_t largo = strlen(ent->d_name);
+
+        if (largo < 5 || strcmp(ent->d_name + largo - 4, ".csv") != 0) continue;
+
+        if (*num_archivos == MAX_ARCHIVOS_LOTE) {
+            fprintf(stderr, "Demasiados archivos (maximo %d)\n", MAX_ARCHIVOS_LOTE);
+            break;
+        }
+        snprintf((*archivos)[(*num_archivos)++].ruta, MAX_LONG_RUTA_LOTE, "%.127s/%.127s", ruta,
+                 ent->d_name);
+    }
+    closedir(dir);
+
+    qsort(*archivos + inicio, *num_archivos - inicio, sizeof(resumen_archivo_t), comparar_rutas);
+
+    if (*num_archivos == inicio) {
+        fprintf(stderr, "%s: no contiene archivos .csv\n", ruta);
+        return -1;
+    }
+    return 0;
+}
+
+/************************************************************************************************************
+ *  static void entregar_linea(lote_t *lote, const char *linea)                                             *
+ *                                                                                                          *
+ *  Proposito: Entregar una linea del FIFO de respuesta al hilo que espera su identificador. Las lineas     *
+ *             sin identificador son avisos de la lista de espera.                                          *
+ ************************************************************************************************************/
+static void entregar_linea(lote_t *lote, const char *linea)
+{
+    char *resto;
+    int   i;
+
+    if (linea[0] != '#') {
+        pthread_mutex_lock(&lote->mutex);
+        lote->avisos++;
+        pthread_mutex_unlock(&lote->mutex);
+        printf("Agente %s recibió aviso: %s\n", lote->nombre, linea);
+        return;
+    }
+
+    long id = strtol(linea + 1, &resto, 10);
+    if (*resto == ' ') resto++;
+
+    pthread_mutex_lock(&lote->mutex);
+    for (i = 0; i < lote->num_hilos; i++) {
+        pendiente_lote_t *p = &lote->pendientes[i];
+
+        if (p->esperando && !p->lista && p->id == id) {
+            snprintf(p->texto, sizeof(p->texto), "%s", resto);
+            p->lista = 1;
+            pthread_cond_signal(&p->cond);
+            break;
+        }
+    }
+    if (i == lote->num_hilos) {
+        lote->tardias++;
+    }
+    pthread_mutex_unlock(&lote->mutex);
+
+    if (i == lote->num_hilos) {
+        printf("Agente %s recibió respuesta tardía: %s\n", lote->nombre, resto);
+    }
+}
+
+/************************************************************************************************************
+ *  static void *hilo_despachador(void *arg)                                                                *
+ *                                                                                                          *
+ *  Proposito: Leer el FIFO de respuesta del agente y separarlo en lineas. Varias respuestas pueden llegar  *
+ *             en un mismo read(); el resto incompleto se conserva para la siguiente lectura.               *
+ ************************************************************************************************************/
+static void *hilo_despachador(void *arg)
+{
+    lote_t *lote = (lote_t *) arg;
+    char    buffer[MAXLINE * 8];
+    int     usados = 0;
+
+    while (atomic_load(&lote->activo)) {
+        struct pollfd pfd = { .fd = lote->fd_resp, .events = POLLIN };
+
+        /* ---- Despertar periodicamente para notar el fin del lote ---- */
+        if (poll(&pfd, 1, 100) <= 0) continue;
+
+        ssize_t n = read(lote->fd_resp, buffer + usados, sizeof(buffer) - 1 - usados);
+        if (n <= 0) continue;
+
+        usados += (int) n;
+        buffer[usados] = '\0';
+
+        char *inicio = buffer, *fin;
+        while ((fin = strchr(inicio, '\n')) != NULL) {
+            *fin = '\0';
+            if (fin > inicio) entregar_linea(lote, inicio);
+            inicio = fin + 1;
+        }
+
+        usados -= (int) (inicio - buffer);
+        memmove(buffer, inicio, usados);
+
+        if (usados >= (int) sizeof(buffer) - 1) {
+            fprintf(stderr, "Agente %s: respuesta demasiado larga, descartada\n", lote->nombre);
+            usados = 0;
+        }
+    }
+
+    return NULL;
+}
+
+/************************************************************************************************************
+ *  static int esperar_respuesta(lote_t *lote, pendiente_lote_t *p, char *texto, size_t tam)                *
+ *                                                                                                          *
+ *  Proposito: Esperar a lo sumo timeout_ms la respuesta de la solicitud en vuelo del hilo. Al volver la    *
+ *             solicitud deja de estar pendiente: una respuesta posterior se cuenta como tardia.            *
+ *                                                                                                          *
+ *  Retorno:    1 si llego la respuesta; 0 si se agoto el tiempo.                                           *
+ ************************************************************************************************************/
+static int esperar_respuesta(lote_t *lote, pendiente_lote_t *p, char *texto, size_t tam)
+{
+    struct timespec limite;
+    int ok;
+
+    clock_gettime(CLOCK_MONOTONIC, &limite);
+    limite.tv_sec  += lote->timeout_ms / 1000;
+    limite.tv_nsec += (long) (lote->timeout_ms % 1000) * 1000000L;
+    if (limite.tv_nsec >= 1000000000L) {
+        limite.tv_sec++;
+        limite.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&lote->mutex);
+    while (!p->lista) {
+        if (pthread_cond_timedwait(&p->cond, &lote->mutex, &limite) == ETIMEDOUT) break;
+    }
+    ok = p->lista;
+    if (ok) {
+        snprintf(texto, tam, "%s", p->texto);
+    }
+    p->esperando = 0;
+    pthread_mutex_unlock(&lote->mutex);
+
+    return ok;
+}
+
+/************************************************************************************************************
+ *  static void procesar_archivo(lote_t *lote, int hilo, resumen_archivo_t *r)                              *
+ *                                                                                                          *
+ *  Proposito: Enviar en orden las solicitudes de un CSV, con la misma logica que el agente de un solo      *
+ *             archivo: horas pasadas se omiten, "Familia,CANCELAR" cancela y OCUPADO se reintenta.         *
+ ************************************************************************************************************/
+static void procesar_archivo(lote_t *lote, int hilo, resumen_archivo_t *r)
+{
+    pendiente_lote_t *p = &lote->pendientes[hilo];
+    const char *archivo = nombre_base(r->ruta);
+    char linea[MAXLINE], familia[64], accion[16], texto[MAXLINE];
+    int  hora = 0, personas = 0, parque_linea;
+    uint64_t t_inicio = ahora_ns();
+
+    FILE *fp = fopen(r->ruta, "r");
+    if (fp == NULL) {
+        perror(r->ruta);
+        return;
+    }
+
+    while (fgets(linea, sizeof(linea), fp)) {
+        int cancelar = 0;
+
+        if (sscanf(linea, "%63[^,],%15[^,\r\n]", familia, accion) == 2 &&
+            strcmp(accion, "CANCELAR") == 0) {
+            cancelar = 1;
+            if (sscanf(linea, "%*[^,],%*[^,],%d", &parque_linea) != 1) {
+                parque_linea = lote->parque;
+            }
+        } else {
+            int campos = sscanf(linea, "%63[^,],%d,%d,%d", familia, &hora, &personas, &parque_linea);
+            if (campos < 3) continue;
+            if (campos == 3) parque_linea = lote->parque;
+
+            if (hora < lote->hora_actual) {
+                r->omitidas++;
+                continue;
+            }
+        }
+
+        r->solicitudes++;
+
+        int intento;
+        for (intento = 0; intento <= MAX_REINTENTOS; intento++) {
+            long id = atomic_fetch_add(&lote->siguiente_id, 1);
+            int  enviado;
+
+            /* ---- Anotar la espera antes de enviar: la respuesta puede llegar enseguida ---- */
+            pthread_mutex_lock(&lote->mutex);
+            p->id        = id;
+            p->lista     = 0;
+            p->esperando = 1;
+            pthread_mutex_unlock(&lote->mutex);
+
+            uint64_t t_envio = ahora_ns();
+            if (cancelar) {
+                enviado = enviar_cancelacion(familia, lote->pipe_srv, lote->pipe_resp, parque_linea, id);
+            } else {
+                enviado = enviar_solicitud(familia, personas, hora, lote->pipe_srv, lote->pipe_resp,
+                                           parque_linea, id);
+            }
+
+            if (enviado < 0) {
+                pthread_mutex_lock(&lote->mutex);
+                p->esperando = 0;
+                pthread_mutex_unlock(&lote->mutex);
+                r->sin_respuesta++;
+                break;
+            }
+
+            if (!esperar_respuesta(lote, p, texto, sizeof(texto))) {
+                printf("Agente %s [%s] sin respuesta para %s tras %d ms\n",
+                       lote->nombre, archivo, familia, lote->timeout_ms);
+                r->sin_respuesta++;
+                break;
+            }
+            r->latencia_ns += ahora_ns() - t_envio;
+
+            /* ---- Controlador sobrecargado: retroceso exponencial con jitter y reintento ---- */
+            if (strncmp(texto, "OCUPADO", 7) == 0) {
+                int sugerida = 0;
+                sscanf(texto, "OCUPADO: reintentar en %d ms", &sugerida);
+                r->ocupado++;
+
+                if (intento == MAX_REINTENTOS) {
+                    printf("Agente %s [%s] abandona solicitud de %s tras %d reintentos\n",
+                           lote->nombre, archivo, familia, MAX_REINTENTOS);
+                    break;
+                }
+                dormir_ms(calcular_espera_ms(intento, sugerida));
+                continue;
+            }
+
+            if      (strncmp(texto, "RESERVA OK", 10) == 0)   r->aceptadas++;
+            else if (strncmp(texto, "REPROGRAMADA", 12) == 0) r->reprogramadas++;
+            else if (strncmp(texto, "CANCELADA", 9) == 0)     r->canceladas++;
+            else                                              r->negadas++;
+
+            printf("Agente %s [%s] recibió respuesta: %s\n", lote->nombre, archivo, texto);
+            break;
+        }
+
+        if (lote->pausa_ms > 0) {
+            dormir_ms(lote->pausa_ms);
+        }
+    }
+
+    fclose(fp);
+    r->segundos = (double) (ahora_ns() - t_inicio) / 1e9;
+}
+
+/************************************************************************************************************
+ *  static void *hilo_trabajador(void *arg)                                                                 *
+ *                                                                                                          *
+ *  Proposito: Tomar archivos de la lista hasta que no quede ninguno.                                       *
+ ************************************************************************************************************/
+typedef struct {
+    lote_t *lote;
+    int     hilo;
+} arg_trabajador_t;
+
+static void *hilo_trabajador(void *arg)
+{
+    arg_trabajador_t *a = (arg_trabajador_t *) arg;
+    int idx;
+
+    while ((idx = atomic_fetch_add(&a->lote->siguiente_archivo, 1)) < a->lote->num_archivos) {
+        procesar_archivo(a->lote, a->hilo, &a->lote->archivos[idx]);
+    }
+
+    return NULL;
+}
+
+/************************************************************************************************************
+ *                                                                                                          *
+ *  int lote_ejecutar(lote_t *lote);                                                                        *
+ *                                                                                                          *
+ *  Proposito: Lanzar el despachador y el pool, esperar a que se procesen todos los archivos y detener el   *
+ *             despachador. El agente ya debe estar registrado (hora_actual) y con fd_resp abierto.         *
+ *                                                                                                          *
+ *  Retorno:    0 si se procesaron los archivos; -1 si no se pudo crear ningun hilo.                        *
+ *                                                                                                          *
+ ************************************************************************************************************/
+int lote_ejecutar(lote_t *lote)
+{
+    pthread_t          hilos[MAX_HILOS_LOTE], despachador;
+    arg_trabajador_t   args[MAX_HILOS_LOTE];
+    pthread_condattr_t attr;
+    int i, creados = 0;
+
+    if (lote->num_hilos > MAX_HILOS_LOTE)    lote->num_hilos = MAX_HILOS_LOTE;
+    if (lote->num_hilos > lote->num_archivos) lote->num_hilos = lote->num_archivos;
+    if (lote->num_hilos < 1)                  lote->num_hilos = 1;
+
+    atomic_init(&lote->siguiente_archivo, 0);
+    atomic_init(&lote->siguiente_id, 1);
+    atomic_init(&lote->activo, 1);
+    lote->tardias = 0;
+    lote->avisos  = 0;
+
+    pthread_mutex_init(&lote->mutex, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    for (i = 0; i < lote->num_hilos; i++) {
+        memset(&lote->pendientes[i], 0, sizeof(lote->pendientes[i]));
+        pthread_cond_init(&lote->pendientes[i].cond, &attr);
+    }
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&despachador, NULL, hilo_despachador, lote) != 0) {
+        perror("pthread_create (despachador)");
+        return -1;
+    }
+
+    uint64_t t_inicio = ahora_ns();
+
+    for (i = 0; i < lote->num_hilos; i++) {
+        args[i].lote = lote;
+        args[i].hilo = i;
+        if (pthread_create(&hilos[i], NULL, hilo_trabajador, &args[i]) != 0) {
+            perror("pthread_create (pool del agente)");
+            break;
+        }
+        creados++;
+    }
+
+    for (i = 0; i < creados; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    lote->segundos = (double) (ahora_ns() - t_inicio) / 1e9;
+
+    atomic_store(&lote->activo, 0);
+    pthread_join(despachador, NULL);
+
+    for (i = 0; i < lote->num_hilos; i++) {
+        pthread_cond_destroy(&lote->pendientes[i].cond);
+    }
+    pthread_mutex_destroy(&lote->mutex);
+
+    return (creados > 0) ? 0 : -1;
+}
+
+/************************************************************************************************************
+ *                                                                                                          *
+ *  void lote_escribir_resumen(const lote_t *lote, FILE *fp);                                              *
+ *                                                                                                          *
+ *  Proposito: Escribir una linea por archivo y el total: resultados, solicitudes por segundo y latencia    *
+ *             media envio -> respuesta (incluye las respuestas OCUPADO).                                   *
+ *                                                                                                          *
+ ************************************************************************************************************/
+static void escribir_fila(FILE *fp, const char *nombre, const resumen_archivo_t *r, double segundos)
+{
+    int respondidas = r->aceptadas + r->reprogramadas + r->negadas + r->canceladas + r->ocupado;
+
+    fprintf(fp, "%-28.28s %6d %6d %6d %6d %6d %6d %6d %6d %8.2f %8.2f %8.3f\n",
+            nombre, r->solicitudes, r->aceptadas, r->reprogramadas, r->negadas, r->canceladas,
+            r->ocupado, r->sin_respuesta, r->omitidas, segundos,
+            (segundos > 0) ? r->solicitudes / segundos : 0.0,
+            (respondidas > 0) ? (double) r->latencia_ns / respondidas / 1e6 : 0.0);
+}
+
+void lote_escribir_resumen(const lote_t *lote, FILE *fp)
+{
+    resumen_archivo_t total;
+    int i;
+
+    memset(&total, 0, sizeof(total));
+
+    fprintf(fp, "================ RESUMEN DEL AGENTE %s (modo lote) ================\n\n", lote->nombre);
+    fprintf(fp, "Archivos: %d   Hilos: %d   Tiempo total: %.2f s\n\n",
+            lote->num_archivos, lote->num_hilos, lote->segundos);
+    fprintf(fp, "%-28s %6s %6s %6s %6s %6s %6s %6s %6s %8s %8s %8s\n",
+            "archivo", "solic", "acept", "reprog", "negad", "cancel", "ocup", "sinres", "omit",
+            "seg", "sol/s", "lat_ms");
+
+    for (i = 0; i < lote->num_archivos; i++) {
+        const resumen_archivo_t *r = &lote->archivos[i];
+
+        escribir_fila(fp, nombre_base(r->ruta), r, r->segundos);
+
+        total.solicitudes   += r->solicitudes;
+        total.aceptadas     += r->aceptadas;
+        total.reprogramadas += r->reprogramadas;
+        total.negadas       += r->negadas;
+        total.canceladas    += r->canceladas;
+        total.ocupado       += r->ocupado;
+        total.sin_respuesta += r->sin_respuesta;
+        total.omitidas      += r->omitidas;
+        total.latencia_ns   += r->latencia_ns;
+    }
+
+    fprintf(fp, "\n");
+    escribir_fila(fp, "TOTAL", &total, lote->segundos);
+    fprintf(fp, "\nRespuestas tardias: %d   Avisos de lista de espera: %d\n", lote->tardias, lote->avisos);
+}
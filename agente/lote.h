@@ -0,0 +1,98 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 28/11/2025                                                                          *
+ *                                                                                                   *
+ * Archivo     : lote.h                                                                              *
+ *                                                                                                   *
+ * Descripcion : Modo lote del agente: varios CSV (o un directorio) procesados por un pool de hilos  *
+ *               con un solo registro y un solo FIFO de respuesta. Cada solicitud lleva un           *
+ *               identificador despues del campo de parque; el controlador responde "#id texto\n" y  *
+ *               un hilo despachador lee el FIFO, separa las lineas y entrega cada respuesta al hilo *
+ *               que la espera. Las lineas sin '#' son avisos de la lista de espera.                 *
+ *                                                                                                   *
+ *               Cada hilo toma el siguiente archivo libre y lo procesa en orden, igual que el       *
+ *               agente de un solo archivo, con a lo sumo una solicitud en vuelo por hilo.           *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __LOTE_H__
+#define __LOTE_H__
+
+/************************************************* Headers **************************************************/
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "agente.h"
+
+#define MAX_ARCHIVOS_LOTE       1024
+#define MAX_HILOS_LOTE          64
+#define HILOS_LOTE_DEFECTO      4
+#define PAUSA_LOTE_DEFECTO_MS   2000    /* Pausa entre solicitudes de un mismo archivo          */
+#define MAX_LONG_RUTA_LOTE      256
+
+#define ARCHIVO_RESUMEN_LOTE    "resumen_lote.txt"     /* Se antepone "<nombreAgente>_"          */
+
+/* ---- Resultados de un archivo (los escribe solo el hilo que lo procesa) ---- */
+typedef struct {
+    char     ruta[MAX_LONG_RUTA_LOTE];
+    int      solicitudes;
+    int      aceptadas;
+    int      reprogramadas;
+    int      negadas;
+    int      canceladas;
+    int      ocupado;               /* Respuestas OCUPADO (cada una genera un reintento)    */
+    int      sin_respuesta;
+    int      omitidas;              /* Horas ya pasadas al registrarse                      */
+    uint64_t latencia_ns;           /* Suma envio -> respuesta de las respondidas           */
+    double   segundos;
+} resumen_archivo_t;
+
+/* ---- Solicitud en vuelo de un hilo del pool ---- */
+typedef struct {
+    int            esperando;
+    long           id;
+    int            lista;
+    char           texto[MAXLINE];
+    pthread_cond_t cond;
+} pendiente_lote_t;
+
+/* ---- Estado del agente en modo lote ---- */
+typedef struct {
+    const char *nombre;
+    const char *pipe_srv;
+    const char *pipe_resp;
+    int         fd_resp;
+    int         parque;
+    int         timeout_ms;
+    int         pausa_ms;
+    int         hora_actual;
+    int         num_hilos;
+
+    resumen_archivo_t *archivos;
+    int                num_archivos;
+    atomic_int         siguiente_archivo;
+    atomic_long        siguiente_id;
+
+    /* ---- Demultiplexado de respuestas (protegido por mutex) ---- */
+    pthread_mutex_t  mutex;
+    pendiente_lote_t pendientes[MAX_HILOS_LOTE];
+    int              tardias;       /* Respuestas cuyo hilo ya no las esperaba              */
+    int              avisos;        /* PROMOVIDA / VENCIDA                                  */
+
+    atomic_int activo;              /* 0 = el despachador debe terminar                     */
+    double     segundos;            /* Desde el arranque del pool hasta el ultimo archivo   */
+} lote_t;
+
+/************************************************* Prototipos ************************************************/
+
+int  lote_agregar_ruta(resumen_archivo_t **archivos, int *num_archivos, const char *ruta);
+
+int  lote_ejecutar(lote_t *lote);
+void lote_escribir_resumen(const lote_t *lote, FILE *fp);
+
+#endif /* __LOTE_H__ */
@@ -19,16 +19,34 @@
  *   Linux/macOS:          gcc agente.c agente_main.c -o agente                                              *
  *                                                                                                           *
  * HOW TO RUN THE PROGRAM:                                                                                   *
- *   Linux/macOS:          ./agente -s nombreAgente -a archivo.csv -p /tmp/fifo_controlador                  *
+ *   Linux/macOS:          ./agente -s nombreAgente -a archivo.csv -p /tmp/fifo_controlador [-t ms] [-q n]  *
+ *                                  [-d | -k /memoriaDisponibilidad]                                         *
+ *   Modo lote:            ./agente -s nombreAgente -a dir_o_csv [-a otro.csv ...] -p /tmp/fifo_controlador  *
+ *                                  [-n hilos] [-z pausaMs] [-t ms] [-q n]                                   *
  *                                                                                                           *
  * NOTAS DE USO:                                                                                             *
  *   - El proceso CONTROLADOR debe estar ejecutándose y haber creado el FIFO de entrada indicado en -p.      *
  *   - Cada agente crea su propio FIFO de respuesta en /tmp/resp_<nombreAgente>.                             *
  *   - El controlador envía al registrarse la hora actual de simulación.                                     *
  *   - El agente lee solicitudes del CSV y las envía si la hora >= hora_actual de simulación.                *
+ *   - Cada respuesta se espera a lo sumo -t milisegundos; ante "OCUPADO" se reintenta con retroceso         *
+ *     exponencial y jitter.                                                                                 *
+ *   - Con -q (o una cuarta columna en el CSV) se indica el parque destino en un controlador multi-parque.   *
+ *   - Con -d el agente consulta la disponibilidad antes de cada solicitud (con -k la lee de la memoria      *
+ *     compartida del controlador) y no envia las que no caben en ningun bloque.                             *
+ *   - Una linea "Familia,CANCELAR[,parque]" cancela la reserva pendiente de la familia. Los avisos de la    *
+ *     lista de espera (PROMOVIDA / VENCIDA) se muestran apenas llegan.                                      *
+ *   - Con varios -a, un directorio o -n, los archivos se procesan en paralelo con un pool de hilos que       *
+ *     comparte el registro y el FIFO de respuesta (ver lote.h); al terminar se escribe                       *
+ *     <nombreAgente>_resumen_lote.txt.                                                                       *
  *************************************************************************************************************/
 
 #include "agente.h"
+#include "lote.h"
+
+#define USO_AGENTE \
+    "Uso: %s -s nombre -a archivo -p pipeSrv [-t timeoutMs] [-q parque] [-d | -k memoria]\n" \
+    "     %s -s nombre -a dir_o_csv [-a ...] -p pipeSrv [-n hilos] [-z pausaMs] [-t timeoutMs] [-q parque]\n"
 
 /************************************************************************************************************
  *  int main(int argc, char *argv[])                                                                        *
@@ -46,72 +64,181 @@ int main(int argc, char *argv[])
     char archivo[128]    = "";
     char pipe_srv[128]   = "";
     char pipe_resp[128];      /* FIFO de respuesta: /tmp/resp_<nombre> */
+    int  timeout_ms      = TIMEOUT_RESPUESTA_MS;
+    int  parque          = -1;    /* -1: controlador de un solo parque */
+    int  consultar       = 0;     /* -d: consultar disponibilidad antes de cada solicitud */
+    char memoria[MAX_LONG_NOMBRE_MEMORIA] = "";
+
+    /* ---- Modo lote: varios archivos con un pool de hilos ---- */
+    const char *rutas[MAX_ARCHIVOS_LOTE];
+    int  num_rutas = 0;
+    int  hilos     = 0;
+    int  pausa_ms  = PAUSA_LOTE_DEFECTO_MS;
 
     /* --------------------- PARSEO DE ARGUMENTOS --------------------- */
     int opt;
-    while ((opt = getopt(argc, argv, "s:a:p:")) != -1) {
+    while ((opt = getopt(argc, argv, "s:a:p:t:q:dk:n:z:")) != -1) {
         switch (opt) {
         case 's':
             strcpy(nombre, optarg);
             break;
         case 'a':
-            strcpy(archivo, optarg);
+            strncpy(archivo, optarg, sizeof(archivo) - 1);
+            if (num_rutas < MAX_ARCHIVOS_LOTE) {
+                rutas[num_rutas++] = optarg;
+            }
             break;
         case 'p':
             strcpy(pipe_srv, optarg);
             break;
+        case 't':
+            timeout_ms = atoi(optarg);
+            break;
+        case 'q':
+            parque = atoi(optarg);
+            break;
+        case 'd':
+            consultar = 1;
+            break;
+        case 'k':
+            strncpy(memoria, optarg, sizeof(memoria) - 1);
+            consultar = 1;
+            break;
+        case 'n':
+            hilos = atoi(optarg);
+            break;
+        case 'z':
+            pausa_ms = atoi(optarg);
+            break;
         default:
-            fprintf(stderr, "Uso: %s -s nombre -a archivo -p pipeSrv\n", argv[0]);
+            fprintf(stderr, USO_AGENTE, argv[0], argv[0]);
             exit(1);
         }
     }
 
-    if (nombre[0] == '\0' || archivo[0] == '\0' || pipe_srv[0] == '\0') {
-        fprintf(stderr, "Faltan parámetros. Uso: %s -s nombre -a archivo -p pipeSrv\n", argv[0]);
+    if (nombre[0] == '\0' || archivo[0] == '\0' || pipe_srv[0] == '\0' || timeout_ms <= 0 ||
+        hilos < 0 || pausa_ms < 0) {
+        fprintf(stderr, "Faltan parámetros. ");
+        fprintf(stderr, USO_AGENTE, argv[0], argv[0]);
         exit(1);
     }
 
+    /* ---- Modo lote si hay varios archivos, un directorio o un numero de hilos ---- */
+    struct stat st_archivo;
+    int lote_activo = num_rutas > 1 || hilos > 0 ||
+                      (stat(archivo, &st_archivo) == 0 && S_ISDIR(st_archivo.st_mode));
+    lote_t lote;
+
+    if (lote_activo) {
+        if (consultar) {
+            fprintf(stderr, "Agente %s: -d y -k no estan disponibles en modo lote.\n", nombre);
+            exit(1);
+        }
+
+        memset(&lote, 0, sizeof(lote));
+        for (int i = 0; i < num_rutas; i++) {
+            if (lote_agregar_ruta(&lote.archivos, &lote.num_archivos, rutas[i]) != 0) {
+                free(lote.archivos);
+                exit(1);
+            }
+        }
+    }
+
     /* ------------------ CREAR PIPE DE RESPUESTA ------------------ */
     snprintf(pipe_resp, sizeof(pipe_resp), "/tmp/resp_%s", nombre);
     mkfifo(pipe_resp, 0666);
 
-    /* ------------------ REGISTRO CON EL CONTROLADOR ------------------ */
-    if (registrar_agente(nombre, pipe_srv, pipe_resp) < 0) {
-        fprintf(stderr, "No se pudo registrar el agente.\n");
+    /* ---- Mantener el FIFO abierto toda la sesion (O_RDWR no bloquea en open)
+     *      para que el controlador siempre encuentre lector y las lecturas
+     *      puedan acotarse con poll() ---- */
+    int fd_resp = open(pipe_resp, O_RDWR);
+    if (fd_resp < 0) {
+        perror("open pipe respuesta");
         unlink(pipe_resp);
         exit(1);
     }
 
-    /* ---- Leer hora enviada por el controlador (una vez) ---- */
-    int fd_resp = open(pipe_resp, O_RDONLY);
-    if (fd_resp < 0) {
-        perror("open pipe respuesta");
+    lector_respuesta_t lector_resp;
+    lector_respuesta_inicializar(&lector_resp, fd_resp);
+
+    srand((unsigned) (time(NULL) ^ getpid()));
+
+    /* ---- Instantanea de disponibilidad en memoria compartida (solo lectura) ---- */
+    const instantanea_disponibilidad_t *inst_memoria = NULL;
+    if (memoria[0] != '\0') {
+        inst_memoria = disponibilidad_abrir_memoria(memoria);
+        if (inst_memoria == NULL) {
+            fprintf(stderr, "Agente %s: se consultara la disponibilidad por el FIFO.\n", nombre);
+        }
+    }
+
+    /* ------------------ REGISTRO CON EL CONTROLADOR ------------------ */
+    if (registrar_agente(nombre, pipe_srv, pipe_resp, parque) < 0) {
+        fprintf(stderr, "No se pudo registrar el agente.\n");
+        close(fd_resp);
         unlink(pipe_resp);
         exit(1);
     }
 
+    /* ---- Leer hora enviada por el controlador (una vez) ---- */
     char buffer[MAXLINE];
     int  hora_actual = 0;
-    ssize_t read_bytes;
+    int  read_bytes;
 
-    read_bytes = read(fd_resp, buffer, sizeof(buffer) - 1);
+    read_bytes = leer_respuesta(&lector_resp, buffer, sizeof(buffer), timeout_ms);
     if (read_bytes > 0) {
-        buffer[read_bytes] = '\0';   /* patrón cliente FIFO: usar read_bytes y terminar en '\0' */
         hora_actual = atoi(buffer);
         printf("Agente %s registrado. Hora actual = %d\n", nombre, hora_actual);
-    } else if (read_bytes < 0) {
-        perror("read hora_actual");
+    } else {
+        if (read_bytes == 0) {
+            fprintf(stderr, "Agente %s: el controlador no respondio al registro en %d ms\n",
+                    nombre, timeout_ms);
+        }
         close(fd_resp);
         unlink(pipe_resp);
         exit(1);
     }
 
-    close(fd_resp);
+    /* ------------------ MODO LOTE ------------------ */
+    if (lote_activo) {
+        char ruta_resumen[128];
+
+        lote.nombre      = nombre;
+        lote.pipe_srv    = pipe_srv;
+        lote.pipe_resp   = pipe_resp;
+        lote.fd_resp     = fd_resp;
+        lote.parque      = parque;
+        lote.timeout_ms  = timeout_ms;
+        lote.pausa_ms    = pausa_ms;
+        lote.hora_actual = hora_actual;
+        lote.num_hilos   = (hilos > 0) ? hilos : HILOS_LOTE_DEFECTO;
+
+        int r = lote_ejecutar(&lote);
+
+        if (r == 0) {
+            FILE *fp_res;
+
+            snprintf(ruta_resumen, sizeof(ruta_resumen), "%s_%s", nombre, ARCHIVO_RESUMEN_LOTE);
+            lote_escribir_resumen(&lote, stdout);
+            if ((fp_res = fopen(ruta_resumen, "w")) != NULL) {
+                lote_escribir_resumen(&lote, fp_res);
+                fclose(fp_res);
+                printf("Resumen escrito en '%s'.\n", ruta_resumen);
+            }
+        }
+
+        printf("Agente %s termina.\n", nombre);
+        free(lote.archivos);
+        close(fd_resp);
+        unlink(pipe_resp);
+        return (r == 0) ? 0 : 1;
+    }
 
     /* ------------------ ABRIR ARCHIVO CSV ------------------ */
     FILE *fp = fopen(archivo, "r");
     if (!fp) {
         perror("fopen archivo solicitudes");
+        close(fd_resp);
         unlink(pipe_resp);
         exit(1);
     }
@@ -119,14 +246,45 @@ int main(int argc, char *argv[])
     /* ------------------ BUCLE PRINCIPAL ------------------ */
     char linea[MAXLINE];
     char familia[64];
-    int  hora, personas;
+    char accion[16];
+    int  hora, personas, parque_linea;
 
     while (fgets(linea, sizeof(linea), fp)) {
 
-        if (sscanf(linea, "%[^,],%d,%d", familia, &hora, &personas) != 3) {
+        /* ---- Cancelacion: "Familia,CANCELAR[,parque]" ---- */
+        if (sscanf(linea, "%63[^,],%15[^,\r\n]", familia, accion) == 2 &&
+            strcmp(accion, "CANCELAR") == 0) {
+            if (sscanf(linea, "%*[^,],%*[^,],%d", &parque_linea) != 1) {
+                parque_linea = parque;
+            }
+
+            while (leer_respuesta(&lector_resp, buffer, sizeof(buffer), 0) > 0) {
+                printf("Agente %s recibió %s: %s\n", nombre,
+                       es_aviso_espera(buffer) ? "aviso" : "respuesta tardía", buffer);
+            }
+            if (enviar_cancelacion(familia, pipe_srv, pipe_resp, parque_linea, -1) == 0) {
+                do {
+                    read_bytes = leer_respuesta(&lector_resp, buffer, sizeof(buffer), timeout_ms);
+                    if (read_bytes > 0) {
+                        printf("Agente %s recibió %s: %s\n", nombre,
+                               es_aviso_espera(buffer) ? "aviso" : "respuesta", buffer);
+                    }
+                } while (read_bytes > 0 && es_aviso_espera(buffer));
+            }
+
+            sleep(2);
             continue;
         }
 
+        /* ---- Cuarta columna opcional: parque de esta solicitud ---- */
+        int campos = sscanf(linea, "%[^,],%d,%d,%d", familia, &hora, &personas, &parque_linea);
+        if (campos < 3) {
+            continue;
+        }
+        if (campos == 3) {
+            parque_linea = parque;
+        }
+
         /* ---- Ignora solicitudes en horas ya pasadas ---- */
         if (hora < hora_actual) {
             printf("Agente %s IGNORA solicitud (%s %d) porque hora < hora_sim (%d)\n",
@@ -134,26 +292,90 @@ int main(int argc, char *argv[])
             continue;
         }
 
-        /* ---- Enviar solicitud al Controlador ---- */
-        enviar_solicitud(familia, personas, hora, pipe_srv, pipe_resp);
+        /* ---- Consultar el cupo libre y no enviar solicitudes que no caben en ningun bloque ---- */
+        if (consultar) {
+            vista_disponibilidad_t vista;
+            int vista_ok = -1;
 
-        /* ---- Esperar respuesta en el FIFO de respuesta ---- */
-        fd_resp = open(pipe_resp, O_RDONLY);
-        if (fd_resp < 0) {
-            perror("open pipe respuesta");
-            break;
+            if (inst_memoria != NULL) {
+                /* Si no se logra una lectura consistente, la solicitud se envia sin filtrar */
+                vista_ok = disponibilidad_leer(inst_memoria, &vista);
+            } else {
+                while (leer_respuesta(&lector_resp, buffer, sizeof(buffer), 0) > 0) {
+                    printf("Agente %s recibió respuesta tardía: %s\n", nombre, buffer);
+                }
+                if (consultar_disponibilidad(pipe_srv, pipe_resp, parque_linea) == 0 &&
+                    leer_respuesta(&lector_resp, buffer, sizeof(buffer), timeout_ms) > 0) {
+                    vista_ok = disponibilidad_interpretar(buffer, &vista);
+                }
+            }
+
+            if (vista_ok == 0) {
+                int h_libre = disponibilidad_primer_bloque(&vista, hora, personas);
+
+                if (h_libre == -1) {
+                    printf("Agente %s omite %s (%d p): sin cupo segun la disponibilidad\n",
+                           nombre, familia, personas);
+                    continue;
+                }
+                if (h_libre != hora) {
+                    printf("Agente %s: %s no cabe a las %d:00, primer bloque libre %d:00\n",
+                           nombre, familia, hora, h_libre);
+                }
+            }
         }
 
-        read_bytes = read(fd_resp, buffer, sizeof(buffer) - 1);
-        if (read_bytes > 0) {
-            buffer[read_bytes] = '\0';
+        int intento;
+        for (intento = 0; intento <= MAX_REINTENTOS; intento++) {
+
+            /* ---- Descartar respuestas tardias de solicitudes que agotaron su espera ---- */
+            while (leer_respuesta(&lector_resp, buffer, sizeof(buffer), 0) > 0) {
+                printf("Agente %s recibió %s: %s\n", nombre,
+                       es_aviso_espera(buffer) ? "aviso" : "respuesta tardía", buffer);
+            }
+
+            /* ---- Enviar solicitud al Controlador ---- */
+            if (enviar_solicitud(familia, personas, hora, pipe_srv, pipe_resp, parque_linea, -1) < 0) {
+                break;
+            }
+
+            /* ---- Esperar respuesta en el FIFO de respuesta, con tiempo acotado ----
+             * Un aviso de la lista de espera no es la respuesta: se muestra y se sigue esperando. */
+            read_bytes = leer_respuesta(&lector_resp, buffer, sizeof(buffer), timeout_ms);
+            while (read_bytes > 0 && es_aviso_espera(buffer)) {
+                printf("Agente %s recibió aviso: %s\n", nombre, buffer);
+                read_bytes = leer_respuesta(&lector_resp, buffer, sizeof(buffer), timeout_ms);
+            }
+            if (read_bytes == 0) {
+                printf("Agente %s sin respuesta para %s tras %d ms\n", nombre, familia, timeout_ms);
+                break;
+            }
+            if (read_bytes < 0) {
+                break;
+            }
+
+            /* ---- Controlador sobrecargado: retroceso exponencial con jitter y reintento ---- */
+            if (strncmp(buffer, "OCUPADO", 7) == 0) {
+                int sugerida = 0;
+                sscanf(buffer, "OCUPADO: reintentar en %d ms", &sugerida);
+
+                if (intento == MAX_REINTENTOS) {
+                    printf("Agente %s abandona solicitud de %s tras %d reintentos\n",
+                           nombre, familia, MAX_REINTENTOS);
+                    break;
+                }
+
+                int espera = calcular_espera_ms(intento, sugerida);
+                printf("Agente %s: controlador ocupado, reintenta %s en %d ms\n",
+                       nombre, familia, espera);
+                dormir_ms(espera);
+                continue;
+            }
+
             printf("Agente %s recibió respuesta: %s\n", nombre, buffer);
-        } else if (read_bytes < 0) {
-            perror("read respuesta");
+            break;
         }
 
-        close(fd_resp);
-
         /* ---- Pausa de 2 segundos entre solicitudes ---- */
         sleep(2);
     }
@@ -162,6 +384,8 @@ int main(int argc, char *argv[])
     printf("Agente %s termina.\n", nombre);
 
     fclose(fp);
+    disponibilidad_cerrar_memoria(inst_memoria);
+    close(fd_resp);
     unlink(pipe_resp);
 
     return 0;
@@ -0,0 +1,217 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 30/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    bench_latencia.c                                                                            *
+ *                                                                                                         *
+ * Descripcion: Compara la latencia de ida y vuelta con el hilo lector bloqueado en read() (modo por       *
+ *              defecto) y girando con sondeo_leer (modo -u del controlador). Un hilo "agente" escribe un  *
+ *              mensaje en un pipe, con pausas aleatorias entre mensajes para que el lector a veces llegue *
+ *              a estacionarse, y espera la respuesta por otro pipe; el hilo "servidor" lee y responde.    *
+ *              Solo cambia la forma de leer del servidor: el agente lee igual en los dos modos.           *
+ *                                                                                                         *
+ *              El servidor se fija al nucleo 0 y el agente al 1. Con un solo nucleo ambos lo comparten y  *
+ *              el giro le quita tiempo al agente: el resultado no es representativo.                      *
+ *                                                                                                         *
+ * Uso:         ./bench/bench_latencia [mensajes] [pausaMaxUs] [giroMaxUs]                                 *
+ ************************************************************************************************************/
+
+#define _GNU_SOURCE
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "sondeo.h"
+
+#define MENSAJES_DEFECTO              20000
+#define PAUSA_MAX_US_DEFECTO          200
+#define TAM_MENSAJE_BENCH             64
+#define NUCLEO_SERVIDOR               0
+#define NUCLEO_AGENTE                 1
+
+typedef struct {
+    int       fd_solicitud[2];
+    int       fd_respuesta[2];
+    int       sondeando;
+    sondeo_t  sondeo;
+    long      mensajes;
+} banco_t;
+
+static uint64_t ahora_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static int comparar_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+static double percentil_us(const uint64_t *ordenadas, long n, double p)
+{
+    long i = (long) (p * (double) (n - 1) + 0.5);
+    return (double) ordenadas[i] / 1000.0;
+}
+
+/************************************************************************************************************
+ *  static int leer_exacto(int fd, char *destino, size_t largo, banco_t *b)                                 *
+ *                                                                                                          *
+ *  Proposito: Leer un mensaje completo con la politica del modo (bloqueante o sondeo).                     *
+ ************************************************************************************************************/
+static int leer_exacto(int fd, char *destino, size_t largo, banco_t *b)
+{
+    size_t leidos = 0;
+
+    while (leidos < largo) {
+        ssize_t n = b->sondeando ? sondeo_leer(&b->sondeo, fd, destino + leidos, largo - leidos)
+                                 : read(fd, destino + leidos, largo - leidos);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        leidos += (size_t) n;
+    }
+    return 0;
+}
+
+static void *hilo_servidor(void *arg)
+{
+    banco_t *b = arg;
+    char mensaje[TAM_MENSAJE_BENCH];
+    long i;
+
+    sondeo_fijar_nucleo(NUCLEO_SERVIDOR);
+
+    for (i = 0; i < b->mensajes; i++) {
+        if (leer_exacto(b->fd_solicitud[0], mensaje, sizeof(mensaje), b) != 0) break;
+        mensaje[0] = 'R';
+        if (write(b->fd_respuesta[1], mensaje, sizeof(mensaje)) != (ssize_t) sizeof(mensaje)) break;
+    }
+
+    return NULL;
+}
+
+/************************************************************************************************************
+ *  static int medir(banco_t *b, int pausa_max_us, uint64_t *rtt)                                           *
+ *                                                                                                          *
+ *  Proposito: Lanzar el servidor, hacer de agente y dejar la ida y vuelta de cada mensaje en rtt.          *
+ ************************************************************************************************************/
+static int medir(banco_t *b, int pausa_max_us, uint64_t *rtt)
+{
+    pthread_t servidor;
+    banco_t   agente;
+    char mensaje[TAM_MENSAJE_BENCH];
+    unsigned semilla = 7;
+    long i;
+
+    if (pipe(b->fd_solicitud) == -1 || pipe(b->fd_respuesta) == -1) {
+        perror("pipe");
+        return -1;
+    }
+    if (b->sondeando) {
+        fcntl(b->fd_solicitud[0], F_SETFL, fcntl(b->fd_solicitud[0], F_GETFL) | O_NONBLOCK);
+    }
+
+    if (pthread_create(&servidor, NULL, hilo_servidor, b) != 0) {
+        perror("pthread_create (servidor)");
+        return -1;
+    }
+
+    memset(&agente, 0, sizeof(agente));
+    memset(mensaje, 'S', sizeof(mensaje));
+
+    for (i = 0; i < b->mensajes; i++) {
+        if (pausa_max_us > 0) {
+            struct timespec pausa = { 0, (long) (rand_r(&semilla) % (unsigned) pausa_max_us) * 1000L };
+            nanosleep(&pausa, NULL);
+        }
+
+        uint64_t t0 = ahora_ns();
+        if (write(b->fd_solicitud[1], mensaje, sizeof(mensaje)) != (ssize_t) sizeof(mensaje) ||
+            leer_exacto(b->fd_respuesta[0], mensaje, sizeof(mensaje), &agente) != 0) {
+            fprintf(stderr, "Error en el mensaje %ld\n", i);
+            break;
+        }
+        rtt[i] = ahora_ns() - t0;
+    }
+
+    pthread_join(servidor, NULL);
+    close(b->fd_solicitud[0]);
+    close(b->fd_solicitud[1]);
+    close(b->fd_respuesta[0]);
+    close(b->fd_respuesta[1]);
+
+    return (i == b->mensajes) ? 0 : -1;
+}
+
+static void imprimir_fila(const char *modo, uint64_t *rtt, long n)
+{
+    qsort(rtt, (size_t) n, sizeof(uint64_t), comparar_u64);
+    printf("%-12s %9.1f %9.1f %9.1f %9.1f %9.1f\n", modo,
+           percentil_us(rtt, n, 0.50), percentil_us(rtt, n, 0.90),
+           percentil_us(rtt, n, 0.99), percentil_us(rtt, n, 0.999),
+           (double) rtt[n - 1] / 1000.0);
+}
+
+int main(int argc, char *argv[])
+{
+    long mensajes   = (argc > 1) ? atol(argv[1]) : MENSAJES_DEFECTO;
+    int  pausa_max  = (argc > 2) ? atoi(argv[2]) : PAUSA_MAX_US_DEFECTO;
+    int  giro_max   = (argc > 3) ? atoi(argv[3]) : SONDEO_GIRO_MAX_US_DEFECTO;
+    uint64_t *rtt;
+    banco_t b;
+
+    if (mensajes <= 0 || pausa_max < 0 || giro_max <= 0) {
+        fprintf(stderr, "Uso: %s [mensajes] [pausaMaxUs] [giroMaxUs]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    rtt = malloc(sizeof(uint64_t) * (size_t) mensajes);
+    if (rtt == NULL) {
+        perror("malloc (rtt)");
+        return EXIT_FAILURE;
+    }
+
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nucleos < 2) {
+        printf("(un solo nucleo: servidor y agente lo comparten, el giro no es representativo)\n");
+    } else {
+        sondeo_fijar_nucleo(NUCLEO_AGENTE);
+    }
+
+    printf("%ld mensajes, pausa aleatoria 0-%d us, tope de giro %d us\n\n", mensajes, pausa_max, giro_max);
+    printf("%-12s %9s %9s %9s %9s %9s\n", "modo (us)", "p50", "p90", "p99", "p99.9", "max");
+
+    /* ---- Bloqueante ---- */
+    memset(&b, 0, sizeof(b));
+    b.mensajes = mensajes;
+    if (medir(&b, pausa_max, rtt) != 0) return EXIT_FAILURE;
+    imprimir_fila("bloqueante", rtt, mensajes);
+
+    /* ---- Sondeo ---- */
+    memset(&b, 0, sizeof(b));
+    b.mensajes  = mensajes;
+    b.sondeando = 1;
+    sondeo_inicializar(&b.sondeo, NUCLEO_SERVIDOR, giro_max);
+    if (medir(&b, pausa_max, rtt) != 0) return EXIT_FAILURE;
+    imprimir_fila("sondeo", rtt, mensajes);
+
+    printf("\n");
+    sondeo_imprimir(&b.sondeo, "[SONDEO]");
+
+    free(rtt);
+    return EXIT_SUCCESS;
+}
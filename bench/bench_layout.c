@@ -0,0 +1,401 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 26/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    bench_layout.c                                                                              *
+ *                                                                                                         *
+ * Descripcion: Compara el layout anterior de controlador_t (un estado_hora_t de ~9 KB por hora, contadores*
+ *              junto a la hora actual) con el actual (ocupacion densa, hora y contadores en lineas de     *
+ *              cache separadas). Dos escenarios:                                                          *
+ *                - decisiones: la busqueda de bloque de 2 horas sobre muchos parques, como en el modo     *
+ *                  multi-parque; mide la localidad de la ocupacion.                                       *
+ *                - comparticion: un hilo incrementa los contadores mientras otro lee la hora actual; mide *
+ *                  la comparticion falsa (con un solo nucleo no se observa).                              *
+ *              Cuenta fallos de cache con perf_event_open; si el kernel no lo permite, solo mide tiempo.  *
+ *              Para ver los accesos HITM entre nucleos: perf c2c record ./bench/bench_layout              *
+ *                                                                                                         *
+ * Uso:         ./bench/bench_layout [decisiones] [parques]                                                *
+ ************************************************************************************************************/
+
+#define _GNU_SOURCE
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "controlador.h"
+
+#define PARQUES_DEFECTO               256
+#define MAX_PARQUES_BENCH             4096
+#define DECISIONES_DEFECTO            4000000
+#define INCREMENTOS_COMPARTICION      20000000
+#define NUM_CONTADORES_PERF           3
+
+/* ---- Layout anterior (solo los campos que tocan estos escenarios, en el mismo orden) ---- */
+typedef struct {
+    int hora;
+    int ocupacion_actual;
+    int aforo_maximo;
+
+    int       num_reservas;
+    reserva_t reservas[128];
+} estado_hora_antiguo_t;
+
+typedef struct {
+    int hora_ini;
+    int hora_fin;
+    int hora_actual;
+    int segundos_por_hora;
+    int aforo_maximo;
+
+    int solicitudes_negadas;
+    int solicitudes_ok;
+    int solicitudes_reprogramadas;
+
+    estado_hora_antiguo_t horas[MAX_HORAS_DIA + 1];
+
+    char simulacion_activa;
+    pthread_mutex_t mutex;
+} controlador_antiguo_t;
+
+/* ---- Solicitud pregenerada (asi el generador aleatorio no entra en la medicion) ---- */
+typedef struct {
+    uint16_t parque;
+    uint8_t  hora;
+    uint8_t  personas;
+} solicitud_bench_t;
+
+/* ---- Contadores de hardware ---- */
+typedef struct {
+    int       fd[NUM_CONTADORES_PERF];
+    long long valor[NUM_CONTADORES_PERF];
+} medicion_perf_t;
+
+static const char *nombres_perf[NUM_CONTADORES_PERF] = { "cache-misses", "cache-refs", "L1d-miss" };
+
+static uint64_t ahora_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/************************************************************************************************************
+ *  static void perf_abrir(medicion_perf_t *m)                                                              *
+ *                                                                                                          *
+ *  Proposito: Abrir los contadores para este proceso, heredados por los hilos que se creen despues.        *
+ *             Un contador que no se puede abrir queda con fd = -1 y se reporta como "n/d".                 *
+ ************************************************************************************************************/
+static void perf_abrir(medicion_perf_t *m)
+{
+    struct perf_event_attr attr;
+    int i;
+
+    for (i = 0; i < NUM_CONTADORES_PERF; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.disabled       = 1;
+        attr.inherit        = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+
+        if (i == 0) {
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        } else if (i == 1) {
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_REFERENCES;
+        } else {
+            attr.type   = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+
+        m->fd[i]    = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        m->valor[i] = -1;
+    }
+}
+
+static void perf_iniciar(medicion_perf_t *m)
+{
+    int i;
+    for (i = 0; i < NUM_CONTADORES_PERF; i++) {
+        if (m->fd[i] == -1) continue;
+        ioctl(m->fd[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(m->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+static void perf_detener(medicion_perf_t *m)
+{
+    int i;
+    for (i = 0; i < NUM_CONTADORES_PERF; i++) {
+        if (m->fd[i] == -1) continue;
+        ioctl(m->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        if (read(m->fd[i], &m->valor[i], sizeof(m->valor[i])) != sizeof(m->valor[i])) {
+            m->valor[i] = -1;
+        }
+    }
+}
+
+static void perf_cerrar(medicion_perf_t *m)
+{
+    int i;
+    for (i = 0; i < NUM_CONTADORES_PERF; i++) {
+        if (m->fd[i] != -1) close(m->fd[i]);
+    }
+}
+
+static void imprimir_fila(const char *escenario, const char *layout, uint64_t ns,
+                          const medicion_perf_t *m)
+{
+    int i;
+
+    printf("%-22s %-8s %10.1f", escenario, layout, (double) ns / 1e6);
+    for (i = 0; i < NUM_CONTADORES_PERF; i++) {
+        if (m->valor[i] >= 0) printf(" %14lld", m->valor[i]);
+        else                  printf(" %14s", "n/d");
+    }
+    printf("\n");
+}
+
+/************************************************************************************************************
+ *  Escenario 1: decisiones                                                                                 *
+ *                                                                                                          *
+ *  Mismo recorrido que servidor_procesar_mensaje (hora pedida y siguiente, luego reprogramar hacia         *
+ *  adelante). Cuando un parque se llena se vacia, para que la carga sea estable.                           *
+ ************************************************************************************************************/
+#define DECIDIR(OCUP, aforo, hora_fin, h_ini, pers, resultado)                                  \
+    do {                                                                                        \
+        int h_;                                                                                 \
+        (resultado) = -1;                                                                       \
+        for (h_ = (h_ini); h_ < (hora_fin); h_++) {                                             \
+            int cabe1_ = OCUP(h_) + (pers) <= (aforo);                                          \
+            int cabe2_ = (h_ + 1 >= (hora_fin)) || OCUP(h_ + 1) + (pers) <= (aforo);            \
+            if (cabe1_ && cabe2_) {                                                             \
+                OCUP(h_) += (pers);                                                             \
+                if (h_ + 1 < (hora_fin)) OCUP(h_ + 1) += (pers);                                \
+                (resultado) = h_;                                                               \
+                break;                                                                          \
+            }                                                                                   \
+        }                                                                                       \
+    } while (0)
+
+static uint64_t decisiones_antiguo(controlador_antiguo_t **p, const solicitud_bench_t *sol, long n)
+{
+    uint64_t suma = 0;
+    long i;
+
+    for (i = 0; i < n; i++) {
+        controlador_antiguo_t *c = p[sol[i].parque];
+        int r;
+
+#define OCUP_ANTIGUO(x) c->horas[(x)].ocupacion_actual
+        DECIDIR(OCUP_ANTIGUO, c->aforo_maximo, c->hora_fin, sol[i].hora, sol[i].personas, r);
+        if (r == -1) {
+            int k;
+            for (k = 0; k <= MAX_HORAS_DIA; k++) c->horas[k].ocupacion_actual = 0;
+            c->solicitudes_negadas++;
+        } else {
+            c->solicitudes_ok++;
+        }
+        suma += (uint64_t) r;
+    }
+
+    return suma;
+}
+
+static uint64_t decisiones_nuevo(controlador_t **p, const solicitud_bench_t *sol, long n)
+{
+    uint64_t suma = 0;
+    long i;
+
+    for (i = 0; i < n; i++) {
+        controlador_t *c = p[sol[i].parque];
+        int r;
+
+#define OCUP_NUEVO(x) c->ocupacion[(x)]
+        DECIDIR(OCUP_NUEVO, c->aforo_maximo, c->hora_fin, sol[i].hora, sol[i].personas, r);
+        if (r == -1) {
+            memset(c->ocupacion, 0, sizeof(c->ocupacion));
+            c->contadores.solicitudes_negadas++;
+        } else {
+            c->contadores.solicitudes_ok++;
+        }
+        suma += (uint64_t) r;
+    }
+
+    return suma;
+}
+
+/************************************************************************************************************
+ *  Escenario 2: comparticion falsa                                                                         *
+ *                                                                                                          *
+ *  El escritor hace lo que el hilo que decide (sumar a los contadores); el lector hace lo que los demas    *
+ *  hilos (leer la hora actual) hasta que el escritor termina.                                              *
+ ************************************************************************************************************/
+typedef struct {
+    volatile int *hora;             /* Layout antiguo                                      */
+    int          *contador;
+    atomic_int   *hora_atomica;     /* Layout nuevo                                        */
+    atomic_int    fin;
+    long          lecturas;
+} comparticion_t;
+
+static void *lector_hora(void *arg)
+{
+    comparticion_t *cmp = arg;
+    long lecturas = 0;
+    int  suma = 0;
+
+    while (!atomic_load_explicit(&cmp->fin, memory_order_relaxed)) {
+        if (cmp->hora_atomica != NULL) {
+            suma += atomic_load_explicit(cmp->hora_atomica, memory_order_acquire);
+        } else {
+            suma += *cmp->hora;
+        }
+        lecturas++;
+    }
+
+    cmp->lecturas = lecturas + (suma & 0);
+    return NULL;
+}
+
+static uint64_t comparticion(comparticion_t *cmp, medicion_perf_t *m)
+{
+    pthread_t lector;
+    long i;
+
+    atomic_store(&cmp->fin, 0);
+    perf_iniciar(m);
+    pthread_create(&lector, NULL, lector_hora, cmp);
+
+    uint64_t t0 = ahora_ns();
+    for (i = 0; i < INCREMENTOS_COMPARTICION; i++) {
+        (*cmp->contador)++;
+        __asm__ volatile ("" ::: "memory");
+    }
+    uint64_t t = ahora_ns() - t0;
+
+    atomic_store(&cmp->fin, 1);
+    pthread_join(lector, NULL);
+    perf_detener(m);
+
+    return t;
+}
+
+int main(int argc, char *argv[])
+{
+    long decisiones = (argc > 1) ? atol(argv[1]) : DECISIONES_DEFECTO;
+    int  parques    = (argc > 2) ? atoi(argv[2]) : PARQUES_DEFECTO;
+    static controlador_antiguo_t *antiguos[MAX_PARQUES_BENCH];
+    static controlador_t         *nuevos[MAX_PARQUES_BENCH];
+    solicitud_bench_t *sol;
+    medicion_perf_t    m;
+    uint64_t t0, t, control = 0;
+    unsigned semilla = 1;
+    long j;
+    int  i;
+
+    if (decisiones <= 0 || parques <= 0 || parques > MAX_PARQUES_BENCH) {
+        fprintf(stderr, "Uso: %s [decisiones] [parques (1-%d)]\n", argv[0], MAX_PARQUES_BENCH);
+        return EXIT_FAILURE;
+    }
+
+    sol = malloc(sizeof(solicitud_bench_t) * (size_t) decisiones);
+    if (sol == NULL) {
+        perror("malloc (solicitudes)");
+        return EXIT_FAILURE;
+    }
+    for (j = 0; j < decisiones; j++) {
+        sol[j].parque   = (uint16_t) (rand_r(&semilla) % (unsigned) parques);
+        sol[j].hora     = (uint8_t) (HORA_MINIMA_SIMULACION + rand_r(&semilla) % 12);
+        sol[j].personas = (uint8_t) (1 + rand_r(&semilla) % 10);
+    }
+
+    for (i = 0; i < parques; i++) {
+        antiguos[i] = calloc(1, sizeof(controlador_antiguo_t));
+        nuevos[i]   = aligned_alloc(TAM_LINEA_CACHE, sizeof(controlador_t));
+        if (antiguos[i] == NULL || nuevos[i] == NULL) {
+            perror("reserva de parques");
+            return EXIT_FAILURE;
+        }
+        memset(nuevos[i], 0, sizeof(controlador_t));
+
+        antiguos[i]->hora_fin     = nuevos[i]->hora_fin     = HORA_MAXIMA_SIMULACION;
+        antiguos[i]->aforo_maximo = nuevos[i]->aforo_maximo = 50;
+    }
+
+    perf_abrir(&m);
+    if (m.fd[0] == -1) {
+        printf("(contadores de hardware no disponibles: solo tiempo)\n");
+    }
+
+    printf("%d parques, %ld decisiones\n", parques, decisiones);
+    printf("sizeof: antiguo %zu bytes, nuevo %zu bytes (ocupacion en %zu bytes)\n\n",
+           sizeof(controlador_antiguo_t), sizeof(controlador_t), sizeof(nuevos[0]->ocupacion));
+    printf("%-22s %-8s %10s", "escenario", "layout", "ms");
+    for (i = 0; i < NUM_CONTADORES_PERF; i++) printf(" %14s", nombres_perf[i]);
+    printf("\n");
+
+    /* ---- Escenario 1 ---- */
+    perf_iniciar(&m);
+    t0 = ahora_ns();
+    control += decisiones_antiguo(antiguos, sol, decisiones);
+    t = ahora_ns() - t0;
+    perf_detener(&m);
+    imprimir_fila("decisiones", "antiguo", t, &m);
+
+    perf_iniciar(&m);
+    t0 = ahora_ns();
+    control -= decisiones_nuevo(nuevos, sol, decisiones);
+    t = ahora_ns() - t0;
+    perf_detener(&m);
+    imprimir_fila("decisiones", "nuevo", t, &m);
+
+    if (control != 0) {
+        fprintf(stderr, "Error: los dos layouts tomaron decisiones distintas.\n");
+        return EXIT_FAILURE;
+    }
+
+    /* ---- Escenario 2 ---- */
+    comparticion_t cmp;
+    long lecturas_antiguo;
+
+    memset(&cmp, 0, sizeof(cmp));
+    cmp.hora     = &antiguos[0]->hora_actual;
+    cmp.contador = &antiguos[0]->solicitudes_ok;
+    t = comparticion(&cmp, &m);
+    lecturas_antiguo = cmp.lecturas;
+    imprimir_fila("comparticion", "antiguo", t, &m);
+
+    memset(&cmp, 0, sizeof(cmp));
+    cmp.hora_atomica = &nuevos[0]->hora_actual;
+    cmp.contador     = &nuevos[0]->contadores.solicitudes_ok;
+    t = comparticion(&cmp, &m);
+    imprimir_fila("comparticion", "nuevo", t, &m);
+
+    printf("\nlecturas de la hora durante la comparticion: antiguo %ld, nuevo %ld\n",
+           lecturas_antiguo, cmp.lecturas);
+
+    perf_cerrar(&m);
+    free(sol);
+    for (i = 0; i < parques; i++) {
+        free(antiguos[i]);
+        free(nuevos[i]);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 05/12/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    bench_nucleo.c                                                                              *
+ *                                                                                                         *
+ * Descripcion: Compara los nucleos de admision (ver nucleo.h) sobre las mismas busquedas de bloque:       *
+ *                - generico: hora por hora, con la configuracion en variables;                            *
+ *                - mascara:  comparacion vectorial con la configuracion en variables;                     *
+ *                - sede:     la misma mascara con cierre, aforo y duracion constantes, como los que       *
+ *                            genera "make SEDE=...".                                                      *
+ *              Los tres se llaman por puntero, igual que desde el controlador. Antes de medir se          *
+ *              comprueba que den la misma hora en todas las busquedas.                                    *
+ *                                                                                                         *
+ *              Se mide con tres tipos de estado: parque casi vacio (casi todo cabe en la hora pedida),    *
+ *              lleno (la busqueda recorre el dia entero) y una mezcla de todos los niveles de llenado.    *
+ *              Cada medicion es la mejor de REPETICIONES_BENCH. Se compila con los mismos flags de        *
+ *              optimizacion que el controlador (OPTFLAGS en el Makefile) y los imprime al empezar.        *
+ *                                                                                                         *
+ * Uso:         ./bench/bench_nucleo [busquedas]                                                           *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nucleo.h"
+
+#ifndef FLAGS_BENCH
+#define FLAGS_BENCH                   "(desconocidos)"
+#endif
+
+#define BUSQUEDAS_DEFECTO             20000000L
+#define NUM_ESTADOS_BENCH             1024
+#define HORA_INI_BENCH                7
+#define MAX_PERSONAS_BENCH            10
+#define REPETICIONES_BENCH            3
+
+typedef enum { ESTADO_VACIO, ESTADO_MEZCLA, ESTADO_LLENO, NUM_TIPOS_ESTADO } tipo_estado_t;
+
+static const char *nombres_estado[NUM_TIPOS_ESTADO] = { "vacio", "mezcla", "lleno" };
+
+typedef struct {
+    _Alignas(64) int ocupacion[25];
+} estado_bench_t;
+
+typedef struct {
+    uint16_t estado;            /* Indice en los estados                                    */
+    uint8_t  desde;
+    uint8_t  personas;
+} busqueda_bench_t;
+
+/* ---- Configuraciones medidas: los nucleos de sede salen de la misma macro que en nucleo.c ---- */
+#define CONFIGURACIONES_BENCH(X) \
+    X(19, 50, 2)                 \
+    X(18, 30, 2)                 \
+    X(22, 120, 3)
+
+#define NUCLEO_SEDE(fin, aforo, dur)                                                                        \
+    static int sede_##fin##_##aforo##_##dur(const int *ocupacion, int desde, int num_pers,                 \
+                                            int hora_fin, int aforo_parque, int duracion)                  \
+    {                                                                                                       \
+        (void) hora_fin; (void) aforo_parque; (void) duracion;                                              \
+        return nucleo_buscar_mascara(ocupacion, desde, num_pers, fin, aforo, dur);                          \
+    }
+CONFIGURACIONES_BENCH(NUCLEO_SEDE)
+#undef NUCLEO_SEDE
+
+static int mascara_variable(const int *ocupacion, int desde, int num_pers,
+                            int hora_fin, int aforo, int duracion)
+{
+    return nucleo_buscar_mascara(ocupacion, desde, num_pers, hora_fin, aforo, duracion);
+}
+
+typedef struct {
+    int              hora_fin, aforo, duracion;
+    nucleo_buscar_fn sede;
+} configuracion_bench_t;
+
+#define ENTRADA_BENCH(fin, aforo, dur) { fin, aforo, dur, sede_##fin##_##aforo##_##dur },
+static const configuracion_bench_t configuraciones[] = { CONFIGURACIONES_BENCH(ENTRADA_BENCH) };
+#undef ENTRADA_BENCH
+
+static uint64_t ahora_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/************************************************************************************************************
+ *  static void llenar_estados(estado_bench_t *e, const configuracion_bench_t *c, tipo_estado_t tipo, ...)  *
+ *                                                                                                          *
+ *  Proposito: Generar los estados alrededor de un nivel de llenado: 0, aforo, o uno distinto por estado.   *
+ ************************************************************************************************************/
+static void llenar_estados(estado_bench_t *e, const configuracion_bench_t *c, tipo_estado_t tipo,
+                           unsigned *semilla)
+{
+    int i, h;
+
+    for (i = 0; i < NUM_ESTADOS_BENCH; i++) {
+        int nivel = (tipo == ESTADO_VACIO) ? 0 :
+                    (tipo == ESTADO_LLENO) ? c->aforo : (int) ((long) c->aforo * i / NUM_ESTADOS_BENCH);
+
+        memset(e[i].ocupacion, 0, sizeof(e[i].ocupacion));
+        for (h = HORA_INI_BENCH; h < c->hora_fin; h++) {
+            int v = nivel + (int) (rand_r(semilla) % (unsigned) (c->aforo / 4 + 1)) - c->aforo / 8;
+            e[i].ocupacion[h] = (v < 0) ? 0 : (v > c->aforo) ? c->aforo : v;
+        }
+    }
+}
+
+/************************************************************************************************************
+ *  static double medir(nucleo_buscar_fn f, ..., long *control)                                             *
+ *                                                                                                          *
+ *  Proposito: Correr todas las busquedas con el nucleo f y devolver ns por busqueda (la mejor de varias    *
+ *             pasadas). La suma de las horas encontradas queda en control para que el compilador no        *
+ *             descarte el trabajo.                                                                         *
+ ************************************************************************************************************/
+static double medir(nucleo_buscar_fn f, const configuracion_bench_t *c, const estado_bench_t *e,
+                    const busqueda_bench_t *b, long n, long *control)
+{
+    nucleo_buscar_fn volatile buscar = f;       /* Que no se resuelva en la compilacion */
+    double mejor = 0;
+    int r;
+
+    for (r = 0; r < REPETICIONES_BENCH; r++) {
+        uint64_t t0 = ahora_ns();
+        long i, suma = 0;
+
+        for (i = 0; i < n; i++) {
+            suma += buscar(e[b[i].estado].ocupacion, b[i].desde, b[i].personas,
+                           c->hora_fin, c->aforo, c->duracion);
+        }
+
+        double t = (double) (ahora_ns() - t0) / (double) n;
+        if (r == 0 || t < mejor) mejor = t;
+        *control = suma;
+    }
+    return mejor;
+}
+
+int main(int argc, char *argv[])
+{
+    long busquedas = (argc > 1) ? atol(argv[1]) : BUSQUEDAS_DEFECTO;
+    static estado_bench_t estados[NUM_ESTADOS_BENCH];
+    busqueda_bench_t *b;
+    unsigned semilla = 1;
+    size_t k;
+    long i;
+    int  tipo;
+
+    if (busquedas <= 0) {
+        fprintf(stderr, "Uso: %s [busquedas]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    b = malloc(sizeof(busqueda_bench_t) * (size_t) busquedas);
+    if (b == NULL) {
+        perror("malloc (busquedas)");
+        return EXIT_FAILURE;
+    }
+
+    printf("Flags de compilacion: %s\n", FLAGS_BENCH);
+    printf("Nucleos de sede compilados en el motor: %d\n\n", nucleo_num_especializados());
+    printf("%-22s %-7s %12s %12s %12s %11s\n",
+           "configuracion", "estado", "generico", "mascara", "sede", "aceleracion");
+
+    for (k = 0; k < sizeof(configuraciones) / sizeof(configuraciones[0]); k++) {
+        const configuracion_bench_t *c = &configuraciones[k];
+        char nombre[64];
+
+        snprintf(nombre, sizeof(nombre), "cierre %d aforo %d %dh", c->hora_fin, c->aforo, c->duracion);
+
+        for (i = 0; i < busquedas; i++) {
+            b[i].estado   = (uint16_t) (rand_r(&semilla) % NUM_ESTADOS_BENCH);
+            b[i].desde    = (uint8_t) (HORA_INI_BENCH +
+                                       rand_r(&semilla) % (unsigned) (c->hora_fin - HORA_INI_BENCH));
+            b[i].personas = (uint8_t) (1 + rand_r(&semilla) % MAX_PERSONAS_BENCH);
+        }
+
+        for (tipo = 0; tipo < NUM_TIPOS_ESTADO; tipo++) {
+            long control_g, control_m, control_s;
+            int  s, d, p;
+
+            llenar_estados(estados, c, (tipo_estado_t) tipo, &semilla);
+
+            /* ---- Los tres nucleos deben coincidir en cada estado, hora de inicio y tamaño de grupo ---- */
+            for (s = 0; s < NUM_ESTADOS_BENCH; s++) {
+                for (d = 0; d <= c->hora_fin; d++) {
+                    for (p = 1; p <= MAX_PERSONAS_BENCH; p++) {
+                        const int *o = estados[s].ocupacion;
+                        int g = nucleo_buscar_generico(o, d, p, c->hora_fin, c->aforo, c->duracion);
+
+                        if (mascara_variable(o, d, p, c->hora_fin, c->aforo, c->duracion) != g ||
+                            c->sede(o, d, p, 0, 0, 0) != g) {
+                            fprintf(stderr, "Diferencia en %s: estado %d desde %d grupo %d\n",
+                                    nombre, s, d, p);
+                            return EXIT_FAILURE;
+                        }
+                    }
+                }
+            }
+
+            double t_g = medir(nucleo_buscar_generico, c, estados, b, busquedas, &control_g);
+            double t_m = medir(mascara_variable, c, estados, b, busquedas, &control_m);
+            double t_s = medir(c->sede, c, estados, b, busquedas, &control_s);
+
+            if (control_g != control_m || control_g != control_s) {
+                fprintf(stderr, "Las sumas de control no coinciden\n");
+                return EXIT_FAILURE;
+            }
+
+            printf("%-22s %-7s %9.2f ns %9.2f ns %9.2f ns %10.2fx\n",
+                   (tipo == 0) ? nombre : "", nombres_estado[tipo], t_g, t_m, t_s, t_g / t_s);
+        }
+    }
+
+    free(b);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,261 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 01/12/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    consulta.c                                                                                  *
+ *                                                                                                         *
+ * Descripcion: Consulta sobre la exportacion columnar de reservas (ver controlador/exportacion.h).        *
+ *              Mapea el archivo y recorre solo las columnas que necesita para calcular agregados por      *
+ *              hora: solicitudes por hora pedida y reservas, personas y cancelaciones por hora asignada.  *
+ *              Los filtros por familia o agente se resuelven una vez contra el diccionario y despues se   *
+ *              comparan enteros.                                                                          *
+ *                                                                                                         *
+ * Uso:         ./consulta_exec archivo.col [-f familia] [-a agente] [-d]                                  *
+ *                -d: describir el archivo (cabecera, grupos, columnas y diccionarios)                     *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "exportacion.h"
+
+#define MAX_HORAS_CONSULTA            25
+#define SIN_FILTRO                    0xFFFFFFFEu     /* Distinto de cualquier id y de SIN_ID    */
+
+#define USO_CONSULTA \
+    "Uso: %s archivo.col [-f familia] [-a agente] [-d]\n"
+
+/* ---- Agregados por hora ---- */
+typedef struct {
+    uint32_t solicitudes;           /* Por hora solicitada                                 */
+    uint32_t aceptadas;
+    uint32_t reprogramadas;         /* Pedidas a esta hora y movidas a otra                */
+    uint32_t negadas;
+    uint32_t reservas;              /* Por hora asignada (incluye promovidas)              */
+    uint32_t promovidas;
+    uint64_t personas;
+    uint32_t canceladas;
+    uint64_t personas_canceladas;
+} agregado_hora_t;
+
+static uint64_t ahora_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/************************************************************************************************************
+ *  static uint32_t buscar_id(const uint32_t *inicio, const char *texto, uint32_t num, const char *nombre)  *
+ *                                                                                                          *
+ *  Retorno:   Id del nombre en el diccionario, o EXPORTACION_SIN_ID si no aparece (ninguna fila coincide). *
+ ************************************************************************************************************/
+static uint32_t buscar_id(const uint32_t *inicio, const char *texto, uint32_t num, const char *nombre)
+{
+    uint32_t id;
+
+    for (id = 0; id < num; id++) {
+        if (strcmp(texto + inicio[id], nombre) == 0) {
+            return id;
+        }
+    }
+    return EXPORTACION_SIN_ID;
+}
+
+/************************************************************************************************************
+ *  static void describir(const lector_exportacion_t *l)                                                    *
+ ************************************************************************************************************/
+static void describir(const lector_exportacion_t *l)
+{
+    const cabecera_exportacion_t *cab = l->cabecera;
+    uint64_t bytes_columna[NUM_COLUMNAS_EXPORTACION] = { 0 };
+    uint32_t g;
+    int c;
+
+    printf("Parque %d:00-%d:00, aforo %d; inicio %llu ns (unix)\n", cab->hora_ini, cab->hora_fin,
+           cab->aforo_maximo, (unsigned long long) cab->inicio_unix_ns);
+    printf("%llu filas en %u grupos de hasta %u; %u familias, %u agentes; %zu bytes\n\n",
+           (unsigned long long) l->pie->filas, l->pie->num_grupos, cab->filas_por_grupo,
+           l->pie->num_familias, l->pie->num_agentes, l->largo);
+
+    printf("%-6s %8s %11s %9s %14s %14s\n", "grupo", "filas", "hora_actual", "", "t_min (ms)", "t_max (ms)");
+    for (g = 0; g < l->pie->num_grupos; g++) {
+        const grupo_exportacion_t *gr = &l->grupos[g];
+
+        printf("%-6u %8u %8u-%-2u %9s %14.3f %14.3f\n", g, gr->filas, gr->hora_min, gr->hora_max, "",
+               (double) gr->t_min_ns / 1e6, (double) gr->t_max_ns / 1e6);
+        for (c = 0; c < NUM_COLUMNAS_EXPORTACION; c++) {
+            bytes_columna[c] += (uint64_t) ancho_columna_exportacion[c] * gr->filas;
+        }
+    }
+
+    printf("\n%-16s %6s %12s\n", "columna", "ancho", "bytes");
+    for (c = 0; c < NUM_COLUMNAS_EXPORTACION; c++) {
+        printf("%-16s %6u %12llu\n", nombre_columna_exportacion[c], ancho_columna_exportacion[c],
+               (unsigned long long) bytes_columna[c]);
+    }
+}
+
+/************************************************************************************************************
+ *  static uint64_t agregar(const lector_exportacion_t *l, uint32_t id_familia, uint32_t id_agente,         *
+ *                          agregado_hora_t *horas, uint64_t *filas)                                        *
+ *                                                                                                          *
+ *  Proposito: Recorrer por grupos las columnas hora_solicitada, hora_asignada, personas y resultado (y     *
+ *             familia / agente solo si hay filtro) y acumular por hora.                                    *
+ *                                                                                                          *
+ *  Retorno:   Bytes de columnas leidos.                                                                    *
+ ************************************************************************************************************/
+static uint64_t agregar(const lector_exportacion_t *l, uint32_t id_familia, uint32_t id_agente,
+                        agregado_hora_t *horas, uint64_t *filas)
+{
+    uint64_t bytes = 0;
+    uint32_t g, i;
+
+    *filas = 0;
+
+    for (g = 0; g < l->pie->num_grupos; g++) {
+        uint32_t        n         = l->grupos[g].filas;
+        const int8_t   *h_sol     = exportacion_columna(l, g, COL_HORA_SOLICITADA);
+        const int8_t   *h_asig    = exportacion_columna(l, g, COL_HORA_ASIGNADA);
+        const uint16_t *personas  = exportacion_columna(l, g, COL_PERSONAS);
+        const uint8_t  *resultado = exportacion_columna(l, g, COL_RESULTADO);
+        const uint32_t *familia   = exportacion_columna(l, g, COL_FAMILIA);
+        const uint32_t *agente    = exportacion_columna(l, g, COL_AGENTE);
+
+        bytes += (uint64_t) n * (1 + 1 + 2 + 1);
+        if (id_familia != SIN_FILTRO) bytes += (uint64_t) n * 4;
+        if (id_agente  != SIN_FILTRO) bytes += (uint64_t) n * 4;
+
+        for (i = 0; i < n; i++) {
+            if (id_familia != SIN_FILTRO && familia[i] != id_familia) continue;
+            if (id_agente  != SIN_FILTRO && agente[i]  != id_agente)  continue;
+
+            int hs = h_sol[i], ha = h_asig[i];
+            (*filas)++;
+
+            switch (resultado[i]) {
+            case RESULTADO_ACEPTADA:
+            case RESULTADO_REPROGRAMADA:
+                if (hs >= 0 && hs < MAX_HORAS_CONSULTA) {
+                    horas[hs].solicitudes++;
+                    if (resultado[i] == RESULTADO_ACEPTADA) horas[hs].aceptadas++;
+                    else                                    horas[hs].reprogramadas++;
+                }
+                if (ha >= 0 && ha < MAX_HORAS_CONSULTA) {
+                    horas[ha].reservas++;
+                    horas[ha].personas += personas[i];
+                }
+                break;
+
+            case RESULTADO_PROMOVIDA:
+                if (ha >= 0 && ha < MAX_HORAS_CONSULTA) {
+                    horas[ha].reservas++;
+                    horas[ha].promovidas++;
+                    horas[ha].personas += personas[i];
+                }
+                break;
+
+            case RESULTADO_CANCELADA:
+                if (ha >= 0 && ha < MAX_HORAS_CONSULTA) {
+                    horas[ha].canceladas++;
+                    horas[ha].personas_canceladas += personas[i];
+                }
+                break;
+
+            default:    /* Negadas */
+                if (hs >= 0 && hs < MAX_HORAS_CONSULTA) {
+                    horas[hs].solicitudes++;
+                    horas[hs].negadas++;
+                }
+                break;
+            }
+        }
+    }
+
+    return bytes;
+}
+
+int main(int argc, char *argv[])
+{
+    lector_exportacion_t l;
+    agregado_hora_t horas[MAX_HORAS_CONSULTA];
+    const char *familia = NULL, *agente = NULL;
+    uint32_t id_familia = SIN_FILTRO, id_agente = SIN_FILTRO;
+    uint64_t filas, bytes, t0, t;
+    int describir_archivo = 0;
+    int opt, h;
+
+    while ((opt = getopt(argc, argv, "f:a:d")) != -1) {
+        switch (opt) {
+        case 'f':
+            familia = optarg;
+            break;
+        case 'a':
+            agente = optarg;
+            break;
+        case 'd':
+            describir_archivo = 1;
+            break;
+        default:
+            fprintf(stderr, USO_CONSULTA, argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, USO_CONSULTA, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    t0 = ahora_ns();
+    if (exportacion_mapear(&l, argv[optind]) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    if (describir_archivo) {
+        describir(&l);
+        exportacion_desmapear(&l);
+        return EXIT_SUCCESS;
+    }
+
+    /* ---- Filtros: un solo recorrido del diccionario ---- */
+    if (familia != NULL) {
+        id_familia = buscar_id(l.inicio_familias, l.texto_familias, l.pie->num_familias, familia);
+    }
+    if (agente != NULL) {
+        id_agente = buscar_id(l.inicio_agentes, l.texto_agentes, l.pie->num_agentes, agente);
+    }
+
+    memset(horas, 0, sizeof(horas));
+    bytes = agregar(&l, id_familia, id_agente, horas, &filas);
+    t     = ahora_ns() - t0;
+
+    printf("%-5s %11s %9s %13s %7s %8s %10s %8s %10s %11s\n", "hora", "solicitudes", "aceptadas",
+           "reprogramadas", "negadas", "reservas", "promovidas", "personas", "canceladas", "pers. canc.");
+    for (h = l.cabecera->hora_ini; h <= l.cabecera->hora_fin && h < MAX_HORAS_CONSULTA; h++) {
+        printf("%2d:00 %11u %9u %13u %7u %8u %10u %8llu %10u %11llu\n", h,
+               horas[h].solicitudes, horas[h].aceptadas, horas[h].reprogramadas, horas[h].negadas,
+               horas[h].reservas, horas[h].promovidas, (unsigned long long) horas[h].personas,
+               horas[h].canceladas, (unsigned long long) horas[h].personas_canceladas);
+    }
+
+    printf("\n%llu de %llu filas", (unsigned long long) filas, (unsigned long long) l.pie->filas);
+    if (familia != NULL) printf(" (familia %s)", familia);
+    if (agente != NULL)  printf(" (agente %s)", agente);
+    printf("; %.2f MB de columnas en %.3f ms", (double) bytes / 1e6, (double) t / 1e6);
+    if (t > 0) {
+        printf(" (%.2f GB/s)", (double) bytes / (double) t);
+    }
+    printf("\n");
+
+    exportacion_desmapear(&l);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 20/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    admision.c                                                                                  *
+ *                                                                                                         *
+ * Descripcion: Control de admision del Controlador. Mantiene una cubeta de tokens por agente y revisa     *
+ *              la cantidad de bytes pendientes en el FIFO de entrada. Todo se evalua en el hilo lector,   *
+ *              antes de tomar el mutex del parque, para poder rechazar rapido cuando hay sobrecarga.      *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+
+#include "controlador.h"
+
+/************************************************************************************************************
+ *  static int acotar_reintento(double ms)                                                                  *
+ *                                                                                                          *
+ *  Proposito: Llevar la espera sugerida al rango [REINTENTO_MINIMO_MS, REINTENTO_MAXIMO_MS].               *
+ ************************************************************************************************************/
+static int acotar_reintento(double ms)
+{
+    if (ms < REINTENTO_MINIMO_MS) return REINTENTO_MINIMO_MS;
+    if (ms > REINTENTO_MAXIMO_MS) return REINTENTO_MAXIMO_MS;
+    return (int) ms;
+}
+
+/************************************************************************************************************
+ *  static int consumir_token(const admision_t *adm, agente_registrado_t *ag, uint64_t ahora_ns,            *
+ *                            int *reintento_ms)                                                            *
+ *                                                                                                          *
+ *  Proposito: Recargar la cubeta segun el tiempo transcurrido y tomar un token.                            *
+ *                                                                                                          *
+ *  Retorno:   1 si habia token; 0 si no, dejando en *reintento_ms la espera hasta el siguiente.            *
+ ************************************************************************************************************/
+static int consumir_token(const admision_t *adm, agente_registrado_t *ag, uint64_t ahora_ns,
+                          int *reintento_ms)
+{
+    if (ahora_ns > ag->ultima_recarga_ns) {
+        ag->tokens += (double) (ahora_ns - ag->ultima_recarga_ns) / 1e9 * adm->tasa_por_agente;
+        if (ag->tokens > adm->rafaga_por_agente) {
+            ag->tokens = adm->rafaga_por_agente;
+        }
+        ag->ultima_recarga_ns = ahora_ns;
+    }
+
+    if (ag->tokens < 1.0) {
+        /* Tiempo hasta que se complete el siguiente token */
+        *reintento_ms = acotar_reintento((1.0 - ag->tokens) / adm->tasa_por_agente * 1000.0);
+        return 0;
+    }
+
+    ag->tokens -= 1.0;
+    return 1;
+}
+
+/************************************************************************************************************
+ *  void admision_inicializar(admision_t *adm, double tasa, double rafaga, int marca_agua)                  *
+ *                                                                                                          *
+ *  Proposito: Dejar la tabla de agentes vacia y guardar los limites configurados.                          *
+ *             Si la rafaga no se indica (<= 0) se usa una cubeta de un segundo de tasa, minimo 1 token.    *
+ *             La cubeta compartida empieza llena y su reloj arranca con la primera solicitud.              *
+ ************************************************************************************************************/
+void admision_inicializar(admision_t *adm, double tasa, double rafaga, int marca_agua)
+{
+    memset(adm, 0, sizeof(*adm));
+
+    adm->tasa_por_agente = (tasa > 0) ? tasa : 0;
+    adm->marca_agua_fifo = (marca_agua > 0) ? marca_agua : 0;
+
+    if (rafaga > 0) {
+        adm->rafaga_por_agente = rafaga;
+    } else {
+        adm->rafaga_por_agente = (adm->tasa_por_agente > 1) ? adm->tasa_por_agente : 1;
+    }
+
+    adm->compartido.tokens = adm->rafaga_por_agente;
+}
+
+/************************************************************************************************************
+ *  int admision_buscar_agente(admision_t *adm, const char *nombre, const char *pipe_respuesta,             *
+ *                             uint64_t ahora_ns)                                                           *
+ *                                                                                                          *
+ *  Proposito: Buscar el agente por su pipe de respuesta (la SOLICITUD solo trae el pipe). Si no existe     *
+ *             se agrega con la cubeta llena.                                                               *
+ *                                                                                                          *
+ *  Retorno:   Indice del agente en la tabla, o -1 si la tabla esta llena (el agente usa la cubeta          *
+ *             compartida, ver admision_evaluar).                                                           *
+ ************************************************************************************************************/
+int admision_buscar_agente(admision_t *adm, const char *nombre, const char *pipe_respuesta,
+                           uint64_t ahora_ns)
+{
+    int i;
+
+    for (i = 0; i < adm->num_agentes; i++) {
+        if (strcmp(adm->agentes[i].pipe_respuesta, pipe_respuesta) == 0) {
+            /* Un REGISTRO posterior actualiza el nombre del agente */
+            if (nombre != NULL) {
+                strncpy(adm->agentes[i].nombre, nombre, MAX_LONG_NOMBRE_AGENTE - 1);
+            }
+            return i;
+        }
+    }
+
+    if (adm->num_agentes >= MAX_AGENTES_REGISTRADOS) {
+        if (!adm->tabla_llena) {
+            fprintf(stderr, "Aviso: mas de %d agentes; los siguientes comparten una sola cubeta de tokens.\n",
+                    MAX_AGENTES_REGISTRADOS);
+            adm->tabla_llena = 1;
+        }
+        return -1;
+    }
+
+    agente_registrado_t *ag = &adm->agentes[adm->num_agentes];
+
+    strncpy(ag->nombre, (nombre != NULL) ? nombre : "?", MAX_LONG_NOMBRE_AGENTE - 1);
+    strncpy(ag->pipe_respuesta, pipe_respuesta, MAX_LONG_NOMBRE_PIPE - 1);
+    ag->tokens            = adm->rafaga_por_agente;
+    ag->ultima_recarga_ns = ahora_ns;
+
+    return adm->num_agentes++;
+}
+
+/************************************************************************************************************
+ *  int admision_pendientes_fifo(const admision_t *adm, int fifo_fd, int pendientes_locales)                *
+ *                                                                                                          *
+ *  Proposito: Bytes en cola: los que siguen en el FIFO mas los ya leidos sin procesar. Solo se consulta    *
+ *             el FIFO (ioctl FIONREAD) si hay marca de agua configurada.                                   *
+ ************************************************************************************************************/
+int admision_pendientes_fifo(const admision_t *adm, int fifo_fd, int pendientes_locales)
+{
+    int pendientes = 0;
+
+    if (adm->marca_agua_fifo <= 0) {
+        return 0;
+    }
+    if (fifo_fd < 0 || ioctl(fifo_fd, FIONREAD, &pendientes) == -1) {
+        pendientes = 0;
+    }
+
+    return pendientes + pendientes_locales;
+}
+
+/************************************************************************************************************
+ *  int admision_evaluar(admision_t *adm, int pendientes, int idx_agente, uint64_t ahora_ns,                *
+ *                       int *reintento_ms)                                                                 *
+ *                                                                                                          *
+ *  Proposito: Decidir si una SOLICITUD pasa al motor de reservas o se rechaza con "OCUPADO".               *
+ *             1. Marca de agua: bytes en cola detras del mensaje (ver admision_pendientes_fifo).           *
+ *             2. Cubeta de tokens del agente, recargada segun el tiempo transcurrido. Los agentes que no   *
+ *                cupieron en la tabla (idx_agente -1) comparten una cubeta: siguen limitados, entre todos. *
+ *             El instante llega como parametro para que la repeticion de una traza sea determinista.       *
+ *                                                                                                          *
+ *  Retorno:   1 si se admite; 0 si se rechaza, dejando en *reintento_ms la espera sugerida.                *
+ ************************************************************************************************************/
+int admision_evaluar(admision_t *adm, int pendientes, int idx_agente, uint64_t ahora_ns,
+                     int *reintento_ms)
+{
+    /* ---- 1. Profundidad global de la cola ---- */
+    if (adm->marca_agua_fifo > 0 && pendientes > adm->marca_agua_fifo) {
+        /* Espera proporcional a que tan por encima de la marca estamos */
+        *reintento_ms = acotar_reintento((double) REINTENTO_MINIMO_MS * pendientes
+                                         / adm->marca_agua_fifo);
+        adm->solicitudes_ocupado++;
+        return 0;
+    }
+
+    /* ---- 2. Cubeta de tokens del agente ---- */
+    if (adm->tasa_por_agente > 0) {
+        agente_registrado_t *ag = (idx_agente >= 0) ? &adm->agentes[idx_agente] : &adm->compartido;
+
+        if (!consumir_token(adm, ag, ahora_ns, reintento_ms)) {
+            adm->solicitudes_ocupado++;
+            return 0;
+        }
+    }
+
+    return 1;
+}
@@ -0,0 +1,67 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 20/11/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera para el control de admision del Controlador.                    *
+ *               Define la tabla de agentes registrados con su cubeta de tokens (limite de           *
+ *               solicitudes por agente) y la marca de agua global sobre los bytes pendientes en el  *
+ *               FIFO de entrada. Cuando se supera alguno de los dos limites el controlador responde *
+ *               de inmediato "OCUPADO" sin tomar el mutex del estado del parque.                    *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __ADMISION_H__
+#define __ADMISION_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdint.h>
+
+/* Este archivo se incluye desde controlador.h, que define las longitudes maximas de nombres y pipes. */
+
+#define MAX_AGENTES_REGISTRADOS       64
+
+#define REINTENTO_MINIMO_MS           50      /* Espera minima sugerida al agente            */
+#define REINTENTO_MAXIMO_MS           5000    /* Espera maxima sugerida al agente            */
+
+/* ---- Agente conocido por el controlador y su cubeta de tokens ---- */
+typedef struct {
+    char   nombre[MAX_LONG_NOMBRE_AGENTE];
+    char   pipe_respuesta[MAX_LONG_NOMBRE_PIPE];
+
+    double   tokens;
+    uint64_t ultima_recarga_ns;     /* Instante (CLOCK_MONOTONIC) de la ultima recarga      */
+} agente_registrado_t;
+
+/* ---- Estado del control de admision ----
+ * Solo lo toca el hilo lector del FIFO, por eso no necesita mutex.
+ */
+typedef struct {
+    double tasa_por_agente;     /* Solicitudes por segundo por agente (0 = sin limite)   */
+    double rafaga_por_agente;   /* Capacidad de la cubeta de tokens                      */
+    int    marca_agua_fifo;     /* Bytes pendientes en el FIFO (0 = sin limite)          */
+
+    int                 num_agentes;
+    agente_registrado_t agentes[MAX_AGENTES_REGISTRADOS];
+    agente_registrado_t compartido;     /* Cubeta de los agentes que no caben en la tabla    */
+    int                 tabla_llena;    /* 1 = ya se aviso por stderr                        */
+
+    int solicitudes_ocupado;    /* Respuestas "OCUPADO" emitidas                         */
+} admision_t;
+
+/***************************************** Prototipos *******************************************************/
+
+void admision_inicializar(admision_t *adm, double tasa, double rafaga, int marca_agua);
+
+int  admision_buscar_agente(admision_t *adm, const char *nombre, const char *pipe_respuesta,
+                            uint64_t ahora_ns);
+
+int  admision_pendientes_fifo(const admision_t *adm, int fifo_fd, int pendientes_locales);
+
+int  admision_evaluar(admision_t *adm, int pendientes, int idx_agente, uint64_t ahora_ns,
+                      int *reintento_ms);
+
+#endif /* __ADMISION_H__ */
@@ -18,19 +18,54 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <time.h>
 
 #include "controlador.h"
+#include "traza.h"
+#include "replica.h"
+#include "exportacion.h"
 
-int servidor_inicializar(controlador_t *ctrl)
+/* **********************************************************************************************************
+ * reloj_monotonico_ns                                                                                      *
+ *                                                                                                          *
+ * Instante actual de CLOCK_MONOTONIC en nanosegundos.                                                      *
+ * **********************************************************************************************************/
+uint64_t reloj_monotonico_ns(void)
 {
-    int h, i;
+    struct timespec ts;
 
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* **********************************************************************************************************
+ * servidor_inicializar_estado                                                                              *
+ *                                                                                                          *
+ * Deja listo el estado del parque (mutex, horas, admision y reporte) sin crear FIFO ni hilos. Lo usa       *
+ * servidor_inicializar y tambien el modo repeticion, que alimenta el motor directamente desde una traza.   *
+ * **********************************************************************************************************/
+int servidor_inicializar_estado(controlador_t *ctrl)
+{
     /* ---- Validacion de puntero ---- */
     if (ctrl == NULL) {
-        fprintf(stderr, "Error: controlador nulo en servidor_inicializar().\n");
+        fprintf(stderr, "Error: controlador nulo en servidor_inicializar_estado().\n");
         return -1;
     }
 
+    ctrl->fifo_fd       = -1;
+    ctrl->hilos_creados = 0;
+
+    if (ctrl->duracion_reserva <= 0) {
+        ctrl->duracion_reserva = DURACION_RESERVA_DEFECTO;
+    }
+
+    /* ---- Nucleo de admision: el generado al compilar para esta configuracion, o el generico ---- */
+    nucleo_elegir(&ctrl->nucleo, ctrl->hora_fin, ctrl->aforo_maximo, ctrl->duracion_reserva);
+    if (ctrl->nucleo.especializado) {
+        LOG_CTRL(ctrl, "[CTRL] Nucleo de admision de sede (cierre %d, aforo %d, bloque de %d horas)\n",
+                 ctrl->hora_fin, ctrl->aforo_maximo, ctrl->duracion_reserva);
+    }
+
     /* ---- Inicializar Mutex ---- */
     if (pthread_mutex_init(&ctrl->mutex, NULL) != 0) {
         perror("mutex_init");
@@ -38,29 +73,98 @@ int servidor_inicializar(controlador_t *ctrl)
     }
 
     /* ---- Inicializar hora actual y bandera de simulacion ---- */
-    ctrl->hora_actual       = ctrl->hora_ini;
-    ctrl->simulacion_activa = 1;
+    atomic_init(&ctrl->hora_actual, ctrl->hora_ini);
+    atomic_init(&ctrl->simulacion_activa, 1);
 
     /* ---- Inicializar estadisticas globales ---- */
-    ctrl->solicitudes_negadas       = 0;
-    ctrl->solicitudes_ok            = 0;
-    ctrl->solicitudes_reprogramadas = 0;
-
-    /* ---- Inicializar estructuras por hora ---- */
-    for (h = 0; h <= MAX_HORAS_DIA; h++) {
-        ctrl->horas[h].hora             = h;
-        ctrl->horas[h].aforo_maximo     = ctrl->aforo_maximo;
-        ctrl->horas[h].ocupacion_actual = 0;
-        ctrl->horas[h].num_reservas     = 0;
-
-        for (i = 0; i < MAX_RESERVAS_POR_HORA; i++) {
-            ctrl->horas[h].reservas[i].nombre_familia[0] = '\0';
-            ctrl->horas[h].reservas[i].hora_inicio       = 0;
-            ctrl->horas[h].reservas[i].hora_fin          = 0;
-            ctrl->horas[h].reservas[i].num_personas      = 0;
+    ctrl->contadores.solicitudes_negadas       = 0;
+    ctrl->contadores.solicitudes_ok            = 0;
+    ctrl->contadores.solicitudes_reprogramadas = 0;
+
+    /* ---- Inicializar control de admision ---- */
+    admision_inicializar(&ctrl->admision, ctrl->tasa_por_agente,
+                         ctrl->rafaga_por_agente, ctrl->marca_agua_fifo);
+
+    /* ---- Inicializar reporte incremental (sin archivos horarios si no se pueden crear) ---- */
+    if (reporte_inicializar(&ctrl->reporte, ctrl->hora_ini, ctrl->hora_fin,
+                            ctrl->sin_archivos ? NULL : ctrl->prefijo_archivos) != 0) {
+        fprintf(stderr, "Aviso: no se escribiran instantaneas horarias del reporte.\n");
+    }
+
+    /* ---- Inicializar medicion de latencia ---- */
+    if (latencia_inicializar(&ctrl->latencia, ctrl->muestreo_latencia,
+                             ctrl->ruta_eventos_chrome) != 0) {
+        fprintf(stderr, "Aviso: no se escribiran eventos de Chrome.\n");
+    }
+
+    /* ---- Instantanea de disponibilidad (sin memoria compartida si no se puede crear) ---- */
+    if (disponibilidad_inicializar(&ctrl->disponibilidad, ctrl->nombre_memoria, ctrl->hora_ini,
+                                   ctrl->hora_fin, ctrl->aforo_maximo, ctrl->duracion_reserva) != 0 &&
+        disponibilidad_inicializar(&ctrl->disponibilidad, NULL, ctrl->hora_ini,
+                                   ctrl->hora_fin, ctrl->aforo_maximo, ctrl->duracion_reserva) != 0) {
+        return -1;
+    }
+
+    /* ---- Exportacion columnar de reservas (el prefijo va delante del nombre del archivo) ---- */
+    if (ctrl->ruta_exportacion[0] != '\0') {
+        char        ruta[MAX_LONG_NOMBRE_PIPE * 2];
+        const char *nombre = strrchr(ctrl->ruta_exportacion, '/');
+
+        nombre = (nombre != NULL) ? nombre + 1 : ctrl->ruta_exportacion;
+        snprintf(ruta, sizeof(ruta), "%.*s%s%s", (int) (nombre - ctrl->ruta_exportacion),
+                 ctrl->ruta_exportacion, ctrl->prefijo_archivos, nombre);
+
+        ctrl->exportacion = exportacion_abrir(ruta, reloj_monotonico_ns(), ctrl->hora_ini,
+                                              ctrl->hora_fin, ctrl->aforo_maximo);
+        if (ctrl->exportacion == NULL) {
+            fprintf(stderr, "Aviso: no se exportaran las reservas a '%s'.\n", ruta);
         }
     }
 
+    /* ---- Respuestas a los agentes, por tandas (ver salida.h) ---- */
+    if (salida_inicializar(&ctrl->salida, ctrl->plazo_respuestas_us, &ctrl->latencia) != 0) {
+        return -1;
+    }
+
+    /* ---- Lista de espera (vacia; solo se usa si se activo con -e o lista_espera) ---- */
+    espera_inicializar(&ctrl->espera, ctrl->lista_espera, ctrl->hora_ini);
+
+    /* ---- Ocupacion por hora y registro de reservas ---- */
+    memset(ctrl->ocupacion, 0, sizeof(ctrl->ocupacion));
+
+    ctrl->num_reservas       = 0;
+    ctrl->capacidad_reservas = RESERVAS_INICIALES;
+    ctrl->reservas           = malloc(sizeof(reserva_t) * RESERVAS_INICIALES);
+    if (ctrl->reservas == NULL) {
+        perror("malloc (registro de reservas)");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* **********************************************************************************************************
+ * servidor_inicializar                                                                                     *
+ *                                                                                                          *
+ * Inicializa el estado, crea el FIFO de entrada y lanza los hilos de reloj y de atencion de agentes.       *
+ * **********************************************************************************************************/
+int servidor_inicializar(controlador_t *ctrl)
+{
+    if (servidor_inicializar_estado(ctrl) != 0) {
+        return -1;
+    }
+
+    return servidor_arrancar(ctrl);
+}
+
+/* **********************************************************************************************************
+ * servidor_arrancar                                                                                        *
+ *                                                                                                          *
+ * Crea (o reutiliza) el FIFO de entrada y lanza los hilos sobre un estado ya inicializado. El respaldo lo  *
+ * llama al tomar el lugar del primario, con el estado que recibio por replicacion.                         *
+ * **********************************************************************************************************/
+int servidor_arrancar(controlador_t *ctrl)
+{
     /* ---- Crear el FIFO nominal ---- */
     if (mkfifo(ctrl->pipe_entrada, 0666) == -1) {
         if (errno != EEXIST) {
@@ -76,6 +180,15 @@ int servidor_inicializar(controlador_t *ctrl)
         return -1;
     }
 
+    /* ---- En modo de baja latencia el hilo de agentes gira con lecturas no bloqueantes ---- */
+    if (ctrl->sondeo.activo &&
+        fcntl(ctrl->fifo_fd, F_SETFL, fcntl(ctrl->fifo_fd, F_GETFL) | O_NONBLOCK) == -1) {
+        perror("fcntl (O_NONBLOCK en pipe de entrada)");
+        close(ctrl->fifo_fd);
+        ctrl->fifo_fd = -1;
+        return -1;
+    }
+
     /* ---- Crear hilo del reloj de simulacion ---- */
     if (pthread_create(&(ctrl->hilo_reloj), NULL, servidor_hilo_reloj, (void *) ctrl) != 0) {
         perror("pthread_create (ctrl->hilo_reloj)");
@@ -88,7 +201,7 @@ int servidor_inicializar(controlador_t *ctrl)
     if (pthread_create(&(ctrl->hilo_agentes), NULL, servidor_hilo_agentes, (void *) ctrl) != 0) {
         perror("pthread_create (hilo_agentes)");
         /* Si falla este hilo, cancelamos el de reloj y limpiamos. */
-        ctrl->simulacion_activa = 0;
+        CTRL_DETENER(ctrl);
         pthread_cancel(ctrl->hilo_reloj);
         pthread_join(ctrl->hilo_reloj, NULL);
         close(ctrl->fifo_fd);
@@ -96,6 +209,7 @@ int servidor_inicializar(controlador_t *ctrl)
         return -1;
     }
 
+    ctrl->hilos_creados = 1;
     return 0;
 }
 
@@ -104,11 +218,35 @@ void servidor_destruir(controlador_t *ctrl)
     if (ctrl == NULL) return;
 
     /* ---- Marcar fin de simulacion ---- */
-    ctrl->simulacion_activa = 0;
+    CTRL_DETENER(ctrl);
 
     /* ---- Esperar a que terminen los hilos (si fueron creados) ---- */
-    pthread_join(ctrl->hilo_reloj,   NULL);
-    pthread_join(ctrl->hilo_agentes, NULL);
+    if (ctrl->hilos_creados) {
+        pthread_join(ctrl->hilo_reloj,   NULL);
+        pthread_join(ctrl->hilo_agentes, NULL);
+        ctrl->hilos_creados = 0;
+    }
+
+    /* ---- Enviar las respuestas que queden en cola y cerrar los FIFOs de los agentes ---- */
+    salida_cerrar(&ctrl->salida, "[RESPUESTAS]");
+
+    /* ---- Enviar al respaldo lo pendiente: al cerrar la conexion sabe que el dia termino ---- */
+    if (ctrl->replica != NULL) {
+        replica_cerrar(ctrl->replica);
+        ctrl->replica = NULL;
+    }
+
+    /* ---- Completar la exportacion columnar (ultimo grupo, diccionarios e indice) ---- */
+    if (ctrl->exportacion != NULL) {
+        exportacion_cerrar(ctrl->exportacion);
+        ctrl->exportacion = NULL;
+    }
+
+    /* ---- Cerrar la traza grabada, si la hay ---- */
+    if (ctrl->traza != NULL) {
+        traza_cerrar(ctrl->traza);
+        ctrl->traza = NULL;
+    }
 
     /* ---- Destruir Mutex ---- */
     pthread_mutex_destroy(&ctrl->mutex);
@@ -124,86 +262,197 @@ void servidor_destruir(controlador_t *ctrl)
         unlink(ctrl->pipe_entrada);
     }
 
-    
-     /* GENERACION DEL REPORTE FINAL (reporte_final.txt)*/
-     
-    FILE *fp = fopen("reporte_final.txt", "w");
-    if (fp == NULL) {
-        perror("Error creando reporte_final.txt");
-    } else {
-        fprintf(fp, "================ REPORTE FINAL DEL SISTEMA DE RESERVAS ================\n\n");
-
-        /* --- Calcular Horas Pico y Horas Valle --- */
-        int max_ocupacion = -1;
-        int min_ocupacion = 999999;
-        int h;
-
-        /* Paso 1: Encontrar los valores maximo y minimo de ocupacion */
-        for (h = ctrl->hora_ini; h < ctrl->hora_fin; h++) {
-            int ocupacion = ctrl->horas[h].ocupacion_actual;
-            if (ocupacion > max_ocupacion) max_ocupacion = ocupacion;
-            if (ocupacion < min_ocupacion) min_ocupacion = ocupacion;
-        }
 
-        /* Paso 2: Escribir Horas Pico (A) */
-        fprintf(fp, "a. Horas pico (Mayor ocupacion: %d personas):\n", max_ocupacion);
-        for (h = ctrl->hora_ini; h < ctrl->hora_fin; h++) {
-            if (ctrl->horas[h].ocupacion_actual == max_ocupacion) {
-                fprintf(fp, "   - %02d:00\n", h);
-            }
+    /* ---- Reporte final: el estado ya esta calculado, solo se vuelca ---- */
+    char ruta[MAX_LONG_NOMBRE_PIPE];
+
+    snprintf(ruta, sizeof(ruta), "%s%s", ctrl->prefijo_archivos, ARCHIVO_REPORTE_FINAL);
+    if (!ctrl->sin_archivos &&
+        reporte_escribir_final(&ctrl->reporte, ruta, ctrl->admision.solicitudes_ocupado) == 0) {
+        printf("\n[SISTEMA] Reporte generado exitosamente en '%s'.\n", ruta);
+    }
+    reporte_cerrar(&ctrl->reporte);
+
+    /* ---- Resumen de latencia por etapas, si se midio ---- */
+    FILE *fp_lat = NULL;
+    snprintf(ruta, sizeof(ruta), "%s%s", ctrl->prefijo_archivos, ARCHIVO_REPORTE_LATENCIA);
+    if (ctrl->latencia.muestreo > 0 && (fp_lat = fopen(ruta, "w")) != NULL) {
+        if (latencia_escribir_reporte(&ctrl->latencia, fp_lat) == 0) {
+            latencia_escribir_reporte(&ctrl->latencia, stdout);
         }
-        fprintf(fp, "\n");
+        fclose(fp_lat);
+    }
+    latencia_cerrar(&ctrl->latencia);
 
-        /* Paso 3: Escribir Horas con menor numero de personas (B) */
-        fprintf(fp, "b. Horas valle (Menor ocupacion: %d personas):\n", min_ocupacion);
-        for (h = ctrl->hora_ini; h < ctrl->hora_fin; h++) {
-            if (ctrl->horas[h].ocupacion_actual == min_ocupacion) {
-                fprintf(fp, "   - %02d:00\n", h);
-            }
+    sondeo_imprimir(&ctrl->sondeo, "[SONDEO]");
+
+    disponibilidad_cerrar(&ctrl->disponibilidad);
+    espera_liberar(&ctrl->espera);
+
+    free(ctrl->reservas);
+    ctrl->reservas           = NULL;
+    ctrl->num_reservas       = 0;
+    ctrl->capacidad_reservas = 0;
+}
+
+/* **********************************************************************************************************
+ * publicar_disponibilidad                                                                                  *
+ *                                                                                                          *
+ * Republica la instantanea de cupos libres. Se llama con ctrl->mutex tomado.                               *
+ * **********************************************************************************************************/
+static void publicar_disponibilidad(controlador_t *ctrl)
+{
+    disponibilidad_publicar(&ctrl->disponibilidad,
+                            atomic_load_explicit(&ctrl->hora_actual, memory_order_relaxed),
+                            ctrl->ocupacion);
+}
+
+/* **********************************************************************************************************
+ * hora_delta                                                                                               *
+ *                                                                                                          *
+ * Las horas de un delta viajan en int8: una fuera de [0, MAX_HORAS_DIA] (una hora solicitada invalida) se  *
+ * envia como -1 en lugar de dar la vuelta a otra hora.                                                     *
+ * **********************************************************************************************************/
+static int8_t hora_delta(int hora)
+{
+    return (hora >= 0 && hora <= MAX_HORAS_DIA) ? (int8_t) hora : -1;
+}
+
+/* **********************************************************************************************************
+ * replicar                                                                                                 *
+ *                                                                                                          *
+ * Anota un cambio de estado para el respaldo, si lo hay. Se llama con ctrl->mutex tomado.                  *
+ * **********************************************************************************************************/
+static void replicar(controlador_t *ctrl, int tipo, int respuesta, const char *familia, int personas,
+                     int hora_solicitada, int hora)
+{
+    delta_replica_t d;
+
+    if (ctrl->replica == NULL) return;
+
+    memset(&d, 0, sizeof(d));
+    d.tipo            = (uint8_t) tipo;
+    d.respuesta       = (int8_t) respuesta;
+    d.hora_solicitada = hora_delta(hora_solicitada);
+    d.hora            = hora_delta(hora);
+    d.personas        = personas;
+    if (familia != NULL) {
+        snprintf(d.familia, sizeof(d.familia), "%s", familia);
+    }
+
+    replica_registrar(ctrl->replica, &d);
+}
+
+/* **********************************************************************************************************
+ * exportar                                                                                                 *
+ *                                                                                                          *
+ * Agrega una fila a la exportacion columnar, si esta activa. Se llama con ctrl->mutex tomado.              *
+ * **********************************************************************************************************/
+static void exportar(controlador_t *ctrl, uint64_t t_ns, int resultado, const char *agente,
+                     const char *familia, int personas, int hora_solicitada, int hora)
+{
+    if (ctrl->exportacion == NULL) return;
+
+    exportacion_registrar(ctrl->exportacion, t_ns,
+                          atomic_load_explicit(&ctrl->hora_actual, memory_order_relaxed),
+                          resultado, agente, familia, personas, hora_solicitada, hora);
+}
+
+/* **********************************************************************************************************
+ * enviar_avisos                                                                                            *
+ *                                                                                                          *
+ * Envia a cada agente los avisos de la lista de espera acumulados en un evento. Se llama sin el mutex. Los *
+ * avisos salen enseguida: el reloj no tiene un plazo que vigilar y el lector puede estar bloqueado.        *
+ * **********************************************************************************************************/
+static void enviar_avisos(controlador_t *ctrl, const avisos_espera_t *avisos)
+{
+    int i;
+
+    for (i = 0; i < avisos->num; i++) {
+        LOG_CTRL(ctrl, "[ESPERA] %s", avisos->avisos[i].texto);
+        if (!ctrl->sin_respuestas) {
+            salida_encolar(&ctrl->salida, avisos->avisos[i].pipe, avisos->avisos[i].texto, NULL, NULL);
         }
-        fprintf(fp, "\n");
+    }
+    if (avisos->num > 0 && !ctrl->sin_respuestas) {
+        salida_vaciar(&ctrl->salida);
+    }
+}
 
-        /* Paso 4: Estadisticas de solicitudes (C, D, E) */
-        fprintf(fp, "c. Cantidad de solicitudes negadas        : %d\n", ctrl->solicitudes_negadas);
-        fprintf(fp, "d. Cantidad de solicitudes aceptadas      : %d\n", ctrl->solicitudes_ok);
-        fprintf(fp, "e. Cantidad de solicitudes reprogramadas  : %d\n", ctrl->solicitudes_reprogramadas);
+/* **********************************************************************************************************
+ * servidor_avanzar_reloj                                                                                   *
+ *                                                                                                          *
+ * Cambia la hora de simulacion y escribe la instantanea horaria del reporte. El resumen se copia dentro    *
+ * del mutex y se escribe fuera de el. Las solicitudes en espera de horas que ya pasaron se vencen en lotes *
+ * de MAX_AVISOS_ESPERA: cada lote se envia sin el mutex y se vuelve a tomar para el siguiente.             *
+ * **********************************************************************************************************/
+void servidor_avanzar_reloj(controlador_t *c, int hora_nueva)
+{
+    resumen_reporte_t resumen;
+    avisos_espera_t   avisos;
 
-        fprintf(fp, "\n=======================================================================\n");
-        
-        printf("\n[SISTEMA] Reporte generado exitosamente en 'reporte_final.txt'.\n");
-        fclose(fp);
+    avisos.num = 0;
+
+    /* ---- Proteger cambio de hora con Mutex ---- */
+    pthread_mutex_lock(&c->mutex);
+
+    /* ---- Avanzar hora de simulacion ---- */
+    atomic_store_explicit(&c->hora_actual, hora_nueva, memory_order_release);
+
+    LOG_CTRL(c, "\n[RELOJ] Hora de simulacion: %d:00 (Ocupacion: %d/%d)\n",
+             hora_nueva,
+             c->ocupacion[hora_nueva],
+             c->aforo_maximo);
+
+    if (c->espera.total > 0) {
+        reporte_espera(&c->reporte, 0, 0, espera_vencer(&c->espera, hora_nueva, &avisos), 0);
     }
+
+    replicar(c, DELTA_HORA, -1, NULL, 0, -1, hora_nueva);
+
+    reporte_tomar_resumen(&c->reporte, hora_nueva, &resumen);
+    publicar_disponibilidad(c);
+
+    pthread_mutex_unlock(&c->mutex);
+
+    enviar_avisos(c, &avisos);
+
+    /* ---- Un lote lleno puede haber dejado vencidas sin avisar ---- */
+    while (avisos.num == MAX_AVISOS_ESPERA) {
+        avisos.num = 0;
+
+        pthread_mutex_lock(&c->mutex);
+        reporte_espera(&c->reporte, 0, 0, espera_vencer(&c->espera, hora_nueva, &avisos), 0);
+        reporte_tomar_resumen(&c->reporte, hora_nueva, &resumen);
+        pthread_mutex_unlock(&c->mutex);
+
+        enviar_avisos(c, &avisos);
+    }
+
+    reporte_escribir_instantanea(&c->reporte, &resumen);
 }
 
 void *servidor_hilo_reloj(void *ctrl)
 {
     controlador_t *c = (controlador_t *) ctrl;
 
-    while (c->simulacion_activa && c->hora_actual < c->hora_fin) {
+    while (CTRL_ACTIVO(c) && CTRL_HORA_ACTUAL(c) < c->hora_fin) {
 
         /* ---- Esperar el equivalente a una hora de simulacion ---- */
         sleep(c->segundos_por_hora);
 
-        /* ---- Proteger cambio de hora con Mutex ---- */
-        pthread_mutex_lock(&c->mutex);
-        
-        /* ---- Avanzar hora de simulacion ---- */
-        c->hora_actual++;
-
-        printf("\n[RELOJ] Hora de simulacion: %d:00 (Ocupacion: %d/%d)\n", 
-               c->hora_actual, 
-               c->horas[c->hora_actual].ocupacion_actual,
-               c->aforo_maximo);
-
-        pthread_mutex_unlock(&c->mutex);
+        servidor_avanzar_reloj(c, CTRL_HORA_ACTUAL(c) + 1);
     }
 
     // Cuando termina el horario, cerramos la simulacion
-    if (c->hora_actual >= c->hora_fin) {
+    if (CTRL_HORA_ACTUAL(c) >= c->hora_fin) {
         printf("[RELOJ] Fin del dia alcanzado. Cerrando sistema...\n");
-        c->simulacion_activa = 0;
+        CTRL_DETENER(c);
         // Escribimos un 'end' en el pipe para desbloquear el hilo de agentes si esta esperando
-        write(c->fifo_fd, "end", 3); 
+        // (en modo multi-parque el parque no tiene FIFO propio: lo vigila el enrutador)
+        if (c->fifo_fd != -1) {
+            write(c->fifo_fd, "end\n", 4);
+        }
     }
 
     return NULL;
@@ -211,221 +460,732 @@ void *servidor_hilo_reloj(void *ctrl)
 
 
 /* **********************************************************************************************************
- * servidor_hilo_agentes                                               *
+ * ocupar_bloque                                                                                            *
+ *                                                                                                          *
+ * Suma el grupo a la hora asignada y a las siguientes (duracion_reserva horas, sin pasar del cierre),      *
+ * avisa al reporte incremental y anota la reserva en el registro (datos frios, fuera de la ocupacion). Se  *
+ * llama con ctrl->mutex tomado.                                                                            *
+ * **********************************************************************************************************/
+static void ocupar_bloque(controlador_t *ctrl, const char *familia, int hora, int num_pers)
+{
+    int h;
+
+    ctrl->ocupacion[hora] += num_pers;
+    reporte_ocupacion(&ctrl->reporte, hora, ctrl->ocupacion[hora]);
+
+    for (h = hora + 1; h < hora + ctrl->duracion_reserva && h < ctrl->hora_fin; h++) {
+        ctrl->ocupacion[h] += num_pers;
+        reporte_ocupacion(&ctrl->reporte, h, ctrl->ocupacion[h]);
+    }
+
+    /* ---- Registro de la reserva (si no hay memoria la ocupacion ya quedo contada) ---- */
+    if (ctrl->num_reservas == ctrl->capacidad_reservas) {
+        reserva_t *mas = realloc(ctrl->reservas, sizeof(reserva_t) * ctrl->capacidad_reservas * 2);
+        if (mas == NULL) {
+            fprintf(stderr, "[CTRL] Sin memoria para registrar la reserva de %s\n", familia);
+            return;
+        }
+        ctrl->reservas            = mas;
+        ctrl->capacidad_reservas *= 2;
+    }
+
+    reserva_t *r = &ctrl->reservas[ctrl->num_reservas++];
+    strncpy(r->nombre_familia, familia, MAX_LONG_NOMBRE_FAMILIA - 1);
+    r->nombre_familia[MAX_LONG_NOMBRE_FAMILIA - 1] = '\0';
+    r->hora_inicio  = hora;
+    r->hora_fin     = hora + ctrl->duracion_reserva;
+    r->num_personas = num_pers;
+}
+
+/* **********************************************************************************************************
+ * cabe_bloque                                                                                              *
+ *                                                                                                          *
+ * Indica si un grupo cabe en la hora y en las siguientes de su bloque (las que quedan antes del cierre     *
+ * cuentan; la hora de inicio se revisa siempre). Con ctrl->mutex tomado.                                   *
+ * **********************************************************************************************************/
+static int cabe_bloque(const controlador_t *ctrl, int hora, int num_pers)
+{
+    int h;
+
+    if (ctrl->ocupacion[hora] + num_pers > ctrl->aforo_maximo) return 0;
+
+    for (h = hora + 1; h < hora + ctrl->duracion_reserva && h < ctrl->hora_fin; h++) {
+        if (ctrl->ocupacion[h] + num_pers > ctrl->aforo_maximo) return 0;
+    }
+    return 1;
+}
+
+/* **********************************************************************************************************
+ * buscar_bloque                                                                                            *
+ *                                                                                                          *
+ * Primera hora en [desde, hora_fin) en la que el grupo cabe durante todo su bloque (la misma regla de      *
+ * cabe_bloque), o -1. La resuelve el nucleo elegido al iniciar el parque. Con ctrl->mutex tomado.          *
+ * **********************************************************************************************************/
+static inline int buscar_bloque(const controlador_t *ctrl, int desde, int num_pers)
+{
+    return ctrl->nucleo.buscar(ctrl->ocupacion, desde, num_pers,
+                               ctrl->hora_fin, ctrl->aforo_maximo, ctrl->duracion_reserva);
+}
+
+/* **********************************************************************************************************
+ * promover_espera                                                                                          *
+ *                                                                                                          *
+ * Reserva a las solicitudes en espera de una hora mientras quepan. El monticulo entrega primero el grupo   *
+ * mas pequeño: si ese no cabe, ninguno cabe y se deja de buscar. Con ctrl->mutex tomado. t_ns es el       *
+ * instante del mensaje que libero el cupo (se exporta con cada promocion).                                 *
+ *                                                                                                          *
+ * Retorno: solicitudes promovidas.                                                                         *
+ * **********************************************************************************************************/
+static int promover_espera(controlador_t *ctrl, int hora, uint64_t t_ns, avisos_espera_t *avisos)
+{
+    const entrada_espera_t *primero;
+    entrada_espera_t        e;
+    char                    texto[MAX_LONG_MENSAJE];
+    int                     promovidas = 0;
+
+    if (hora < CTRL_HORA_ACTUAL(ctrl) || hora < ctrl->hora_ini || hora >= ctrl->hora_fin) {
+        return 0;
+    }
+
+    /* Sin lugar para el aviso no se promueve: la solicitud sigue en espera para el siguiente evento */
+    while (avisos->num < MAX_AVISOS_ESPERA &&
+           (primero = espera_primero(&ctrl->espera, hora)) != NULL &&
+           cabe_bloque(ctrl, hora, primero->personas)) {
+        espera_quitar_primero(&ctrl->espera, hora, &e);
+        ocupar_bloque(ctrl, e.familia, hora, e.personas);
+        replicar(ctrl, DELTA_RESERVA, -1, e.familia, e.personas, hora, hora);
+        exportar(ctrl, t_ns, RESULTADO_PROMOVIDA, NULL, e.familia, e.personas, hora, hora);
+
+        snprintf(texto, sizeof(texto), "PROMOVIDA: %s %d:00\n", e.familia, hora);
+        espera_agregar_aviso(avisos, e.pipe_respuesta, texto);
+        promovidas++;
+    }
+
+    return promovidas;
+}
+
+/* **********************************************************************************************************
+ * liberar_reserva                                                                                          *
+ *                                                                                                          *
+ * Quita la reserva i del registro y resta su grupo de las horas que ocupaba (lo inverso de ocupar_bloque). *
+ * Con ctrl->mutex tomado.                                                                                  *
+ * **********************************************************************************************************/
+static void liberar_reserva(controlador_t *ctrl, int i)
+{
+    int hora     = ctrl->reservas[i].hora_inicio;
+    int fin      = ctrl->reservas[i].hora_fin;
+    int num_pers = ctrl->reservas[i].num_personas;
+    int h;
+
+    ctrl->reservas[i] = ctrl->reservas[--ctrl->num_reservas];
+
+    ctrl->ocupacion[hora] -= num_pers;
+    reporte_ocupacion(&ctrl->reporte, hora, ctrl->ocupacion[hora]);
+    for (h = hora + 1; h < fin && h < ctrl->hora_fin; h++) {
+        ctrl->ocupacion[h] -= num_pers;
+        reporte_ocupacion(&ctrl->reporte, h, ctrl->ocupacion[h]);
+    }
+}
+
+/* **********************************************************************************************************
+ * cancelar_reserva                                                                                         *
+ *                                                                                                          *
+ * Quita la reserva mas reciente de la familia que aun no ha empezado, libera su bloque y revisa la lista   *
+ * de espera solo en las horas cuyo bloque toca las horas liberadas (con la duracion por defecto de 2h:    *
+ * h-1, h y h+1). t_ns es el instante del mensaje CANCELACION.                                              *
+ *                                                                                                          *
+ * Retorno: hora de inicio de la reserva cancelada, o -1 si la familia no tiene ninguna cancelable.         *
+ * **********************************************************************************************************/
+static int cancelar_reserva(controlador_t *ctrl, const char *familia, uint64_t t_ns,
+                            avisos_espera_t *avisos)
+{
+    int h_actual = atomic_load_explicit(&ctrl->hora_actual, memory_order_relaxed);
+    int i, h, hora, num_pers, promovidas = 0;
+
+    for (i = ctrl->num_reservas - 1; i >= 0; i--) {
+        if (ctrl->reservas[i].hora_inicio >= h_actual &&
+            strcmp(ctrl->reservas[i].nombre_familia, familia) == 0) {
+            break;
+        }
+    }
+    if (i < 0) return -1;
+
+    hora     = ctrl->reservas[i].hora_inicio;
+    num_pers = ctrl->reservas[i].num_personas;
+    liberar_reserva(ctrl, i);
+    replicar(ctrl, DELTA_LIBERACION, -1, familia, num_pers, hora, hora);
+    exportar(ctrl, t_ns, RESULTADO_CANCELADA, NULL, familia, num_pers, hora, hora);
+
+    /* ---- Promover solo en las horas afectadas ---- */
+    if (ctrl->espera.total > 0) {
+        for (h = hora - ctrl->duracion_reserva + 1; h < hora + ctrl->duracion_reserva; h++) {
+            promovidas += promover_espera(ctrl, h, t_ns, avisos);
+        }
+    }
+
+    reporte_espera(&ctrl->reporte, 0, promovidas, 0, 1);
+    return hora;
+}
+
+/* **********************************************************************************************************
+ * delta_valido                                                                                             *
+ *                                                                                                          *
+ * Las horas de un delta se usan como indice de la ocupacion: se revisan antes de aplicarlo.                *
+ *   - DELTA_HORA: dentro de [hora_ini, hora_fin] y posterior a la hora actual (el reloj no retrocede).     *
+ *   - DELTA_DECISION: -1 (negada) o una hora hasta el cierre inclusive (el primario puede asignar la hora  *
+ *     de cierre: cabe_bloque() solo revisa esa hora).                                                      *
+ *   - DELTA_RESERVA / DELTA_LIBERACION: una hora hasta el cierre inclusive.                                *
+ * **********************************************************************************************************/
+static int delta_valido(const controlador_t *ctrl, const delta_replica_t *d)
+{
+    switch (d->tipo) {
+    case DELTA_HORA:
+        return d->hora >= ctrl->hora_ini && d->hora <= ctrl->hora_fin && d->hora > CTRL_HORA_ACTUAL(ctrl);
+    case DELTA_DECISION:
+        return d->hora >= -1 && d->hora <= ctrl->hora_fin;
+    case DELTA_RESERVA:
+    case DELTA_LIBERACION:
+        return d->hora >= 0 && d->hora <= ctrl->hora_fin;
+    default:
+        return 0;
+    }
+}
+
+/* **********************************************************************************************************
+ * servidor_aplicar_replica                                                                                 *
+ *                                                                                                          *
+ * Lado respaldo: aplica un delta recibido del primario con la misma logica que lo produjo, sin decidir     *
+ * nada. Las decisiones no tienen agente (los totales por agente quedan solo en el primario). Los deltas    *
+ * con una hora fuera de rango se descartan y se avisa por stderr.                                          *
+ * **********************************************************************************************************/
+void servidor_aplicar_replica(controlador_t *ctrl, const delta_replica_t *d)
+{
+    delta_replica_t copia;
+    int i;
+
+    if (!delta_valido(ctrl, d)) {
+        fprintf(stderr, "[REPLICA] Delta descartado: tipo %d, hora %d (hora actual %d, horario %d-%d)\n",
+                d->tipo, d->hora, CTRL_HORA_ACTUAL(ctrl), ctrl->hora_ini, ctrl->hora_fin);
+        return;
+    }
+
+    if (d->tipo == DELTA_HORA) {
+        servidor_avanzar_reloj(ctrl, d->hora);
+        return;
+    }
+
+    /* ---- El nombre llega del socket: asegurar el terminador ---- */
+    copia = *d;
+    copia.familia[MAX_LONG_NOMBRE_FAMILIA - 1] = '\0';
+    d = &copia;
+
+    pthread_mutex_lock(&ctrl->mutex);
+
+    switch (d->tipo) {
+    case DELTA_DECISION:
+        if (d->respuesta == RESPUESTA_RESERVA_OK)               ctrl->contadores.solicitudes_ok++;
+        else if (d->respuesta == RESPUESTA_RESERVA_REPROGRAMADA) ctrl->contadores.solicitudes_reprogramadas++;
+        else                                                    ctrl->contadores.solicitudes_negadas++;
+
+        reporte_decision(&ctrl->reporte, (tipo_respuesta_t) d->respuesta, -1, NULL, d->familia,
+                         d->personas, d->hora_solicitada, d->hora);
+        exportar(ctrl, reloj_monotonico_ns(), d->respuesta, NULL, d->familia,
+                 d->personas, d->hora_solicitada, d->hora);
+        if (d->hora >= 0) {
+            ocupar_bloque(ctrl, d->familia, d->hora, d->personas);
+        }
+        break;
+
+    case DELTA_RESERVA:
+        ocupar_bloque(ctrl, d->familia, d->hora, d->personas);
+        exportar(ctrl, reloj_monotonico_ns(), RESULTADO_PROMOVIDA, NULL, d->familia,
+                 d->personas, d->hora, d->hora);
+        break;
+
+    case DELTA_LIBERACION:
+        for (i = ctrl->num_reservas - 1; i >= 0; i--) {
+            if (ctrl->reservas[i].hora_inicio == d->hora &&
+                strcmp(ctrl->reservas[i].nombre_familia, d->familia) == 0) {
+                liberar_reserva(ctrl, i);
+                reporte_espera(&ctrl->reporte, 0, 0, 0, 1);
+                exportar(ctrl, reloj_monotonico_ns(), RESULTADO_CANCELADA, NULL, d->familia,
+                         d->personas, d->hora, d->hora);
+                break;
+            }
+        }
+        break;
+    }
+
+    publicar_disponibilidad(ctrl);
+    pthread_mutex_unlock(&ctrl->mutex);
+}
+
+/* **********************************************************************************************************
+ * servidor_etiquetar_respuesta                                                                             *
+ *                                                                                                          *
+ * Un agente con varias solicitudes en vuelo por el mismo pipe agrega un identificador despues del campo    *
+ * de parque. La respuesta lo repite ("#id texto") y termina en '\n', para que el agente pueda separar las  *
+ * respuestas que lleguen juntas y asignar cada una a su solicitud. Sin identificador no se cambia nada.    *
+ * **********************************************************************************************************/
+void servidor_etiquetar_respuesta(char *respuesta, size_t tam_respuesta, const char *id_solicitud)
+{
+    char texto[MAX_LONG_MENSAJE];
+
+    if (id_solicitud == NULL || id_solicitud[0] == '\0' ||
+        id_solicitud[strspn(id_solicitud, "0123456789")] != '\0') {
+        return;
+    }
+
+    snprintf(texto, sizeof(texto), "%s", respuesta);
+    snprintf(respuesta, tam_respuesta, "#%.20s %s\n", id_solicitud, texto);
+}
+
+/* **********************************************************************************************************
+ * servidor_procesar_mensaje                                                                                *
+ *                                                                                                          *
+ * Procesa una linea completa recibida por el FIFO (o leida de una traza) y deja el texto de la respuesta   *
+ * y el pipe al que va dirigida. No escribe en ningun pipe: eso lo hace quien llama.                        *
+ *                                                                                                          *
+ * Retorno: 1 si hay respuesta para enviar; 0 si el mensaje no requiere respuesta o es invalido.            *
+ * **********************************************************************************************************/
+int servidor_procesar_mensaje(controlador_t *ctrl, mensaje_entrada_t *msg,
+                              char *respuesta, size_t tam_respuesta, char *pipe_destino)
+{
+    char *readbuf = msg->linea;
+
+    /* Punteros para strtok_r (reentrante: cada parque procesa en su propio hilo) */
+    char *tipo_msg, *p1, *p2, *p3, *p5, *id_solicitud;
+    char *resto = NULL;
+
+    msg->hora_actual = CTRL_HORA_ACTUAL(ctrl);
+
+    LOG_CTRL(ctrl, "[AGENTES] Recibido: \"%s\"\n", readbuf);
+
+    /* ---- PARSEO DEL MENSAJE (usamos strtok_r sobre el buffer) ---- */
+    tipo_msg = strtok_r(readbuf, ";", &resto);
+
+    if (tipo_msg == NULL) {
+        return 0;
+    }
+
+    /* ================= CASO REGISTRO ================= */
+    if (strcmp(tipo_msg, "REGISTRO") == 0) {
+        p1 = strtok_r(NULL, ";", &resto); // Nombre Agente
+        p2 = strtok_r(NULL, ";", &resto); // Pipe Respuesta
+
+        if (p1 && p2) {
+            latencia_marcar(msg->muestra, MARCA_PARSEADO);
+
+            LOG_CTRL(ctrl, "[CTRL] Registrando Agente: %s\n", p1);
+            admision_buscar_agente(&ctrl->admision, p1, p2, msg->t_ns);
+
+            /* La hora es atomica: el registro ya no necesita el mutex */
+            latencia_marcar(msg->muestra, MARCA_BLOQUEO);
+            int h_actual = CTRL_HORA_ACTUAL(ctrl);
+            latencia_marcar(msg->muestra, MARCA_DECISION);
+
+            msg->hora_actual = h_actual;
+            snprintf(respuesta, tam_respuesta, "%d", h_actual);
+            strncpy(pipe_destino, p2, MAX_LONG_NOMBRE_PIPE - 1);
+            pipe_destino[MAX_LONG_NOMBRE_PIPE - 1] = '\0';
+            return 1;
+        }
+    }
+    /* ================= CASO SOLICITUD ================= */
+    else if (strcmp(tipo_msg, "SOLICITUD") == 0) {
+        p1 = strtok_r(NULL, ";", &resto); // Familia
+        p2 = strtok_r(NULL, ";", &resto); // Personas
+        p3 = strtok_r(NULL, ";", &resto); // Hora Inicio
+        strtok_r(NULL, ";", &resto);      // Hora Fin (no se usa, la duracion la fija el controlador)
+        p5 = strtok_r(NULL, ";", &resto); // Pipe Respuesta
+        strtok_r(NULL, ";", &resto);      // Parque (lo usa el enrutador multi-parque)
+        id_solicitud = strtok_r(NULL, ";", &resto);
+
+        if (p1 && p2 && p3 && p5) {
+            int num_pers = atoi(p2);
+            int h_ini    = atoi(p3);
+            strncpy(pipe_destino, p5, MAX_LONG_NOMBRE_PIPE - 1);
+            pipe_destino[MAX_LONG_NOMBRE_PIPE - 1] = '\0';
+
+            latencia_marcar(msg->muestra, MARCA_PARSEADO);
+
+            char *texto_respuesta = respuesta;
+
+            /* --- RUTA RAPIDA: sobrecarga o agente por encima de su tasa, sin tomar el mutex --- */
+            int reintento_ms = 0;
+            int idx_agente   = admision_buscar_agente(&ctrl->admision, NULL, pipe_destino, msg->t_ns);
+
+            if (!admision_evaluar(&ctrl->admision, msg->pendientes, idx_agente, msg->t_ns,
+                                  &reintento_ms)) {
+                snprintf(texto_respuesta, tam_respuesta,
+                         "OCUPADO: reintentar en %d ms", reintento_ms);
+                LOG_CTRL(ctrl, "[CTRL] Ocupado para %s (reintentar en %d ms)\n", p1, reintento_ms);
+                servidor_etiquetar_respuesta(texto_respuesta, tam_respuesta, id_solicitud);
+                return 1;
+            }
+
+            tipo_respuesta_t tipo       = RESPUESTA_RESERVA_NEGADA_SIN_CUPO;
+            int              h_asignada = -1;
+
+            /* --- RUTA CRITICA --- */
+            pthread_mutex_lock(&ctrl->mutex);
+            latencia_marcar(msg->muestra, MARCA_BLOQUEO);
+
+            /* Con el mutex tomado la hora no cambia (el reloj tambien lo toma) */
+            int h_actual = atomic_load_explicit(&ctrl->hora_actual, memory_order_relaxed);
+            msg->hora_actual = h_actual;
+
+            /* 0. Número de personas mayor al aforo permitido -> negada directa */
+            if (num_pers > ctrl->aforo_maximo) {
+                ctrl->contadores.solicitudes_negadas++;
+                tipo = RESPUESTA_RESERVA_NEGADA_AFORO;
+                snprintf(texto_respuesta, tam_respuesta,
+                        "NEGADA: Excede aforo maximo (%d)", ctrl->aforo_maximo);
+                LOG_CTRL(ctrl, "[CTRL] Rechazada %s (Excede aforo: %d > %d)\n",
+                       p1, num_pers, ctrl->aforo_maximo);
+            }
+            /* 1. Hora ya pasó (extemporánea): intentar reprogramar más adelante */
+            else if (h_ini < h_actual) {
+                int h_busca = buscar_bloque(ctrl, h_actual, num_pers);
+
+                if (h_busca != -1) {
+                    ocupar_bloque(ctrl, p1, h_busca, num_pers);
+                    h_asignada = h_busca;
+                    ctrl->contadores.solicitudes_reprogramadas++;
+                    tipo = RESPUESTA_RESERVA_REPROGRAMADA;
+                    snprintf(texto_respuesta, tam_respuesta,
+                            "REPROGRAMADA: %d:00 (solicitada %d:00)",
+                            h_busca, h_ini);
+                    LOG_CTRL(ctrl, "[CTRL] Reprogramada %s (%d p) de %d:00 a %d:00\n",
+                           p1, num_pers, h_ini, h_busca);
+                } else {
+                    ctrl->contadores.solicitudes_negadas++;
+                    tipo = RESPUESTA_RESERVA_NEGADA_EXTEMP;
+                    snprintf(texto_respuesta, tam_respuesta,
+                            "NEGADA: Hora %d ya paso y sin cupo posterior", h_ini);
+                    LOG_CTRL(ctrl, "[CTRL] Rechazada %s (Extemporanea sin cupo)\n", p1);
+                }
+            }
+            /* 2. Hora solicitada mayor que horaFin -> negada, debe volver otro día */
+            else if (h_ini > ctrl->hora_fin) {
+                ctrl->contadores.solicitudes_negadas++;
+                tipo = RESPUESTA_RESERVA_NEGADA_EXTEMP;
+                snprintf(texto_respuesta, tam_respuesta,
+                        "NEGADA: Hora %d fuera del rango de atencion", h_ini);
+                LOG_CTRL(ctrl, "[CTRL] Rechazada %s (Fuera de rango)\n", p1);
+            }
+            /* 3. Hora vigente dentro de rango */
+            else {
+                /* La hora solicitada o la primera posterior en la que cabe todo el bloque (a la hora
+                 * de cierre solo se revisa ella misma) */
+                int h_busca = (h_ini < ctrl->hora_fin) ? buscar_bloque(ctrl, h_ini, num_pers)
+                            : (cabe_bloque(ctrl, h_ini, num_pers) ? h_ini : -1);
+
+                if (h_busca == h_ini) {
+                    /* ACEPTAR en la hora solicitada */
+                    ocupar_bloque(ctrl, p1, h_ini, num_pers);
+                    h_asignada = h_ini;
+                    ctrl->contadores.solicitudes_ok++;
+                    tipo = RESPUESTA_RESERVA_OK;
+                    snprintf(texto_respuesta, tam_respuesta, "RESERVA OK: %d:00", h_ini);
+                    LOG_CTRL(ctrl, "[CTRL] Aceptada %s (%d p) %d:00\n",
+                           p1, num_pers, h_ini);
+                } else if (h_busca != -1) {
+                    /* No cabe en la hora pedida: reprogramar a la primera hora posterior */
+                    ocupar_bloque(ctrl, p1, h_busca, num_pers);
+                    h_asignada = h_busca;
+                    ctrl->contadores.solicitudes_reprogramadas++;
+                    tipo = RESPUESTA_RESERVA_REPROGRAMADA;
+                    snprintf(texto_respuesta, tam_respuesta,
+                            "REPROGRAMADA: %d:00 (solicitada %d:00)",
+                            h_busca, h_ini);
+                    LOG_CTRL(ctrl, "[CTRL] Reprogramada %s (%d p) de %d:00 a %d:00\n",
+                           p1, num_pers, h_ini, h_busca);
+                } else {
+                    ctrl->contadores.solicitudes_negadas++;
+                    tipo = RESPUESTA_RESERVA_NEGADA_SIN_CUPO;
+
+                    /* Con lista de espera, la solicitud queda esperando su hora pedida */
+                    if (ctrl->espera.activa && h_ini < ctrl->hora_fin &&
+                        espera_encolar(&ctrl->espera, h_ini, p1, num_pers, pipe_destino) > 0) {
+                        reporte_espera(&ctrl->reporte, 1, 0, 0, 0);
+                        snprintf(texto_respuesta, tam_respuesta,
+                                "NEGADA: Sin cupo en ningun bloque de %d horas "
+                                "(en lista de espera para las %d:00)",
+                                ctrl->duracion_reserva, h_ini);
+                        LOG_CTRL(ctrl, "[CTRL] Rechazada %s (Sin cupo, en espera para %d:00)\n",
+                               p1, h_ini);
+                    } else {
+                        snprintf(texto_respuesta, tam_respuesta,
+                                "NEGADA: Sin cupo en ningun bloque de %d horas",
+                                ctrl->duracion_reserva);
+                        LOG_CTRL(ctrl, "[CTRL] Rechazada %s (Sin cupo en el dia)\n", p1);
+                    }
+                }
+            }
+
+            /* ---- Actualizar el reporte incremental (O(1) por decision) ---- */
+            reporte_decision(&ctrl->reporte, tipo, idx_agente,
+                             (idx_agente >= 0) ? ctrl->admision.agentes[idx_agente].nombre : NULL,
+                             p1, num_pers, h_ini, h_asignada);
+            replicar(ctrl, DELTA_DECISION, tipo, p1, num_pers, h_ini, h_asignada);
+            exportar(ctrl, msg->t_ns, tipo,
+                     (idx_agente >= 0) ? ctrl->admision.agentes[idx_agente].nombre : NULL,
+                     p1, num_pers, h_ini, h_asignada);
+
+            if (h_asignada >= 0) {
+                publicar_disponibilidad(ctrl);
+            }
+
+            latencia_marcar(msg->muestra, MARCA_DECISION);
+            pthread_mutex_unlock(&ctrl->mutex);
+            /* --- FIN RUTA CRITICA --- */
+
+            servidor_etiquetar_respuesta(texto_respuesta, tam_respuesta, id_solicitud);
+            return 1;
+        }
+    }
+    /* ================= CASO CANCELACION ================= */
+    else if (strcmp(tipo_msg, "CANCELACION") == 0) {
+        p1 = strtok_r(NULL, ";", &resto); // Familia
+        p2 = strtok_r(NULL, ";", &resto); // Pipe Respuesta
+        strtok_r(NULL, ";", &resto);      // Parque
+        id_solicitud = strtok_r(NULL, ";", &resto);
+
+        if (p1 && p2) {
+            avisos_espera_t avisos;
+            int             hora;
+
+            avisos.num = 0;
+            latencia_marcar(msg->muestra, MARCA_PARSEADO);
+
+            pthread_mutex_lock(&ctrl->mutex);
+            latencia_marcar(msg->muestra, MARCA_BLOQUEO);
+
+            msg->hora_actual = atomic_load_explicit(&ctrl->hora_actual, memory_order_relaxed);
+            hora = cancelar_reserva(ctrl, p1, msg->t_ns, &avisos);
+            if (hora >= 0) {
+                publicar_disponibilidad(ctrl);
+            }
+
+            latencia_marcar(msg->muestra, MARCA_DECISION);
+            pthread_mutex_unlock(&ctrl->mutex);
+
+            if (hora >= 0) {
+                snprintf(respuesta, tam_respuesta, "CANCELADA: %s %d:00", p1, hora);
+                LOG_CTRL(ctrl, "[CTRL] Cancelada %s %d:00 (%d promovidas)\n", p1, hora, avisos.num);
+            } else {
+                snprintf(respuesta, tam_respuesta, "NEGADA: Sin reserva cancelable para %s", p1);
+                LOG_CTRL(ctrl, "[CTRL] Cancelacion sin reserva para %s\n", p1);
+            }
+
+            enviar_avisos(ctrl, &avisos);
+            servidor_etiquetar_respuesta(respuesta, tam_respuesta, id_solicitud);
+
+            strncpy(pipe_destino, p2, MAX_LONG_NOMBRE_PIPE - 1);
+            pipe_destino[MAX_LONG_NOMBRE_PIPE - 1] = '\0';
+            return 1;
+        }
+    }
+    /* ================= CASO DISPONIBILIDAD (solo lectura, sin mutex) ================= */
+    else if (strcmp(tipo_msg, "DISPONIBILIDAD") == 0) {
+        p1 = strtok_r(NULL, ";", &resto); // Pipe Respuesta
+        strtok_r(NULL, ";", &resto);      // Parque
+        id_solicitud = strtok_r(NULL, ";", &resto);
+
+        if (p1) {
+            vista_disponibilidad_t vista;
+
+            latencia_marcar(msg->muestra, MARCA_PARSEADO);
+            if (disponibilidad_leer(ctrl->disponibilidad.inst, &vista) != 0) {
+                /* El reloj no termino de publicar: con el mutex no hay escritura en curso */
+                pthread_mutex_lock(&ctrl->mutex);
+                disponibilidad_leer(ctrl->disponibilidad.inst, &vista);
+                pthread_mutex_unlock(&ctrl->mutex);
+            }
+            latencia_marcar(msg->muestra, MARCA_DECISION);
+
+            msg->hora_actual = vista.hora_actual;
+            disponibilidad_formatear(&vista, respuesta, tam_respuesta);
+            servidor_etiquetar_respuesta(respuesta, tam_respuesta, id_solicitud);
+            strncpy(pipe_destino, p1, MAX_LONG_NOMBRE_PIPE - 1);
+            pipe_destino[MAX_LONG_NOMBRE_PIPE - 1] = '\0';
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* **********************************************************************************************************
+ * lector_inicializar / lector_leer / lector_siguiente                                                      *
+ *                                                                                                          *
+ * Lectura del FIFO por bloques, separando los mensajes por '\n'. Bajo carga varios mensajes llegan en un   *
+ * mismo read(); el resto incompleto de una linea se conserva para la siguiente lectura. Lo usan el hilo de *
+ * agentes y el enrutador del modo multi-parque. lector_leer_sondeando es igual pero gira antes de          *
+ * bloquearse (modo de baja latencia).                                                                      *
+ * **********************************************************************************************************/
+void lector_inicializar(lector_lineas_t *l)
+{
+    l->usados = 0;
+    l->inicio = 0;
+}
+
+static void lector_preparar(lector_lineas_t *l)
+{
+    /* ---- Mover el resto incompleto al inicio del buffer ---- */
+    if (l->inicio > 0) {
+        l->usados -= l->inicio;
+        memmove(l->buffer, l->buffer + l->inicio, l->usados);
+        l->inicio = 0;
+    }
+
+    /* ---- Si el buffer se lleno sin encontrar '\n', la linea es invalida: se descarta ---- */
+    if (l->usados >= (int) sizeof(l->buffer) - 1) {
+        fprintf(stderr, "[AGENTES] Mensaje demasiado largo, descartado.\n");
+        l->usados = 0;
+    }
+}
+
+int lector_leer(lector_lineas_t *l, int fd)
+{
+    lector_preparar(l);
+
+    int read_bytes = read(fd, l->buffer + l->usados, sizeof(l->buffer) - 1 - l->usados);
+    if (read_bytes > 0) {
+        l->usados += read_bytes;
+        l->buffer[l->usados] = '\0';
+    }
+
+    return read_bytes;
+}
+
+int lector_leer_sondeando(lector_lineas_t *l, int fd, sondeo_t *s)
+{
+    lector_preparar(l);
+
+    int read_bytes = (int) sondeo_leer(s, fd, l->buffer + l->usados, sizeof(l->buffer) - 1 - l->usados);
+    if (read_bytes > 0) {
+        l->usados += read_bytes;
+        l->buffer[l->usados] = '\0';
+    }
+
+    return read_bytes;
+}
+
+char *lector_siguiente(lector_lineas_t *l, int *longitud, int *pendientes_locales)
+{
+    char *inicio    = l->buffer + l->inicio;
+    char *fin_linea = strchr(inicio, '\n');
+
+    if (fin_linea == NULL) {
+        return NULL;
+    }
+
+    *fin_linea          = '\0';
+    *longitud           = (int) (fin_linea - inicio);
+    l->inicio           = (int) (fin_linea + 1 - l->buffer);
+    *pendientes_locales = l->usados - l->inicio;
+
+    return inicio;
+}
+
+/* **********************************************************************************************************
+ * servidor_hilo_agentes                                                                                    *
+ *                                                                                                          *
+ * Atiende los mensajes del FIFO de entrada en orden de llegada y responde a cada agente.                   *
  * **********************************************************************************************************/
 void *servidor_hilo_agentes(void *arg)
 {
     controlador_t *ctrl = (controlador_t *) arg;
 
-    char readbuf[MAX_LONG_MENSAJE];
-    char msg_resp[MAX_LONG_MENSAJE];
+    lector_lineas_t lector;
+    char copia_traza[MAX_LONG_MENSAJE * 4];
+    char texto_respuesta[MAX_LONG_MENSAJE];
     char pipe_resp[MAX_LONG_NOMBRE_PIPE];
     int  read_bytes;
-    int  fd_resp;
 
-    /* Punteros para strtok */
-    char *tipo_msg, *p1, *p2, *p3, *p4, *p5;
+    lector_inicializar(&lector);
 
-    /* ---- Bucle principal de atencion de agentes ---- */
-    while (ctrl->simulacion_activa) {
+    /* ---- Baja latencia: este hilo es el unico en su nucleo (main ya lo quito a los demas) ---- */
+    if (ctrl->sondeo.activo) {
+        sondeo_fijar_nucleo(ctrl->sondeo.nucleo);
+    }
 
-        /* Limpiar buffer */
-        /* function is used to set a block of memory to a specific value. It is commonly used for initializing memory to zero or any other value efficiently. */
-        memset(readbuf, 0, sizeof(readbuf));
-        
+    /* ---- Bucle principal de atencion de agentes ---- */
+    while (CTRL_ACTIVO(ctrl)) {
 
-        /* ---- Bloquea esperando datos desde el FIFO ---- */
-        read_bytes = read(ctrl->fifo_fd, readbuf, sizeof(readbuf) - 1);
+        /* ---- Bloquea esperando datos desde el FIFO (o gira y luego se bloquea). Las respuestas en
+         *      cola salen antes: si no hay nada que leer, o siempre antes de girar ---- */
+        if (ctrl->sondeo.activo) {
+            salida_vaciar(&ctrl->salida);
+            read_bytes = lector_leer_sondeando(&lector, ctrl->fifo_fd, &ctrl->sondeo);
+        } else {
+            salida_esperar_entrada(&ctrl->salida, ctrl->fifo_fd, -1);
+            read_bytes = lector_leer(&lector, ctrl->fifo_fd);
+        }
         
         if (read_bytes <= 0) {
             // Si es error real o EOF inesperado
             if (read_bytes < 0 && errno != EINTR) {
                 // Si el simulador sigue activo, es un error. Si no, es cierre normal.
-                if (ctrl->simulacion_activa) perror("[AGENTES] read(FIFO)");
+                if (CTRL_ACTIVO(ctrl)) perror("[AGENTES] read(FIFO)");
             }
             continue;
         }
 
-        /* ---- Termina la cadena y normaliza: quita salto de linea ---- */
-        readbuf[read_bytes] = '\0';
-        if (readbuf[strlen(readbuf) - 1] == '\n') {
-            readbuf[strlen(readbuf) - 1] = '\0';
-        }
+        /* ---- Procesar cada linea completa del buffer ---- */
+        char *linea;
+        int   longitud, pendientes_locales = 0;
 
-        /* Si recibe "end" (enviado por el reloj al finalizar), terminamos */
-        if (strcmp(readbuf, "end") == 0) {
-            break;
-        }
+        while ((linea = lector_siguiente(&lector, &longitud, &pendientes_locales)) != NULL) {
 
-        printf("[AGENTES] Recibido: \"%s\"\n", readbuf);
-
-        /* ---- PARSEO DEL MENSAJE (usamos strtok sobre el buffer) ---- */
-        tipo_msg = strtok(readbuf, ";");
-
-        if (tipo_msg != NULL) {
-            
-            /* ================= CASO REGISTRO ================= */
-            if (strcmp(tipo_msg, "REGISTRO") == 0) {
-                p1 = strtok(NULL, ";"); // Nombre Agente
-                p2 = strtok(NULL, ";"); // Pipe Respuesta
-
-                if (p1 && p2) {
-                    printf("[CTRL] Registrando Agente: %s\n", p1);
-                    
-                    pthread_mutex_lock(&ctrl->mutex);
-                    int h_actual = ctrl->hora_actual;
-                    pthread_mutex_unlock(&ctrl->mutex);
-
-                    fd_resp = open(p2, O_WRONLY);
-                    if (fd_resp != -1) {
-                        snprintf(msg_resp, sizeof(msg_resp), "%d", h_actual);
-                        write(fd_resp, msg_resp, strlen(msg_resp));
-                        close(fd_resp);
-                    }
-                }
+            /* Si recibe "end" (enviado por el reloj al finalizar), terminamos */
+            if (strcmp(linea, "end") == 0) {
+                return NULL;
             }
-            /* ================= CASO SOLICITUD ================= */
-            else if (strcmp(tipo_msg, "SOLICITUD") == 0) {
-                p1 = strtok(NULL, ";"); // Familia
-                p2 = strtok(NULL, ";"); // Personas
-                p3 = strtok(NULL, ";"); // Hora Inicio
-                p4 = strtok(NULL, ";"); // Hora Fin (no se usa, reserva fija de 2h)
-                p5 = strtok(NULL, ";"); // Pipe Respuesta
-
-                if (p1 && p2 && p3 && p5) {
-                    int num_pers = atoi(p2);
-                    int h_ini    = atoi(p3);
-                    strcpy(pipe_resp, p5);
-                    
-                    char texto_respuesta[128];
-                    
-                    /* --- RUTA CRITICA --- */
-                    pthread_mutex_lock(&ctrl->mutex);
-
-                    /* 0. Número de personas mayor al aforo permitido -> negada directa */
-                    if (num_pers > ctrl->aforo_maximo) {
-                        ctrl->solicitudes_negadas++;
-                        sprintf(texto_respuesta,
-                                "NEGADA: Excede aforo maximo (%d)", ctrl->aforo_maximo);
-                        printf("[CTRL] Rechazada %s (Excede aforo: %d > %d)\n",
-                               p1, num_pers, ctrl->aforo_maximo);
-                    }
-                    /* 1. Hora ya pasó (extemporánea): intentar reprogramar más adelante */
-                    else if (h_ini < ctrl->hora_actual) {
-                        int h_busca;
-                        int asignada = 0;
-
-                        for (h_busca = ctrl->hora_actual; h_busca < ctrl->hora_fin; h_busca++) {
-                            int cabe_h1 = (ctrl->horas[h_busca].ocupacion_actual + num_pers)
-                                          <= ctrl->aforo_maximo;
-                            int cabe_h2 = 1;
-                            if (h_busca + 1 < ctrl->hora_fin) {
-                                cabe_h2 = (ctrl->horas[h_busca + 1].ocupacion_actual + num_pers)
-                                          <= ctrl->aforo_maximo;
-                            }
-
-                            if (cabe_h1 && cabe_h2) {
-                                ctrl->horas[h_busca].ocupacion_actual += num_pers;
-                                if (h_busca + 1 < ctrl->hora_fin) {
-                                    ctrl->horas[h_busca + 1].ocupacion_actual += num_pers;
-                                }
-                                ctrl->solicitudes_reprogramadas++;
-                                sprintf(texto_respuesta,
-                                        "REPROGRAMADA: %d:00 (solicitada %d:00)",
-                                        h_busca, h_ini);
-                                printf("[CTRL] Reprogramada %s (%d p) de %d:00 a %d:00\n",
-                                       p1, num_pers, h_ini, h_busca);
-                                asignada = 1;
-                                break;
-                            }
-                        }
-
-                        if (!asignada) {
-                            ctrl->solicitudes_negadas++;
-                            sprintf(texto_respuesta,
-                                    "NEGADA: Hora %d ya paso y sin cupo posterior", h_ini);
-                            printf("[CTRL] Rechazada %s (Extemporanea sin cupo)\n", p1);
-                        }
-                    }
-                    /* 2. Hora solicitada mayor que horaFin -> negada, debe volver otro día */
-                    else if (h_ini > ctrl->hora_fin) {
-                        ctrl->solicitudes_negadas++;
-                        sprintf(texto_respuesta,
-                                "NEGADA: Hora %d fuera del rango de atencion", h_ini);
-                        printf("[CTRL] Rechazada %s (Fuera de rango)\n", p1);
-                    }
-                    /* 3. Hora vigente dentro de rango */
-                    else {
-                        /* Revisamos la hora solicitada y la siguiente (reserva de 2h) */
-                        int cabe_h1 = (ctrl->horas[h_ini].ocupacion_actual + num_pers)
-                                      <= ctrl->aforo_maximo;
-                        int cabe_h2 = 1; 
-                        if (h_ini + 1 < ctrl->hora_fin) {
-                            cabe_h2 = (ctrl->horas[h_ini + 1].ocupacion_actual + num_pers)
-                                      <= ctrl->aforo_maximo;
-                        }
-
-                        if (cabe_h1 && cabe_h2) {
-                            /* ACEPTAR en la hora solicitada */
-                            ctrl->horas[h_ini].ocupacion_actual += num_pers;
-                            if (h_ini + 1 < ctrl->hora_fin) {
-                                ctrl->horas[h_ini + 1].ocupacion_actual += num_pers;
-                            }
-                            ctrl->solicitudes_ok++;
-                            sprintf(texto_respuesta, "RESERVA OK: %d:00", h_ini);
-                            printf("[CTRL] Aceptada %s (%d p) %d:00\n",
-                                   p1, num_pers, h_ini);
-                        } else {
-                            /* No cabe en la hora pedida: intentar reprogramar a horas posteriores */
-                            int h_busca;
-                            int asignada = 0;
-
-                            for (h_busca = h_ini + 1; h_busca < ctrl->hora_fin; h_busca++) {
-                                int cabe_r1 = (ctrl->horas[h_busca].ocupacion_actual + num_pers)
-                                              <= ctrl->aforo_maximo;
-                                int cabe_r2 = 1;
-                                if (h_busca + 1 < ctrl->hora_fin) {
-                                    cabe_r2 = (ctrl->horas[h_busca + 1].ocupacion_actual + num_pers)
-                                              <= ctrl->aforo_maximo;
-                                }
-
-                                if (cabe_r1 && cabe_r2) {
-                                    ctrl->horas[h_busca].ocupacion_actual += num_pers;
-                                    if (h_busca + 1 < ctrl->hora_fin) {
-                                        ctrl->horas[h_busca + 1].ocupacion_actual += num_pers;
-                                    }
-                                    ctrl->solicitudes_reprogramadas++;
-                                    sprintf(texto_respuesta,
-                                            "REPROGRAMADA: %d:00 (solicitada %d:00)",
-                                            h_busca, h_ini);
-                                    printf("[CTRL] Reprogramada %s (%d p) de %d:00 a %d:00\n",
-                                           p1, num_pers, h_ini, h_busca);
-                                    asignada = 1;
-                                    break;
-                                }
-                            }
-
-                            if (!asignada) {
-                                ctrl->solicitudes_negadas++;
-                                sprintf(texto_respuesta,
-                                        "NEGADA: Sin cupo en ningun bloque de 2 horas");
-                                printf("[CTRL] Rechazada %s (Sin cupo en el dia)\n", p1);
-                            }
-                        }
-                    }
 
-                    pthread_mutex_unlock(&ctrl->mutex);
-                    /* --- FIN RUTA CRITICA --- */
+            if (linea[0] == '\0') {
+                continue;
+            }
 
-                    /* ---- Responder al agente ---- */
-                    fd_resp = open(pipe_resp, O_WRONLY);
-                    if (fd_resp != -1) {
-                        write(fd_resp, texto_respuesta, strlen(texto_respuesta));
-                        close(fd_resp);
-                    }
-                }
+            mensaje_entrada_t  msg;
+            muestra_latencia_t muestra;
+
+            msg.linea      = linea;
+            msg.t_ns       = reloj_monotonico_ns();
+            msg.pendientes = admision_pendientes_fifo(&ctrl->admision, ctrl->fifo_fd,
+                                                      pendientes_locales);
+            msg.muestra    = latencia_muestrear(&ctrl->latencia, &muestra);
+            if (msg.muestra != NULL) {
+                msg.muestra->t[MARCA_RECIBIDO] = msg.t_ns;
+            }
+
+            /* strtok_r modifica la linea: se copia antes si hay que grabarla */
+            if (ctrl->traza != NULL) {
+                memcpy(copia_traza, linea, longitud + 1);
+            }
+
+            /* Tras strtok_r, msg.linea quedo reducida al tipo de mensaje. La muestra de un mensaje
+             * con respuesta se cierra cuando el writev() la entrega (ver salida.h) */
+            if (servidor_procesar_mensaje(ctrl, &msg, texto_respuesta,
+                                          sizeof(texto_respuesta), pipe_resp)) {
+                salida_encolar(&ctrl->salida, pipe_resp, texto_respuesta, msg.muestra, msg.linea);
+            } else {
+                salida_registrar(&ctrl->salida, msg.muestra, msg.linea);
+            }
+            salida_vencer(&ctrl->salida);
+
+            if (ctrl->traza != NULL) {
+                traza_grabar(ctrl->traza, msg.t_ns, msg.hora_actual, msg.pendientes,
+                             copia_traza, longitud);
             }
         }
+
+        /* ---- Antes de volver a bloquearse, llevar la traza a disco ---- */
+        if (ctrl->traza != NULL && pendientes_locales == 0) {
+            traza_vaciar(ctrl->traza);
+        }
     }
 
     return NULL;
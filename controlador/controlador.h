@@ -18,7 +18,11 @@
 #define __CONTROLADOR_H__
 
 /***************************************** Headers **********************************************************/
+#include <stdio.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
 
 #define HORA_MINIMA_SIMULACION        7
 #define HORA_MAXIMA_SIMULACION        19
@@ -29,7 +33,10 @@
 #define MAX_LONG_NOMBRE_PIPE          128
 #define MAX_LONG_MENSAJE              256
 
-#define MAX_RESERVAS_POR_HORA         128
+#define RESERVAS_INICIALES            256     /* Capacidad inicial del registro de reservas  */
+#define DURACION_RESERVA_DEFECTO      2       /* Horas que ocupa cada reserva                */
+#define TAM_LINEA_CACHE               64
+
 
 /* ---- Tipos de respuesta ---- */
 typedef enum {
@@ -37,9 +44,19 @@ typedef enum {
     RESPUESTA_RESERVA_REPROGRAMADA,
     RESPUESTA_RESERVA_NEGADA_EXTEMP,
     RESPUESTA_RESERVA_NEGADA_SIN_CUPO,
-    RESPUESTA_RESERVA_NEGADA_AFORO
+    RESPUESTA_RESERVA_NEGADA_AFORO,
+    RESPUESTA_OCUPADO
 } tipo_respuesta_t;
 
+#include "admision.h"
+#include "reporte.h"
+#include "latencia.h"
+#include "espera.h"
+#include "disponibilidad.h"
+#include "sondeo.h"
+#include "salida.h"
+#include "nucleo.h"
+
 /* ---- Solicitud que envia el agente ---- */
 typedef struct {
     char nombre_agente[MAX_LONG_NOMBRE_AGENTE];
@@ -64,47 +81,163 @@ typedef struct {
     char             mensaje[MAX_LONG_MENSAJE];
 } respuesta_reserva_t;
 
-/* ---- Estado de una hora especifica ---- */
+/* ---- Contadores de decisiones ----
+ * Los escribe solo el hilo que decide (con el mutex tomado). Van en su propia linea de cache para que
+ * esas escrituras no invaliden la del mutex ni la de la hora, que leen todos los hilos.
+ */
 typedef struct {
-    int hora;
-    int ocupacion_actual;
-    int aforo_maximo;
+    _Alignas(TAM_LINEA_CACHE) int solicitudes_negadas;
+    int solicitudes_ok;
+    int solicitudes_reprogramadas;
+} contadores_ctrl_t;
+
+/* ---- Mensaje recibido por el FIFO, con el contexto que usa el control de admision ---- */
+typedef struct {
+    char     *linea;          /* Linea sin '\n' (se modifica al parsear)                    */
+    uint64_t  t_ns;           /* Instante de llegada (CLOCK_MONOTONIC)                      */
+    int       pendientes;     /* Bytes en cola detras del mensaje (marca de agua)           */
+    int       hora_actual;    /* Salida: hora de simulacion usada al decidir                */
 
-    int       num_reservas;
-    reserva_t reservas[MAX_RESERVAS_POR_HORA];
-} estado_hora_t;
+    muestra_latencia_t *muestra;  /* Marcas de latencia, NULL si el mensaje no se mide     */
+} mensaje_entrada_t;
 
-/* ---- Estado global del Controlador ---- */
+/* ---- Buffer de lectura del FIFO, separado en lineas ---- */
+typedef struct {
+    char buffer[MAX_LONG_MENSAJE * 4];
+    int  usados;
+    int  inicio;              /* Desplazamiento de la siguiente linea por procesar      */
+} lector_lineas_t;
+
+struct traza;
+struct replica;
+struct delta_replica;
+struct exportacion;
+
+/* ---- Estado global del Controlador ----
+ * Ordenado por quien escribe cada parte y con que frecuencia:
+ *   - configuracion (solo lectura durante la simulacion);
+ *   - hora y bandera de simulacion: las escribe el reloj una vez por hora y las leen todos los hilos;
+ *   - mutex: lo disputan el reloj y el hilo que decide;
+ *   - ocupacion por hora: densa (25 enteros en dos lineas), la recorre cada decision;
+ *   - contadores del hilo que decide;
+ *   - resto (admision, reporte, latencia, registro de reservas, lista de espera), que no esta en la ruta
+ *     de cada decision.
+ * La estructura queda alineada a TAM_LINEA_CACHE: si se reserva en el heap, usar aligned_alloc.
+ */
 typedef struct {
     int hora_ini;
     int hora_fin;
-    int hora_actual;
     int segundos_por_hora;
     int aforo_maximo;
+    int duracion_reserva;      /* Horas consecutivas que ocupa cada reserva (<= 0: por defecto) */
+    nucleo_admision_t nucleo;  /* Busqueda de bloque: de sede o generica (ver nucleo.h)         */
 
-    int solicitudes_negadas;
-    int solicitudes_ok;
-    int solicitudes_reprogramadas;
+    /* ---- Leidas sin mutex por otros hilos: atomicas (escritura release, lectura acquire) ---- */
+    _Alignas(TAM_LINEA_CACHE) atomic_int hora_actual;
+    atomic_int simulacion_activa;
+
+    /* --- AGREGADO: Mutex para sincronizacion --- */
+    _Alignas(TAM_LINEA_CACHE) pthread_mutex_t mutex;
 
-    estado_hora_t horas[MAX_HORAS_DIA + 1];
-    
-    pthread_t hilo_reloj, hilo_agentes;
+    /* ---- Ocupacion por hora (protegida por el mutex) ---- */
+    _Alignas(TAM_LINEA_CACHE) int ocupacion[MAX_HORAS_DIA + 1];
+
+    contadores_ctrl_t contadores;
+
+    /* ================= Datos frios ================= */
+
+    _Alignas(TAM_LINEA_CACHE) pthread_t hilo_reloj, hilo_agentes;
 
     char pipe_entrada[MAX_LONG_NOMBRE_PIPE];
     int  fifo_fd;
 
-    char simulacion_activa;
+    /* ---- Modo de baja latencia: el hilo de agentes gira sobre el FIFO (ver sondeo.h) ---- */
+    sondeo_t sondeo;
 
-    /* --- AGREGADO: Mutex para sincronizacion --- */
-    pthread_mutex_t mutex; 
+    /* ---- Respuestas encoladas por agente y enviadas con writev (0 us = de inmediato) ---- */
+    int                 plazo_respuestas_us;
+    salida_respuestas_t salida;
+
+    /* ---- Registro de reservas concedidas (protegido por el mutex; crece con realloc) ---- */
+    reserva_t *reservas;
+    int        num_reservas;
+    int        capacidad_reservas;
+
+    /* ---- Control de admision (limites por agente y marca de agua del FIFO) ---- */
+    double     tasa_por_agente;
+    double     rafaga_por_agente;
+    int        marca_agua_fifo;
+    admision_t admision;
+
+    /* ---- Reporte incremental (se actualiza con el mutex tomado) ---- */
+    reporte_t  reporte;
+
+    /* ---- Latencia por etapas (muestreo 1 de cada N mensajes, 0 = desactivada) ---- */
+    int        muestreo_latencia;
+    char       ruta_eventos_chrome[MAX_LONG_NOMBRE_PIPE];
+    latencia_t latencia;
+
+    /* ---- Lista de espera de solicitudes sin cupo (protegida por el mutex; 0 = desactivada) ---- */
+    int            lista_espera;
+    lista_espera_t espera;
+
+    /* ---- Cupo libre por hora, publicado con seqlock (opcional en memoria compartida) ---- */
+    char             nombre_memoria[MAX_LONG_NOMBRE_MEMORIA];
+    disponibilidad_t disponibilidad;
+
+    /* ---- Modo multi-parque: identificador y prefijo de los archivos de salida ---- */
+    int  id_parque;
+    char prefijo_archivos[32];
+
+    /* ---- Grabacion de la traza de entrada (NULL = desactivada) ---- */
+    struct traza *traza;
+
+    /* ---- Replicacion hacia el respaldo (NULL = sin respaldo, ver replica.h) ---- */
+    struct replica *replica;
+
+    /* ---- Exportacion columnar de reservas (ruta vacia = desactivada, ver exportacion.h) ---- */
+    char                ruta_exportacion[MAX_LONG_NOMBRE_PIPE];
+    struct exportacion *exportacion;
+
+    char hilos_creados;        /* 0 en modo repeticion: no hay FIFO ni hilos            */
+    char silencioso;           /* 1 = no imprimir una linea por cada mensaje            */
+    char sin_respuestas;       /* 1 = no enviar avisos a los agentes (modo repeticion)  */
+    char sin_archivos;         /* 1 = ni reportes ni instantaneas (simulador)           */
 
 } controlador_t;
 
+/* ---- Bitacora por mensaje, que se omite en modo silencioso ---- */
+#define LOG_CTRL(ctrl, ...) \
+    do { if (!(ctrl)->silencioso) printf(__VA_ARGS__); } while (0)
+
+/* ---- Hora y bandera vistas desde fuera del mutex ---- */
+#define CTRL_HORA_ACTUAL(ctrl) \
+    atomic_load_explicit(&(ctrl)->hora_actual, memory_order_acquire)
+#define CTRL_ACTIVO(ctrl) \
+    atomic_load_explicit(&(ctrl)->simulacion_activa, memory_order_acquire)
+#define CTRL_DETENER(ctrl) \
+    atomic_store_explicit(&(ctrl)->simulacion_activa, 0, memory_order_release)
+
 /***************************************** Prototipos *******************************************************/
 
+uint64_t reloj_monotonico_ns(void);
+
+int  servidor_inicializar_estado(controlador_t *ctrl);
 int  servidor_inicializar(controlador_t *ctrl);
+int  servidor_arrancar(controlador_t *ctrl);
 void servidor_destruir(controlador_t *ctrl);
 
+void servidor_avanzar_reloj(controlador_t *ctrl, int hora_nueva);
+void servidor_aplicar_replica(controlador_t *ctrl, const struct delta_replica *d);
+int  servidor_procesar_mensaje(controlador_t *ctrl, mensaje_entrada_t *msg,
+                               char *respuesta, size_t tam_respuesta, char *pipe_destino);
+void servidor_etiquetar_respuesta(char *respuesta, size_t tam_respuesta, const char *id_solicitud);
+
+void  lector_inicializar(lector_lineas_t *l);
+int   lector_leer(lector_lineas_t *l, int fd);
+int   lector_leer_sondeando(lector_lineas_t *l, int fd, sondeo_t *s);
+char *lector_siguiente(lector_lineas_t *l, int *longitud, int *pendientes_locales);
+
 void *servidor_hilo_reloj   (void *arg);
 void *servidor_hilo_agentes (void *arg);
 
@@ -0,0 +1,343 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 25/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    disponibilidad.c                                                                            *
+ *                                                                                                         *
+ * Descripcion: Seqlock sobre la instantanea de cupos libres. Hay un solo escritor (quien tiene el mutex   *
+ *              del parque), asi que la secuencia no necesita operaciones de lectura-modificacion.         *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "disponibilidad.h"
+
+/************************************************************************************************************
+ *  int disponibilidad_inicializar(disponibilidad_t *disp, const char *nombre_memoria,                      *
+ *                                 int hora_ini, int hora_fin, int aforo_maximo, int duracion_reserva)      *
+ *                                                                                                          *
+ *  Proposito: Reservar la instantanea, en memoria privada o, si se da nombre, en un objeto de memoria      *
+ *             compartida POSIX que otros procesos pueden mapear en solo lectura. Se publica vacia.         *
+ *                                                                                                          *
+ *  Retorno:   0 si todo fue bien; -1 si no se pudo reservar.                                               *
+ ************************************************************************************************************/
+int disponibilidad_inicializar(disponibilidad_t *disp, const char *nombre_memoria,
+                               int hora_ini, int hora_fin, int aforo_maximo, int duracion_reserva)
+{
+    int ocupacion[DISPONIBILIDAD_HORAS] = {0};
+    int h;
+
+    memset(disp, 0, sizeof(*disp));
+
+    if (nombre_memoria != NULL && nombre_memoria[0] != '\0') {
+        strncpy(disp->nombre_memoria, nombre_memoria, MAX_LONG_NOMBRE_MEMORIA - 1);
+
+        int fd = shm_open(disp->nombre_memoria, O_CREAT | O_RDWR, 0644);
+        if (fd == -1) {
+            perror("shm_open (disponibilidad)");
+            disp->nombre_memoria[0] = '\0';
+            return -1;
+        }
+        if (ftruncate(fd, sizeof(instantanea_disponibilidad_t)) == -1) {
+            perror("ftruncate (disponibilidad)");
+            close(fd);
+            shm_unlink(disp->nombre_memoria);
+            disp->nombre_memoria[0] = '\0';
+            return -1;
+        }
+
+        void *mapa = mmap(NULL, sizeof(instantanea_disponibilidad_t), PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapa == MAP_FAILED) {
+            perror("mmap (disponibilidad)");
+            shm_unlink(disp->nombre_memoria);
+            disp->nombre_memoria[0] = '\0';
+            return -1;
+        }
+        disp->inst = mapa;
+    } else {
+        disp->inst = calloc(1, sizeof(instantanea_disponibilidad_t));
+        if (disp->inst == NULL) {
+            perror("calloc (disponibilidad)");
+            return -1;
+        }
+    }
+
+    /* ---- Campos fijos: se escriben antes de que haya lectores (un objeto viejo queda invalido) ---- */
+    disp->inst->magico = 0;
+    atomic_init(&disp->inst->secuencia, 0);
+    atomic_init(&disp->inst->hora_ini, hora_ini);
+    atomic_init(&disp->inst->hora_fin, hora_fin);
+    atomic_init(&disp->inst->aforo_maximo, aforo_maximo);
+    atomic_init(&disp->inst->duracion_reserva, duracion_reserva);
+    atomic_init(&disp->inst->hora_actual, hora_ini);
+    for (h = 0; h < DISPONIBILIDAD_HORAS; h++) {
+        atomic_init(&disp->inst->libres[h], 0);
+    }
+
+    disponibilidad_publicar(disp, hora_ini, ocupacion);
+
+    /* El magico va al final: un lector que lo ve ya encuentra la instantanea completa */
+    atomic_thread_fence(memory_order_release);
+    disp->inst->magico = DISPONIBILIDAD_MAGICO;
+
+    return 0;
+}
+
+/************************************************************************************************************
+ *  void disponibilidad_cerrar(disponibilidad_t *disp)                                                      *
+ ************************************************************************************************************/
+void disponibilidad_cerrar(disponibilidad_t *disp)
+{
+    if (disp->inst == NULL) return;
+
+    if (disp->nombre_memoria[0] != '\0') {
+        munmap(disp->inst, sizeof(instantanea_disponibilidad_t));
+        shm_unlink(disp->nombre_memoria);
+    } else {
+        free(disp->inst);
+    }
+    disp->inst = NULL;
+}
+
+/************************************************************************************************************
+ *  void disponibilidad_publicar(disponibilidad_t *disp, int hora_actual, const int *ocupacion)             *
+ *                                                                                                          *
+ *  Proposito: Publicar el cupo libre de cada hora de atencion a partir de la ocupacion (indexada por       *
+ *             hora). Se llama con el mutex del parque tomado, que garantiza un unico escritor.             *
+ ************************************************************************************************************/
+void disponibilidad_publicar(disponibilidad_t *disp, int hora_actual, const int *ocupacion)
+{
+    instantanea_disponibilidad_t *inst = disp->inst;
+    int h, hora_ini, hora_fin, aforo;
+
+    if (inst == NULL) return;
+
+    hora_ini = atomic_load_explicit(&inst->hora_ini,     memory_order_relaxed);
+    hora_fin = atomic_load_explicit(&inst->hora_fin,     memory_order_relaxed);
+    aforo    = atomic_load_explicit(&inst->aforo_maximo, memory_order_relaxed);
+
+    unsigned int s = atomic_load_explicit(&inst->secuencia, memory_order_relaxed);
+
+    /* ---- Secuencia impar: los lectores que empiecen ahora reintentaran ---- */
+    atomic_store_explicit(&inst->secuencia, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&inst->hora_actual, hora_actual, memory_order_relaxed);
+    for (h = hora_ini; h < hora_fin && h < DISPONIBILIDAD_HORAS; h++) {
+        int libres = aforo - ocupacion[h];
+        atomic_store_explicit(&inst->libres[h], (libres > 0) ? libres : 0, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&inst->secuencia, s + 2, memory_order_release);
+}
+
+/************************************************************************************************************
+ *  const instantanea_disponibilidad_t *disponibilidad_abrir_memoria(const char *nombre_memoria)            *
+ *                                                                                                          *
+ *  Proposito: Mapear en solo lectura la instantanea que publica un controlador.                            *
+ *                                                                                                          *
+ *  Retorno:   La instantanea, o NULL si no existe o no la escribio un controlador.                         *
+ ************************************************************************************************************/
+const instantanea_disponibilidad_t *disponibilidad_abrir_memoria(const char *nombre_memoria)
+{
+    int fd = shm_open(nombre_memoria, O_RDONLY, 0);
+    if (fd == -1) {
+        perror("shm_open (disponibilidad)");
+        return NULL;
+    }
+
+    void *mapa = mmap(NULL, sizeof(instantanea_disponibilidad_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED) {
+        perror("mmap (disponibilidad)");
+        return NULL;
+    }
+
+    const instantanea_disponibilidad_t *inst = mapa;
+    if (inst->magico != DISPONIBILIDAD_MAGICO) {
+        fprintf(stderr, "Error: '%s' no contiene una instantanea de disponibilidad.\n", nombre_memoria);
+        munmap(mapa, sizeof(instantanea_disponibilidad_t));
+        return NULL;
+    }
+    atomic_thread_fence(memory_order_acquire);
+
+    return inst;
+}
+
+/************************************************************************************************************
+ *  void disponibilidad_cerrar_memoria(const instantanea_disponibilidad_t *inst)                            *
+ ************************************************************************************************************/
+void disponibilidad_cerrar_memoria(const instantanea_disponibilidad_t *inst)
+{
+    if (inst != NULL) {
+        munmap((void *) inst, sizeof(instantanea_disponibilidad_t));
+    }
+}
+
+/* ---- Indica al nucleo que es un bucle de espera (cede recursos al otro hilo SMT) ---- */
+static inline void pausa_cpu(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile ("pause" ::: "memory");
+#elif defined(__aarch64__)
+    __asm__ volatile ("yield" ::: "memory");
+#else
+    __asm__ volatile ("" ::: "memory");
+#endif
+}
+
+/************************************************************************************************************
+ *  int disponibilidad_leer(const instantanea_disponibilidad_t *inst, vista_disponibilidad_t *vista)        *
+ *                                                                                                          *
+ *  Proposito: Copiar una version consistente. No toma ningun lock: si la secuencia era impar o cambio      *
+ *             durante la copia, se repite tras una pausa. Los primeros DISPONIBILIDAD_GIROS intentos solo  *
+ *             giran; despues se cede el procesador (el escritor pudo quedar sin CPU a mitad de escritura). *
+ *             Un escritor que no termina (p. ej. un controlador que murio con la secuencia impar) no       *
+ *             bloquea al lector: tras DISPONIBILIDAD_REINTENTOS se rinde.                                  *
+ *                                                                                                          *
+ *  Retorno:   0 con la vista copiada; -1 si no se pudo leer una version consistente.                       *
+ ************************************************************************************************************/
+int disponibilidad_leer(const instantanea_disponibilidad_t *inst, vista_disponibilidad_t *vista)
+{
+    /* Los atomicos se leen a traves de un puntero no const (la memoria puede estar mapeada PROT_READ,
+     * pero una carga atomica de un int es una lectura normal) */
+    instantanea_disponibilidad_t *i = (instantanea_disponibilidad_t *) inst;
+    unsigned int s1, s2;
+    int h, intento;
+
+    for (intento = 0; ; intento++) {
+        if (intento > 0) {
+            if (intento == DISPONIBILIDAD_REINTENTOS) return -1;
+            if (intento < DISPONIBILIDAD_GIROS) pausa_cpu();
+            else                                sched_yield();
+        }
+
+        s1 = atomic_load_explicit(&i->secuencia, memory_order_acquire);
+        if (s1 & 1u) {
+            continue;
+        }
+
+        vista->hora_actual  = atomic_load_explicit(&i->hora_actual,  memory_order_relaxed);
+        vista->hora_ini     = atomic_load_explicit(&i->hora_ini,     memory_order_relaxed);
+        vista->hora_fin     = atomic_load_explicit(&i->hora_fin,     memory_order_relaxed);
+        vista->aforo_maximo = atomic_load_explicit(&i->aforo_maximo, memory_order_relaxed);
+        vista->duracion_reserva = atomic_load_explicit(&i->duracion_reserva, memory_order_relaxed);
+        for (h = 0; h < DISPONIBILIDAD_HORAS; h++) {
+            vista->libres[h] = atomic_load_explicit(&i->libres[h], memory_order_relaxed);
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        s2 = atomic_load_explicit(&i->secuencia, memory_order_relaxed);
+        if (s1 == s2) {
+            break;
+        }
+    }
+
+    vista->version = s1;
+    return 0;
+}
+
+/************************************************************************************************************
+ *  int disponibilidad_formatear(const vista_disponibilidad_t *vista, char *texto, size_t tam)              *
+ *                                                                                                          *
+ *  Proposito: Texto de la respuesta a DISPONIBILIDAD (bloque = horas que ocupa cada reserva):              *
+ *               DISPONIBLE: hora 9, bloque 2, libres 7=0 8=12 9=20 ...                                     *
+ *                                                                                                          *
+ *  Retorno:   Longitud del texto (truncado a tam - 1 si no cabe).                                          *
+ ************************************************************************************************************/
+int disponibilidad_formatear(const vista_disponibilidad_t *vista, char *texto, size_t tam)
+{
+    size_t usados;
+    int h;
+
+    usados = (size_t) snprintf(texto, tam, "DISPONIBLE: hora %d, bloque %d, libres",
+                               vista->hora_actual, vista->duracion_reserva);
+
+    for (h = vista->hora_ini; h < vista->hora_fin && h < DISPONIBILIDAD_HORAS && usados < tam; h++) {
+        usados += (size_t) snprintf(texto + usados, tam - usados, " %d=%d", h, vista->libres[h]);
+    }
+
+    return (usados < tam) ? (int) usados : (int) tam - 1;
+}
+
+/************************************************************************************************************
+ *  int disponibilidad_interpretar(const char *texto, vista_disponibilidad_t *vista)                        *
+ *                                                                                                          *
+ *  Proposito: Inverso de disponibilidad_formatear (lo usa el agente con la respuesta del FIFO).            *
+ *                                                                                                          *
+ *  Retorno:   0 si el texto es una respuesta DISPONIBLE valida; -1 si no.                                  *
+ ************************************************************************************************************/
+int disponibilidad_interpretar(const char *texto, vista_disponibilidad_t *vista)
+{
+    const char *p;
+    int consumidos, h, libres;
+
+    memset(vista, 0, sizeof(*vista));
+
+    if (sscanf(texto, "DISPONIBLE: hora %d, bloque %d, libres%n",
+               &vista->hora_actual, &vista->duracion_reserva, &consumidos) != 2) {
+        return -1;
+    }
+
+    vista->hora_ini = -1;
+    p = texto + consumidos;
+    while (sscanf(p, " %d=%d%n", &h, &libres, &consumidos) == 2) {
+        if (h < 0 || h >= DISPONIBILIDAD_HORAS) return -1;
+
+        if (vista->hora_ini == -1) vista->hora_ini = h;
+        vista->hora_fin  = h + 1;
+        vista->libres[h] = libres;
+        p += consumidos;
+    }
+
+    if (vista->hora_ini == -1) {
+        vista->hora_ini = vista->hora_actual;
+        vista->hora_fin = vista->hora_actual;
+    }
+
+    return 0;
+}
+
+/************************************************************************************************************
+ *  int disponibilidad_primer_bloque(const vista_disponibilidad_t *vista, int hora, int personas)           *
+ *                                                                                                          *
+ *  Proposito: Primera hora, desde max(hora, hora_actual), con cupo para el grupo en todo su bloque         *
+ *             (duracion_reserva horas; las que quedan antes del cierre cuentan), con el mismo criterio     *
+ *             que cabe_bloque() en el controlador al aceptar o reprogramar.                                *
+ *                                                                                                          *
+ *  Retorno:   La hora encontrada, o -1 si ningun bloque tiene cupo.                                        *
+ ************************************************************************************************************/
+int disponibilidad_primer_bloque(const vista_disponibilidad_t *vista, int hora, int personas)
+{
+    int h = (hora > vista->hora_actual) ? hora : vista->hora_actual;
+    int fin = (vista->hora_fin < DISPONIBILIDAD_HORAS) ? vista->hora_fin : DISPONIBILIDAD_HORAS;
+    int k;
+
+    for (; h < fin; h++) {
+        if (vista->libres[h] < personas) continue;
+
+        for (k = h + 1; k < h + vista->duracion_reserva && k < fin; k++) {
+            if (vista->libres[k] < personas) break;
+        }
+        if (k >= h + vista->duracion_reserva || k >= fin) {
+            return h;
+        }
+    }
+
+    return -1;
+}
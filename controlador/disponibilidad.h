@@ -0,0 +1,80 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 25/11/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera de la instantanea de disponibilidad.                            *
+ *               El controlador publica el cupo libre de cada hora despues de cada decision y de     *
+ *               cada tick del reloj, protegido por un seqlock: el escritor (que ya tiene el mutex   *
+ *               del parque) nunca espera, y los lectores (mensaje DISPONIBILIDAD o un proceso que   *
+ *               mapea la memoria compartida) solo reintentan si leyeron durante una escritura, y    *
+ *               un numero acotado de veces: si no lo logran, la lectura falla.                      *
+ *                                                                                                   *
+ *               No depende de controlador.h para que el agente pueda leer la memoria compartida.    *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __DISPONIBILIDAD_H__
+#define __DISPONIBILIDAD_H__
+
+/***************************************** Headers **********************************************************/
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define DISPONIBILIDAD_HORAS          25            /* MAX_HORAS_DIA + 1                     */
+#define DISPONIBILIDAD_MAGICO         0x44565352u   /* "RSVD"                                */
+#define MAX_LONG_NOMBRE_MEMORIA       64
+#define DISPONIBILIDAD_GIROS          64            /* Reintentos con pausa de CPU           */
+#define DISPONIBILIDAD_REINTENTOS     1024          /* Tope total (el resto cede la CPU)     */
+
+/* ---- Instantanea publicada (en memoria privada o en un objeto shm_open) ----
+ * Todos los campos son atomicos para que leer durante una escritura no sea una carrera de datos;
+ * la consistencia del conjunto la da la secuencia (impar = escritura en curso).
+ */
+typedef struct {
+    unsigned int  magico;
+    atomic_uint   secuencia;
+    atomic_int    hora_actual;
+    atomic_int    hora_ini;
+    atomic_int    hora_fin;
+    atomic_int    aforo_maximo;
+    atomic_int    duracion_reserva;     /* Horas del bloque de cada reserva               */
+    atomic_int    libres[DISPONIBILIDAD_HORAS];
+} instantanea_disponibilidad_t;
+
+/* ---- Copia consistente que obtiene un lector ---- */
+typedef struct {
+    unsigned int version;           /* Secuencia leida (crece en 2 por publicacion)       */
+    int hora_actual;
+    int hora_ini;
+    int hora_fin;
+    int aforo_maximo;
+    int duracion_reserva;
+    int libres[DISPONIBILIDAD_HORAS];
+} vista_disponibilidad_t;
+
+/* ---- Lado del controlador ---- */
+typedef struct {
+    instantanea_disponibilidad_t *inst;
+    char nombre_memoria[MAX_LONG_NOMBRE_MEMORIA];   /* "" = memoria privada del proceso  */
+} disponibilidad_t;
+
+/***************************************** Prototipos *******************************************************/
+
+int  disponibilidad_inicializar(disponibilidad_t *disp, const char *nombre_memoria,
+                                int hora_ini, int hora_fin, int aforo_maximo, int duracion_reserva);
+void disponibilidad_cerrar(disponibilidad_t *disp);
+void disponibilidad_publicar(disponibilidad_t *disp, int hora_actual, const int *ocupacion);
+
+const instantanea_disponibilidad_t *disponibilidad_abrir_memoria(const char *nombre_memoria);
+void disponibilidad_cerrar_memoria(const instantanea_disponibilidad_t *inst);
+
+int  disponibilidad_leer(const instantanea_disponibilidad_t *inst, vista_disponibilidad_t *vista);
+int  disponibilidad_formatear(const vista_disponibilidad_t *vista, char *texto, size_t tam);
+int  disponibilidad_interpretar(const char *texto, vista_disponibilidad_t *vista);
+int  disponibilidad_primer_bloque(const vista_disponibilidad_t *vista, int hora, int personas);
+
+#endif /* __DISPONIBILIDAD_H__ */
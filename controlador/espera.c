@@ -0,0 +1,221 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 27/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    espera.c                                                                                    *
+ *                                                                                                         *
+ * Descripcion: Lista de espera por hora con monticulos minimos. Quien llama decide cuando revisar cada    *
+ *              hora (al cancelar solo se revisan las horas que tocan el bloque liberado) y hace la        *
+ *              reserva; aqui solo se ordena, se saca y se vence.                                          *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "controlador.h"
+
+/************************************************************************************************************
+ *  static int antes(const entrada_espera_t *a, const entrada_espera_t *b)                                  *
+ *                                                                                                          *
+ *  Retorno:   1 si a tiene prioridad sobre b: grupo mas pequeño y, a igual tamaño, llegada anterior.       *
+ ************************************************************************************************************/
+static int antes(const entrada_espera_t *a, const entrada_espera_t *b)
+{
+    if (a->personas != b->personas) {
+        return a->personas < b->personas;
+    }
+    return (int32_t) (a->secuencia - b->secuencia) < 0;
+}
+
+static void intercambiar(entrada_espera_t *a, entrada_espera_t *b)
+{
+    entrada_espera_t t = *a;
+    *a = *b;
+    *b = t;
+}
+
+/************************************************************************************************************
+ *  void espera_inicializar(lista_espera_t *le, int activa, int hora_ini)                                   *
+ ************************************************************************************************************/
+void espera_inicializar(lista_espera_t *le, int activa, int hora_ini)
+{
+    memset(le, 0, sizeof(*le));
+    le->activa       = activa;
+    le->hora_vencida = hora_ini;
+}
+
+/************************************************************************************************************
+ *  void espera_liberar(lista_espera_t *le)                                                                 *
+ ************************************************************************************************************/
+void espera_liberar(lista_espera_t *le)
+{
+    int h;
+
+    for (h = 0; h <= MAX_HORAS_DIA; h++) {
+        free(le->colas[h].entradas);
+        le->colas[h].entradas  = NULL;
+        le->colas[h].num       = 0;
+        le->colas[h].capacidad = 0;
+    }
+    le->total = 0;
+}
+
+/************************************************************************************************************
+ *  int espera_encolar(lista_espera_t *le, int hora, const char *familia, int personas,                     *
+ *                     const char *pipe_respuesta)                                                          *
+ *                                                                                                          *
+ *  Proposito: Agregar la solicitud al monticulo de su hora (subir hasta su lugar).                         *
+ *                                                                                                          *
+ *  Retorno:   Numero de solicitudes que esperan esa hora, o -1 si no hay memoria o la hora no es valida.   *
+ ************************************************************************************************************/
+int espera_encolar(lista_espera_t *le, int hora, const char *familia, int personas,
+                   const char *pipe_respuesta)
+{
+    cola_espera_t *c;
+
+    if (hora < 0 || hora > MAX_HORAS_DIA) return -1;
+    c = &le->colas[hora];
+
+    if (c->num == c->capacidad) {
+        int nueva = (c->capacidad > 0) ? c->capacidad * 2 : ESPERA_CAPACIDAD_INICIAL;
+        entrada_espera_t *mas = realloc(c->entradas, sizeof(entrada_espera_t) * nueva);
+        if (mas == NULL) {
+            perror("realloc (lista de espera)");
+            return -1;
+        }
+        c->entradas  = mas;
+        c->capacidad = nueva;
+    }
+
+    int i = c->num++;
+    entrada_espera_t *e = &c->entradas[i];
+
+    strncpy(e->familia, familia, MAX_LONG_NOMBRE_FAMILIA - 1);
+    e->familia[MAX_LONG_NOMBRE_FAMILIA - 1] = '\0';
+    strncpy(e->pipe_respuesta, pipe_respuesta, MAX_LONG_NOMBRE_PIPE - 1);
+    e->pipe_respuesta[MAX_LONG_NOMBRE_PIPE - 1] = '\0';
+    e->personas  = personas;
+    e->secuencia = le->secuencia++;
+
+    /* ---- Subir ---- */
+    while (i > 0) {
+        int padre = (i - 1) / 2;
+        if (!antes(&c->entradas[i], &c->entradas[padre])) break;
+        intercambiar(&c->entradas[i], &c->entradas[padre]);
+        i = padre;
+    }
+
+    le->total++;
+    return c->num;
+}
+
+/************************************************************************************************************
+ *  const entrada_espera_t *espera_primero(const lista_espera_t *le, int hora)                              *
+ *                                                                                                          *
+ *  Retorno:   La solicitud con prioridad en esa hora, o NULL si no hay ninguna.                            *
+ ************************************************************************************************************/
+const entrada_espera_t *espera_primero(const lista_espera_t *le, int hora)
+{
+    if (hora < 0 || hora > MAX_HORAS_DIA || le->colas[hora].num == 0) {
+        return NULL;
+    }
+    return &le->colas[hora].entradas[0];
+}
+
+/************************************************************************************************************
+ *  void espera_quitar_primero(lista_espera_t *le, int hora, entrada_espera_t *destino)                     *
+ *                                                                                                          *
+ *  Proposito: Sacar la raiz del monticulo (copiandola en destino si no es NULL) y bajar la ultima.         *
+ ************************************************************************************************************/
+void espera_quitar_primero(lista_espera_t *le, int hora, entrada_espera_t *destino)
+{
+    cola_espera_t *c = &le->colas[hora];
+    int i = 0;
+
+    if (c->num == 0) return;
+
+    if (destino != NULL) {
+        *destino = c->entradas[0];
+    }
+
+    c->entradas[0] = c->entradas[--c->num];
+    le->total--;
+
+    /* ---- Bajar ---- */
+    for (;;) {
+        int izq = 2 * i + 1, der = izq + 1, menor = i;
+
+        if (izq < c->num && antes(&c->entradas[izq], &c->entradas[menor])) menor = izq;
+        if (der < c->num && antes(&c->entradas[der], &c->entradas[menor])) menor = der;
+        if (menor == i) break;
+
+        intercambiar(&c->entradas[i], &c->entradas[menor]);
+        i = menor;
+    }
+}
+
+/************************************************************************************************************
+ *  int espera_agregar_aviso(avisos_espera_t *avisos, const char *pipe, const char *texto)                  *
+ *                                                                                                          *
+ *  Retorno:   1 si se agrego; 0 si ya no caben mas avisos en este evento.                                  *
+ ************************************************************************************************************/
+int espera_agregar_aviso(avisos_espera_t *avisos, const char *pipe, const char *texto)
+{
+    if (avisos->num == MAX_AVISOS_ESPERA) {
+        return 0;
+    }
+
+    aviso_espera_t *a = &avisos->avisos[avisos->num++];
+    snprintf(a->pipe,  sizeof(a->pipe),  "%s", pipe);
+    snprintf(a->texto, sizeof(a->texto), "%s", texto);
+
+    return 1;
+}
+
+/************************************************************************************************************
+ *  int espera_vencer(lista_espera_t *le, int hora_actual, avisos_espera_t *avisos)                         *
+ *                                                                                                          *
+ *  Proposito: Al cambiar de hora, vaciar solo las horas que acaban de pasar (desde la ultima vencida) y    *
+ *             avisar a cada agente. Si no caben mas avisos, las solicitudes restantes siguen en su cola    *
+ *             (se quitan del final del arreglo, el monticulo sigue valido) y la hora no se marca como      *
+ *             vencida: quien llama envia este lote y vuelve a llamar hasta que el lote no quede lleno.     *
+ *                                                                                                          *
+ *  Retorno:   Solicitudes vencidas (todas con aviso en avisos).                                            *
+ ************************************************************************************************************/
+int espera_vencer(lista_espera_t *le, int hora_actual, avisos_espera_t *avisos)
+{
+    char texto[MAX_LONG_MENSAJE];
+    int vencidas = 0;
+    int h;
+
+    for (h = le->hora_vencida; h < hora_actual && h <= MAX_HORAS_DIA; h++) {
+        cola_espera_t *c = &le->colas[h];
+
+        while (c->num > 0) {
+            entrada_espera_t *e = &c->entradas[c->num - 1];
+
+            snprintf(texto, sizeof(texto), "VENCIDA: %s sin cupo para las %d:00\n", e->familia, h);
+            if (!espera_agregar_aviso(avisos, e->pipe_respuesta, texto)) {
+                return vencidas;
+            }
+            c->num--;
+            le->total--;
+            vencidas++;
+        }
+
+        le->hora_vencida = h + 1;
+    }
+
+    if (hora_actual > le->hora_vencida) {
+        le->hora_vencida = hora_actual;
+    }
+
+    return vencidas;
+}
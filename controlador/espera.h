@@ -0,0 +1,76 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 27/11/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera de la lista de espera del Controlador.                          *
+ *               Una solicitud sin cupo en ningun bloque queda esperando su hora pedida. Cada hora   *
+ *               tiene un monticulo minimo por (personas, orden de llegada): si el grupo mas pequeño *
+ *               no cabe, ninguno cabe, asi que revisar una hora cuesta O(1) cuando no hay nada que  *
+ *               promover y O(log n) por promocion.                                                  *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __ESPERA_H__
+#define __ESPERA_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdint.h>
+
+/* Este archivo se incluye desde controlador.h, que define las longitudes maximas de nombres y pipes. */
+
+#define ESPERA_CAPACIDAD_INICIAL      16      /* Entradas por hora antes del primer realloc  */
+#define MAX_AVISOS_ESPERA             64      /* Avisos por lote (el resto espera al otro)   */
+
+/* ---- Solicitud en espera ---- */
+typedef struct {
+    char     familia[MAX_LONG_NOMBRE_FAMILIA];
+    char     pipe_respuesta[MAX_LONG_NOMBRE_PIPE];
+    int      personas;
+    uint32_t secuencia;             /* Orden de llegada: desempata grupos del mismo tamaño */
+} entrada_espera_t;
+
+/* ---- Monticulo de una hora ---- */
+typedef struct {
+    entrada_espera_t *entradas;
+    int               num;
+    int               capacidad;
+} cola_espera_t;
+
+/* ---- Mensaje para un agente (termina en '\n'), que se envia despues de soltar el mutex ---- */
+typedef struct {
+    char pipe[MAX_LONG_NOMBRE_PIPE];
+    char texto[MAX_LONG_MENSAJE];
+} aviso_espera_t;
+
+typedef struct {
+    int            num;
+    aviso_espera_t avisos[MAX_AVISOS_ESPERA];
+} avisos_espera_t;
+
+/* ---- Lista de espera del parque (protegida por el mutex del controlador) ---- */
+typedef struct {
+    int           activa;
+    uint32_t      secuencia;
+    int           total;            /* Entradas en todas las horas                         */
+    int           hora_vencida;     /* Las horas menores ya se vaciaron                    */
+    cola_espera_t colas[MAX_HORAS_DIA + 1];
+} lista_espera_t;
+
+/***************************************** Prototipos *******************************************************/
+
+void espera_inicializar(lista_espera_t *le, int activa, int hora_ini);
+void espera_liberar(lista_espera_t *le);
+
+int  espera_encolar(lista_espera_t *le, int hora, const char *familia, int personas,
+                    const char *pipe_respuesta);
+const entrada_espera_t *espera_primero(const lista_espera_t *le, int hora);
+void espera_quitar_primero(lista_espera_t *le, int hora, entrada_espera_t *destino);
+
+int  espera_vencer(lista_espera_t *le, int hora_actual, avisos_espera_t *avisos);
+int  espera_agregar_aviso(avisos_espera_t *avisos, const char *pipe, const char *texto);
+
+#endif /* __ESPERA_H__ */
@@ -0,0 +1,536 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 01/12/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    exportacion.c                                                                               *
+ *                                                                                                         *
+ * Descripcion: Escritura por grupos y lectura con mmap de la exportacion columnar (ver exportacion.h).    *
+ *              El escritor no tiene mutex propio: el controlador lo llama con el mutex del parque tomado. *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "exportacion.h"
+
+#define DICCIONARIO_TABLA_INICIAL     256     /* Posiciones de la tabla hash (potencia de 2) */
+#define ALINEACION_EXPORTACION        8
+
+const uint8_t ancho_columna_exportacion[NUM_COLUMNAS_EXPORTACION] = { 8, 1, 1, 1, 2, 1, 4, 4 };
+
+const char *nombre_columna_exportacion[NUM_COLUMNAS_EXPORTACION] = {
+    "t_ns", "hora_actual", "hora_solicitada", "hora_asignada",
+    "personas", "resultado", "familia", "agente"
+};
+
+/* ======================================================================================================== *
+ *                                              Diccionario                                                 *
+ * ======================================================================================================== */
+
+static uint32_t hash_texto(const char *s)
+{
+    uint32_t h = 2166136261u;           /* FNV-1a */
+
+    while (*s) {
+        h ^= (uint8_t) *s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void diccionario_liberar(diccionario_t *d)
+{
+    free(d->tabla);
+    free(d->inicio);
+    free(d->texto);
+    memset(d, 0, sizeof(*d));
+}
+
+/************************************************************************************************************
+ *  static int diccionario_crecer_tabla(diccionario_t *d)                                                   *
+ *                                                                                                          *
+ *  Proposito: Duplicar la tabla hash y reinsertar los ids (los textos no se mueven).                       *
+ ************************************************************************************************************/
+static int diccionario_crecer_tabla(diccionario_t *d)
+{
+    uint32_t  capacidad = d->capacidad_tabla ? d->capacidad_tabla * 2 : DICCIONARIO_TABLA_INICIAL;
+    uint32_t *tabla     = calloc(capacidad, sizeof(uint32_t));
+    uint32_t  id;
+
+    if (tabla == NULL) {
+        perror("calloc (diccionario de exportacion)");
+        return -1;
+    }
+
+    for (id = 0; id < d->num; id++) {
+        uint32_t pos = hash_texto(d->texto + d->inicio[id]) & (capacidad - 1);
+        while (tabla[pos] != 0) {
+            pos = (pos + 1) & (capacidad - 1);
+        }
+        tabla[pos] = id + 1;
+    }
+
+    free(d->tabla);
+    d->tabla           = tabla;
+    d->capacidad_tabla = capacidad;
+    return 0;
+}
+
+/************************************************************************************************************
+ *  static uint32_t diccionario_id(diccionario_t *d, const char *s)                                         *
+ *                                                                                                          *
+ *  Retorno:   Id del texto, agregandolo si es nuevo; EXPORTACION_SIN_ID si no hay memoria.                 *
+ ************************************************************************************************************/
+static uint32_t diccionario_id(diccionario_t *d, const char *s)
+{
+    size_t   largo = strlen(s) + 1;
+    uint32_t pos;
+
+    /* ---- Mantener la tabla a menos del 70 % ---- */
+    if ((uint64_t) (d->num + 1) * 10 > (uint64_t) d->capacidad_tabla * 7 &&
+        diccionario_crecer_tabla(d) != 0) {
+        return EXPORTACION_SIN_ID;
+    }
+
+    pos = hash_texto(s) & (d->capacidad_tabla - 1);
+    while (d->tabla[pos] != 0) {
+        uint32_t id = d->tabla[pos] - 1;
+        if (strcmp(d->texto + d->inicio[id], s) == 0) {
+            return id;
+        }
+        pos = (pos + 1) & (d->capacidad_tabla - 1);
+    }
+
+    /* ---- Nuevo: espacio para inicio[num + 1] y para el texto ---- */
+    if (d->num + 2 > d->capacidad) {
+        uint32_t  capacidad = d->capacidad ? d->capacidad * 2 : DICCIONARIO_TABLA_INICIAL;
+        uint32_t *inicio    = realloc(d->inicio, sizeof(uint32_t) * capacidad);
+        if (inicio == NULL) return EXPORTACION_SIN_ID;
+        d->inicio    = inicio;
+        d->capacidad = capacidad;
+    }
+    if (d->usados + largo > d->capacidad_texto) {
+        size_t capacidad = d->capacidad_texto ? d->capacidad_texto * 2 : 4096;
+        while (capacidad < d->usados + largo) capacidad *= 2;
+        char *texto = realloc(d->texto, capacidad);
+        if (texto == NULL) return EXPORTACION_SIN_ID;
+        d->texto           = texto;
+        d->capacidad_texto = capacidad;
+    }
+
+    memcpy(d->texto + d->usados, s, largo);
+    d->inicio[d->num] = (uint32_t) d->usados;
+    d->usados        += largo;
+    d->tabla[pos]     = d->num + 1;
+
+    return d->num++;
+}
+
+/* ======================================================================================================== *
+ *                                               Escritor                                                   *
+ * ======================================================================================================== */
+
+static int escribir(exportacion_t *ex, const void *datos, size_t largo)
+{
+    if (largo > 0 && fwrite(datos, 1, largo, ex->fp) != largo) {
+        perror("fwrite (exportacion)");
+        ex->error = 1;
+        return -1;
+    }
+    ex->posicion += largo;
+    return 0;
+}
+
+static int alinear(exportacion_t *ex)
+{
+    static const uint8_t ceros[ALINEACION_EXPORTACION] = { 0 };
+    size_t resto = ex->posicion % ALINEACION_EXPORTACION;
+
+    return (resto == 0) ? 0 : escribir(ex, ceros, ALINEACION_EXPORTACION - resto);
+}
+
+/************************************************************************************************************
+ *  exportacion_t *exportacion_abrir(const char *ruta, uint64_t t_inicio_ns,                                *
+ *                                   int hora_ini, int hora_fin, int aforo_maximo)                          *
+ *                                                                                                          *
+ *  Proposito: Crear el archivo y escribir la cabecera. t_inicio_ns (CLOCK_MONOTONIC) es el cero de la      *
+ *             columna t_ns.                                                                                *
+ ************************************************************************************************************/
+exportacion_t *exportacion_abrir(const char *ruta, uint64_t t_inicio_ns,
+                                 int hora_ini, int hora_fin, int aforo_maximo)
+{
+    exportacion_t  *ex = calloc(1, sizeof(*ex));
+    struct timespec ts;
+
+    if (ex == NULL) {
+        perror("calloc (exportacion)");
+        return NULL;
+    }
+
+    ex->fp = fopen(ruta, "wb");
+    if (ex->fp == NULL) {
+        perror("fopen (exportacion)");
+        free(ex);
+        return NULL;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    memcpy(ex->cabecera.magico, EXPORTACION_MAGICO, 4);
+    ex->cabecera.version         = EXPORTACION_VERSION;
+    ex->cabecera.num_columnas    = NUM_COLUMNAS_EXPORTACION;
+    ex->cabecera.hora_ini        = hora_ini;
+    ex->cabecera.hora_fin        = hora_fin;
+    ex->cabecera.aforo_maximo    = aforo_maximo;
+    ex->cabecera.filas_por_grupo = EXPORTACION_FILAS_GRUPO;
+    ex->cabecera.inicio_unix_ns  = (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+    ex->t_inicio_ns              = t_inicio_ns;
+
+    if (escribir(ex, &ex->cabecera, sizeof(ex->cabecera)) != 0) {
+        fclose(ex->fp);
+        free(ex);
+        return NULL;
+    }
+
+    return ex;
+}
+
+/************************************************************************************************************
+ *  static int8_t hora_columna(int hora)                                                                    *
+ *                                                                                                          *
+ *  Retorno:   La hora tal cual si cabe en [0, EXPORTACION_MAX_HORA]; -1 en otro caso (un cast directo a   *
+ *             int8 convertiria, por ejemplo, 300 en 44, una hora valida pero falsa).                       *
+ ************************************************************************************************************/
+static int8_t hora_columna(int hora)
+{
+    return (hora >= 0 && hora <= EXPORTACION_MAX_HORA) ? (int8_t) hora : -1;
+}
+
+/************************************************************************************************************
+ *  static void vaciar_grupo(exportacion_t *ex)                                                             *
+ *                                                                                                          *
+ *  Proposito: Escribir las columnas del grupo en construccion (cada una alineada) y anotarlo en el indice. *
+ ************************************************************************************************************/
+static void vaciar_grupo(exportacion_t *ex)
+{
+    const void *columnas[NUM_COLUMNAS_EXPORTACION] = {
+        ex->t_ns, ex->hora_actual, ex->hora_solicitada, ex->hora_asignada,
+        ex->personas, ex->resultado, ex->familia, ex->agente
+    };
+    grupo_exportacion_t g;
+    int c, i;
+
+    if (ex->num == 0 || ex->error) return;
+
+    if (ex->num_grupos == ex->capacidad_grupos) {
+        uint32_t capacidad = ex->capacidad_grupos ? ex->capacidad_grupos * 2 : 16;
+        grupo_exportacion_t *mas = realloc(ex->grupos, sizeof(grupo_exportacion_t) * capacidad);
+        if (mas == NULL) {
+            perror("realloc (indice de exportacion)");
+            ex->error = 1;
+            return;
+        }
+        ex->grupos           = mas;
+        ex->capacidad_grupos = capacidad;
+    }
+
+    memset(&g, 0, sizeof(g));
+    g.filas    = (uint32_t) ex->num;
+    g.hora_min = g.hora_max = ex->hora_actual[0];
+    g.t_min_ns = g.t_max_ns = ex->t_ns[0];
+    for (i = 1; i < ex->num; i++) {
+        if (ex->hora_actual[i] < g.hora_min) g.hora_min = ex->hora_actual[i];
+        if (ex->hora_actual[i] > g.hora_max) g.hora_max = ex->hora_actual[i];
+        if (ex->t_ns[i] < g.t_min_ns) g.t_min_ns = ex->t_ns[i];
+        if (ex->t_ns[i] > g.t_max_ns) g.t_max_ns = ex->t_ns[i];
+    }
+
+    for (c = 0; c < NUM_COLUMNAS_EXPORTACION; c++) {
+        if (alinear(ex) != 0) return;
+        g.desplazamiento[c] = ex->posicion;
+        if (escribir(ex, columnas[c], (size_t) ancho_columna_exportacion[c] * (size_t) ex->num) != 0) {
+            return;
+        }
+    }
+
+    ex->grupos[ex->num_grupos++] = g;
+    ex->filas += (uint64_t) ex->num;
+    ex->num    = 0;
+}
+
+/************************************************************************************************************
+ *  void exportacion_registrar(exportacion_t *ex, uint64_t t_ns, int hora_actual, int resultado,            *
+ *                             const char *agente, const char *familia, int personas,                       *
+ *                             int hora_solicitada, int hora_asignada)                                      *
+ *                                                                                                          *
+ *  Proposito: Agregar una fila al grupo en construccion; al llenarse se escribe. agente puede ser NULL.    *
+ ************************************************************************************************************/
+void exportacion_registrar(exportacion_t *ex, uint64_t t_ns, int hora_actual, int resultado,
+                           const char *agente, const char *familia, int personas,
+                           int hora_solicitada, int hora_asignada)
+{
+    int i;
+
+    if (ex == NULL || ex->error) return;
+
+    i = ex->num;
+    ex->t_ns[i]            = (t_ns > ex->t_inicio_ns) ? t_ns - ex->t_inicio_ns : 0;
+    ex->hora_actual[i]     = (uint8_t) hora_actual;
+    ex->hora_solicitada[i] = hora_columna(hora_solicitada);
+    ex->hora_asignada[i]   = hora_columna(hora_asignada);
+    ex->personas[i]        = (uint16_t) ((personas < 0) ? 0 : (personas > 0xFFFF) ? 0xFFFF : personas);
+    ex->resultado[i]       = (uint8_t) resultado;
+    ex->familia[i]         = diccionario_id(&ex->familias, (familia != NULL) ? familia : "");
+    ex->agente[i]          = (agente != NULL) ? diccionario_id(&ex->agentes, agente) : EXPORTACION_SIN_ID;
+
+    if (++ex->num == EXPORTACION_FILAS_GRUPO) {
+        vaciar_grupo(ex);
+    }
+}
+
+static int escribir_diccionario(exportacion_t *ex, diccionario_t *d, uint64_t *desplazamiento)
+{
+    if (alinear(ex) != 0) return -1;
+
+    *desplazamiento = ex->posicion;
+    if (d->num == 0) {
+        uint32_t cero = 0;
+        return escribir(ex, &cero, sizeof(cero));
+    }
+
+    d->inicio[d->num] = (uint32_t) d->usados;
+    if (escribir(ex, d->inicio, sizeof(uint32_t) * (d->num + 1)) != 0) return -1;
+    return escribir(ex, d->texto, d->usados);
+}
+
+/************************************************************************************************************
+ *  int exportacion_cerrar(exportacion_t *ex)                                                               *
+ *                                                                                                          *
+ *  Proposito: Escribir el ultimo grupo, los diccionarios, el indice y el pie, y liberar el escritor.       *
+ *                                                                                                          *
+ *  Retorno:   0 si el archivo quedo completo; -1 si hubo algun error de escritura.                         *
+ ************************************************************************************************************/
+int exportacion_cerrar(exportacion_t *ex)
+{
+    pie_exportacion_t  pie;
+    cola_exportacion_t cola;
+    int resultado;
+
+    if (ex == NULL) return 0;
+
+    vaciar_grupo(ex);
+
+    memset(&pie, 0, sizeof(pie));
+    pie.filas        = ex->filas;
+    pie.num_grupos   = ex->num_grupos;
+    pie.num_familias = ex->familias.num;
+    pie.num_agentes  = ex->agentes.num;
+
+    if (!ex->error &&
+        escribir_diccionario(ex, &ex->familias, &pie.desplazamiento_familias) == 0 &&
+        escribir_diccionario(ex, &ex->agentes, &pie.desplazamiento_agentes) == 0 &&
+        alinear(ex) == 0) {
+
+        pie.desplazamiento_grupos = ex->posicion;
+        if (escribir(ex, ex->grupos, sizeof(grupo_exportacion_t) * ex->num_grupos) == 0) {
+            memset(&cola, 0, sizeof(cola));
+            cola.desplazamiento_pie = ex->posicion;
+            memcpy(cola.magico, EXPORTACION_MAGICO, 4);
+
+            escribir(ex, &pie, sizeof(pie));
+            escribir(ex, &cola, sizeof(cola));
+        }
+    }
+
+    resultado = ex->error ? -1 : 0;
+    if (fclose(ex->fp) != 0) {
+        perror("fclose (exportacion)");
+        resultado = -1;
+    }
+
+    if (resultado == 0) {
+        printf("[EXPORTACION] %llu filas en %u grupos, %u familias, %u agentes\n",
+               (unsigned long long) pie.filas, pie.num_grupos, pie.num_familias, pie.num_agentes);
+    }
+
+    diccionario_liberar(&ex->familias);
+    diccionario_liberar(&ex->agentes);
+    free(ex->grupos);
+    free(ex);
+
+    return resultado;
+}
+
+/* ======================================================================================================== *
+ *                                                Lector                                                    *
+ * ======================================================================================================== */
+
+static int dentro(const lector_exportacion_t *l, uint64_t desplazamiento, uint64_t largo)
+{
+    return desplazamiento <= l->largo && largo <= l->largo - desplazamiento;
+}
+
+/************************************************************************************************************
+ *  static int validar_diccionario(lector_exportacion_t *l, uint64_t desp, uint32_t num,                    *
+ *                                 const uint32_t **inicio, const char **texto)                             *
+ ************************************************************************************************************/
+static int validar_diccionario(lector_exportacion_t *l, uint64_t desp, uint32_t num,
+                               const uint32_t **inicio, const char **texto)
+{
+    if (num == 0) {
+        *inicio = NULL;
+        *texto  = NULL;
+        return 0;
+    }
+    if (desp % ALINEACION_EXPORTACION != 0 || !dentro(l, desp, sizeof(uint32_t) * ((uint64_t) num + 1))) {
+        return -1;
+    }
+
+    *inicio = (const uint32_t *) (l->mapa + desp);
+    *texto  = (const char *) (l->mapa + desp + sizeof(uint32_t) * ((uint64_t) num + 1));
+
+    uint64_t base = desp + sizeof(uint32_t) * ((uint64_t) num + 1);
+    uint32_t total = (*inicio)[num];
+    if (!dentro(l, base, total) || total == 0 || (*texto)[total - 1] != '\0') {
+        return -1;
+    }
+    for (uint32_t i = 0; i < num; i++) {
+        if ((*inicio)[i] >= total) return -1;
+    }
+    return 0;
+}
+
+/************************************************************************************************************
+ *  int exportacion_mapear(lector_exportacion_t *l, const char *ruta)                                       *
+ *                                                                                                          *
+ *  Proposito: Mapear el archivo en solo lectura y validar cabecera, pie, indice y diccionarios, para que   *
+ *             despues se pueda recorrer cualquier columna sin mas comprobaciones.                          *
+ *                                                                                                          *
+ *  Retorno:   0 si el archivo es valido; -1 si no (el mensaje ya se imprimio).                             *
+ ************************************************************************************************************/
+int exportacion_mapear(lector_exportacion_t *l, const char *ruta)
+{
+    struct stat st;
+    const cola_exportacion_t *cola;
+    uint32_t g;
+    int fd, c;
+
+    memset(l, 0, sizeof(*l));
+
+    fd = open(ruta, O_RDONLY);
+    if (fd == -1) {
+        perror("open (exportacion)");
+        return -1;
+    }
+    if (fstat(fd, &st) == -1) {
+        perror("fstat (exportacion)");
+        close(fd);
+        return -1;
+    }
+    if ((size_t) st.st_size < sizeof(cabecera_exportacion_t) + sizeof(pie_exportacion_t) +
+                              sizeof(cola_exportacion_t)) {
+        fprintf(stderr, "%s: archivo incompleto (la simulacion no cerro la exportacion?)\n", ruta);
+        close(fd);
+        return -1;
+    }
+
+    l->largo = (size_t) st.st_size;
+    l->mapa  = mmap(NULL, l->largo, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (l->mapa == MAP_FAILED) {
+        perror("mmap (exportacion)");
+        l->mapa = NULL;
+        return -1;
+    }
+    madvise((void *) l->mapa, l->largo, MADV_SEQUENTIAL);
+
+    l->cabecera = (const cabecera_exportacion_t *) l->mapa;
+    cola        = (const cola_exportacion_t *) (l->mapa + l->largo - sizeof(cola_exportacion_t));
+
+    if (memcmp(l->cabecera->magico, EXPORTACION_MAGICO, 4) != 0 ||
+        l->cabecera->version != EXPORTACION_VERSION ||
+        l->cabecera->num_columnas != NUM_COLUMNAS_EXPORTACION ||
+        l->cabecera->hora_ini < 0 || l->cabecera->hora_fin > EXPORTACION_MAX_HORA ||
+        l->cabecera->hora_ini > l->cabecera->hora_fin ||
+        memcmp(cola->magico, EXPORTACION_MAGICO, 4) != 0 ||
+        cola->desplazamiento_pie % ALINEACION_EXPORTACION != 0 ||
+        !dentro(l, cola->desplazamiento_pie, sizeof(pie_exportacion_t))) {
+        fprintf(stderr, "%s: no es una exportacion de reservas valida.\n", ruta);
+        exportacion_desmapear(l);
+        return -1;
+    }
+
+    l->pie = (const pie_exportacion_t *) (l->mapa + cola->desplazamiento_pie);
+    if (l->pie->desplazamiento_grupos % ALINEACION_EXPORTACION != 0 ||
+        !dentro(l, l->pie->desplazamiento_grupos,
+                sizeof(grupo_exportacion_t) * (uint64_t) l->pie->num_grupos)) {
+        fprintf(stderr, "%s: indice de grupos danado.\n", ruta);
+        exportacion_desmapear(l);
+        return -1;
+    }
+    l->grupos = (const grupo_exportacion_t *) (l->mapa + l->pie->desplazamiento_grupos);
+
+    for (g = 0; g < l->pie->num_grupos; g++) {
+        for (c = 0; c < NUM_COLUMNAS_EXPORTACION; c++) {
+            uint64_t desp = l->grupos[g].desplazamiento[c];
+            if (desp % ALINEACION_EXPORTACION != 0 ||
+                !dentro(l, desp, (uint64_t) ancho_columna_exportacion[c] * l->grupos[g].filas)) {
+                fprintf(stderr, "%s: columna %s del grupo %u fuera del archivo.\n",
+                        ruta, nombre_columna_exportacion[c], g);
+                exportacion_desmapear(l);
+                return -1;
+            }
+        }
+    }
+
+    if (validar_diccionario(l, l->pie->desplazamiento_familias, l->pie->num_familias,
+                            &l->inicio_familias, &l->texto_familias) != 0 ||
+        validar_diccionario(l, l->pie->desplazamiento_agentes, l->pie->num_agentes,
+                            &l->inicio_agentes, &l->texto_agentes) != 0) {
+        fprintf(stderr, "%s: diccionario danado.\n", ruta);
+        exportacion_desmapear(l);
+        return -1;
+    }
+
+    return 0;
+}
+
+/************************************************************************************************************
+ *  const void *exportacion_columna(const lector_exportacion_t *l, uint32_t grupo, int columna)             *
+ *                                                                                                          *
+ *  Retorno:   Puntero a los valores de la columna en el grupo (alineado a 8), listo para recorrer.         *
+ ************************************************************************************************************/
+const void *exportacion_columna(const lector_exportacion_t *l, uint32_t grupo, int columna)
+{
+    return l->mapa + l->grupos[grupo].desplazamiento[columna];
+}
+
+const char *exportacion_familia(const lector_exportacion_t *l, uint32_t id)
+{
+    return (id < l->pie->num_familias) ? l->texto_familias + l->inicio_familias[id] : "?";
+}
+
+const char *exportacion_agente(const lector_exportacion_t *l, uint32_t id)
+{
+    return (id < l->pie->num_agentes) ? l->texto_agentes + l->inicio_agentes[id] : "-";
+}
+
+void exportacion_desmapear(lector_exportacion_t *l)
+{
+    if (l->mapa != NULL) {
+        munmap((void *) l->mapa, l->largo);
+    }
+    memset(l, 0, sizeof(*l));
+}
@@ -0,0 +1,179 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 01/12/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera de la exportacion columnar de reservas.                         *
+ *               Cada decision, promocion y cancelacion se agrega como una fila. Las filas se        *
+ *               acumulan en memoria por columnas y se escriben por grupos de                        *
+ *               EXPORTACION_FILAS_GRUPO mientras corre la simulacion. Al cerrar se escriben los     *
+ *               diccionarios de familias y agentes y un pie con el indice de los grupos.            *
+ *                                                                                                   *
+ *               Formato (binario, little-endian, todo alineado a 8 bytes):                          *
+ *                 cabecera_exportacion_t                                                            *
+ *                 por grupo: una columna tras otra, cada una con 'filas' valores de ancho fijo      *
+ *                 diccionario de familias, diccionario de agentes                                   *
+ *                 grupo_exportacion_t[num_grupos]   (indice: posicion de cada columna y rangos)     *
+ *                 pie_exportacion_t                                                                 *
+ *                 cola_exportacion_t                (ultimos 16 bytes: donde empieza el pie)        *
+ *                                                                                                   *
+ *               Diccionario: uint32 inicio[n + 1] y luego los textos terminados en '\0'; el texto   *
+ *               del id k empieza en inicio[k]. La columna familia guarda el id; la de agente        *
+ *               guarda el id o EXPORTACION_SIN_ID.                                                  *
+ *                                                                                                   *
+ *               No depende de controlador.h para que la herramienta de consulta lo use sola.        *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __EXPORTACION_H__
+#define __EXPORTACION_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define EXPORTACION_MAGICO            "RSVC"
+#define EXPORTACION_VERSION           1
+#define EXPORTACION_FILAS_GRUPO       4096
+#define EXPORTACION_SIN_ID            0xFFFFFFFFu
+#define EXPORTACION_MAX_HORA          24            /* MAX_HORAS_DIA                         */
+
+/* ---- Columnas, en el orden en que se escriben dentro de cada grupo ---- */
+enum {
+    COL_T_NS = 0,           /* uint64: instante monotonico relativo al inicio               */
+    COL_HORA_ACTUAL,        /* uint8:  hora de simulacion al decidir                        */
+    COL_HORA_SOLICITADA,    /* int8:   -1 si venia fuera de [0, EXPORTACION_MAX_HORA]       */
+    COL_HORA_ASIGNADA,      /* int8:   -1 si no hubo reserva                                */
+    COL_PERSONAS,           /* uint16                                                       */
+    COL_RESULTADO,          /* uint8:  RESULTADO_*                                          */
+    COL_FAMILIA,            /* uint32: id en el diccionario de familias                     */
+    COL_AGENTE,             /* uint32: id en el diccionario de agentes o EXPORTACION_SIN_ID */
+    NUM_COLUMNAS_EXPORTACION
+};
+
+/* ---- Resultado de cada fila (los primeros coinciden con tipo_respuesta_t) ---- */
+enum {
+    RESULTADO_ACEPTADA = 0,
+    RESULTADO_REPROGRAMADA,
+    RESULTADO_NEGADA_EXTEMP,
+    RESULTADO_NEGADA_SIN_CUPO,
+    RESULTADO_NEGADA_AFORO,
+    RESULTADO_PROMOVIDA = 16,   /* Reserva concedida desde la lista de espera               */
+    RESULTADO_CANCELADA         /* hora_asignada = bloque liberado                          */
+};
+
+extern const uint8_t ancho_columna_exportacion[NUM_COLUMNAS_EXPORTACION];
+extern const char   *nombre_columna_exportacion[NUM_COLUMNAS_EXPORTACION];
+
+typedef struct {
+    char     magico[4];
+    uint16_t version;
+    uint16_t num_columnas;
+    int32_t  hora_ini;
+    int32_t  hora_fin;
+    int32_t  aforo_maximo;
+    uint32_t filas_por_grupo;
+    uint64_t inicio_unix_ns;        /* CLOCK_REALTIME al abrir: t_ns se suma a esto       */
+} cabecera_exportacion_t;
+
+/* ---- Entrada del indice: un lector puede saltar grupos por hora o por tiempo ---- */
+typedef struct {
+    uint64_t desplazamiento[NUM_COLUMNAS_EXPORTACION];
+    uint32_t filas;
+    uint8_t  hora_min;              /* Rango de COL_HORA_ACTUAL en el grupo               */
+    uint8_t  hora_max;
+    uint16_t reservado;
+    uint64_t t_min_ns;
+    uint64_t t_max_ns;
+} grupo_exportacion_t;
+
+typedef struct {
+    uint64_t filas;
+    uint64_t desplazamiento_grupos;
+    uint64_t desplazamiento_familias;
+    uint64_t desplazamiento_agentes;
+    uint32_t num_grupos;
+    uint32_t num_familias;
+    uint32_t num_agentes;
+    uint32_t reservado;
+} pie_exportacion_t;
+
+typedef struct {
+    uint64_t desplazamiento_pie;
+    char     magico[4];
+    uint32_t reservado;
+} cola_exportacion_t;
+
+/* ---- Diccionario de textos con tabla hash (solo escritura) ---- */
+typedef struct {
+    uint32_t *tabla;                /* id + 1 por posicion (0 = libre), direccionamiento abierto */
+    uint32_t  capacidad_tabla;      /* Potencia de 2                                      */
+    uint32_t *inicio;               /* inicio[id] dentro de texto; inicio[num] = usados   */
+    uint32_t  num;
+    uint32_t  capacidad;
+    char     *texto;
+    size_t    usados;
+    size_t    capacidad_texto;
+} diccionario_t;
+
+/* ---- Escritor ---- */
+typedef struct exportacion {
+    FILE                  *fp;
+    uint64_t               posicion;
+    uint64_t               t_inicio_ns;
+    cabecera_exportacion_t cabecera;
+
+    /* ---- Grupo en construccion, por columnas ---- */
+    int      num;
+    uint64_t t_ns[EXPORTACION_FILAS_GRUPO];
+    uint8_t  hora_actual[EXPORTACION_FILAS_GRUPO];
+    int8_t   hora_solicitada[EXPORTACION_FILAS_GRUPO];
+    int8_t   hora_asignada[EXPORTACION_FILAS_GRUPO];
+    uint16_t personas[EXPORTACION_FILAS_GRUPO];
+    uint8_t  resultado[EXPORTACION_FILAS_GRUPO];
+    uint32_t familia[EXPORTACION_FILAS_GRUPO];
+    uint32_t agente[EXPORTACION_FILAS_GRUPO];
+
+    grupo_exportacion_t *grupos;
+    uint32_t             num_grupos;
+    uint32_t             capacidad_grupos;
+    uint64_t             filas;
+
+    diccionario_t familias;
+    diccionario_t agentes;
+    int           error;            /* 1 = fallo una escritura: se dejan de agregar filas */
+} exportacion_t;
+
+/* ---- Lector sobre el archivo mapeado ---- */
+typedef struct {
+    const uint8_t                *mapa;
+    size_t                        largo;
+    const cabecera_exportacion_t *cabecera;
+    const pie_exportacion_t      *pie;
+    const grupo_exportacion_t    *grupos;
+    const uint32_t               *inicio_familias;
+    const char                   *texto_familias;
+    const uint32_t               *inicio_agentes;
+    const char                   *texto_agentes;
+} lector_exportacion_t;
+
+/***************************************** Prototipos *******************************************************/
+
+exportacion_t *exportacion_abrir(const char *ruta, uint64_t t_inicio_ns,
+                                 int hora_ini, int hora_fin, int aforo_maximo);
+void           exportacion_registrar(exportacion_t *ex, uint64_t t_ns, int hora_actual, int resultado,
+                                     const char *agente, const char *familia, int personas,
+                                     int hora_solicitada, int hora_asignada);
+int            exportacion_cerrar(exportacion_t *ex);
+
+int            exportacion_mapear(lector_exportacion_t *l, const char *ruta);
+const void    *exportacion_columna(const lector_exportacion_t *l, uint32_t grupo, int columna);
+const char    *exportacion_familia(const lector_exportacion_t *l, uint32_t id);
+const char    *exportacion_agente(const lector_exportacion_t *l, uint32_t id);
+void           exportacion_desmapear(lector_exportacion_t *l);
+
+#endif /* __EXPORTACION_H__ */
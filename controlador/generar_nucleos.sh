@@ -0,0 +1,53 @@
+#!/bin/sh
+# ============================================================
+# generar_nucleos.sh [sede.conf]
+#
+# Escribe por stdout nucleos_sede.h: una linea
+#     NUCLEO_SEDE(horaFin, aforo, duracion)
+# por cada configuracion distinta de parque del archivo (mismo
+# formato que parques.conf: lineas "parque id horaIni horaFin
+# aforo [nucleo]" y "duracion_reserva N", 2 por defecto).
+# Sin archivo la lista queda vacia: solo el nucleo generico.
+# Lo llama el Makefile (make SEDE=archivo).
+# ============================================================
+
+conf="$1"
+
+echo "/* Generado por controlador/generar_nucleos.sh${conf:+ desde $conf}. No editar. */"
+
+[ -z "$conf" ] && exit 0
+
+if [ ! -r "$conf" ]; then
+    echo "generar_nucleos.sh: no se puede leer '$conf'" >&2
+    exit 1
+fi
+
+awk '
+    { sub(/#.*/, "") }
+    $1 == "duracion_reserva" { duracion = $2 + 0 }
+    $1 == "parque" {
+        if (NF < 5) {
+            printf("%s:%d: linea de parque invalida\n", FILENAME, NR) > "/dev/stderr"
+            error = 1
+            next
+        }
+        fin[++n] = $4 + 0
+        aforo[n] = $5 + 0
+    }
+    END {
+        if (error) exit 1
+        if (duracion <= 0) duracion = 2
+        for (i = 1; i <= n; i++) {
+            if (fin[i] < 1 || fin[i] > 24 || aforo[i] <= 0 || duracion > 24) {
+                printf("%s: configuracion fuera de rango (cierre %d, aforo %d, duracion %d)\n",
+                       FILENAME, fin[i], aforo[i], duracion) > "/dev/stderr"
+                exit 1
+            }
+            clave = fin[i] "_" aforo[i] "_" duracion
+            if (!(clave in visto)) {
+                visto[clave] = 1
+                printf("NUCLEO_SEDE(%d, %d, %d)\n", fin[i], aforo[i], duracion)
+            }
+        }
+    }
+' "$conf"
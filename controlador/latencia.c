@@ -0,0 +1,247 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 23/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    latencia.c                                                                                  *
+ *                                                                                                         *
+ * Descripcion: Medicion de latencia por etapas. Un mensaje no muestreado solo cuesta un incremento y una  *
+ *              comparacion; uno muestreado cuesta cinco lecturas de CLOCK_MONOTONIC (vDSO, sin llamada    *
+ *              al sistema) y cinco incrementos de histograma.                                             *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "controlador.h"
+
+static const char *nombres_etapa[NUM_ETAPAS] = {
+    "parseo", "espera_mutex", "decision", "respuesta", "total"
+};
+
+/************************************************************************************************************
+ *  static int indice_cubeta(uint64_t v)                                                                    *
+ *                                                                                                          *
+ *  Proposito: Cubeta log-lineal de v: los valores menores que LATENCIA_SUBCUBETAS van uno por cubeta; los  *
+ *             demas se agrupan por potencia de 2 y se dividen en LATENCIA_SUBCUBETAS partes iguales.       *
+ ************************************************************************************************************/
+static int indice_cubeta(uint64_t v)
+{
+    if (v < LATENCIA_SUBCUBETAS) {
+        return (int) v;
+    }
+
+    int exponente = 63 - __builtin_clzll(v);
+    if (exponente > LATENCIA_MAX_EXPONENTE) {
+        return LATENCIA_CUBETAS - 1;
+    }
+
+    int desplazamiento = exponente - LATENCIA_SUBBITS;
+    int sub            = (int) ((v >> desplazamiento) & (LATENCIA_SUBCUBETAS - 1));
+
+    return (desplazamiento + 1) * LATENCIA_SUBCUBETAS + sub;
+}
+
+/************************************************************************************************************
+ *  static uint64_t limite_cubeta(int indice)                                                               *
+ *                                                                                                          *
+ *  Proposito: Mayor valor que cae en la cubeta (cota superior usada al reportar percentiles).              *
+ ************************************************************************************************************/
+static uint64_t limite_cubeta(int indice)
+{
+    if (indice < LATENCIA_SUBCUBETAS) {
+        return (uint64_t) indice;
+    }
+
+    int grupo          = indice / LATENCIA_SUBCUBETAS;
+    int sub            = indice % LATENCIA_SUBCUBETAS;
+    int desplazamiento = grupo - 1;
+
+    uint64_t inferior = (uint64_t) (LATENCIA_SUBCUBETAS + sub) << desplazamiento;
+    return inferior + (1ULL << desplazamiento) - 1;
+}
+
+/************************************************************************************************************
+ *  static void sumar_valor(histograma_latencia_t *h, uint64_t v)                                           *
+ ************************************************************************************************************/
+static void sumar_valor(histograma_latencia_t *h, uint64_t v)
+{
+    h->cubetas[indice_cubeta(v)]++;
+    h->cuenta++;
+    h->suma += v;
+    if (v > h->maximo) h->maximo = v;
+}
+
+/************************************************************************************************************
+ *  int latencia_inicializar(latencia_t *lat, int muestreo, const char *ruta_chrome)                        *
+ *                                                                                                          *
+ *  Proposito: Dejar los histogramas en cero y, si se indica ruta, abrir el archivo de eventos de Chrome.   *
+ *                                                                                                          *
+ *  Retorno:   0 si todo fue bien; -1 si no se pudo crear el archivo de eventos.                            *
+ ************************************************************************************************************/
+int latencia_inicializar(latencia_t *lat, int muestreo, const char *ruta_chrome)
+{
+    memset(lat, 0, sizeof(*lat));
+
+    lat->muestreo  = (muestreo > 0) ? muestreo : 0;
+    lat->t_base_ns = reloj_monotonico_ns();
+
+    if (lat->muestreo > 0 && ruta_chrome != NULL && ruta_chrome[0] != '\0') {
+        lat->chrome = fopen(ruta_chrome, "w");
+        if (lat->chrome == NULL) {
+            perror("fopen (eventos de Chrome)");
+            return -1;
+        }
+        fprintf(lat->chrome, "[\n");
+    }
+
+    return 0;
+}
+
+/************************************************************************************************************
+ *  void latencia_cerrar(latencia_t *lat)                                                                   *
+ ************************************************************************************************************/
+void latencia_cerrar(latencia_t *lat)
+{
+    if (lat->chrome != NULL) {
+        fprintf(lat->chrome, "\n]\n");
+        fclose(lat->chrome);
+        lat->chrome = NULL;
+    }
+}
+
+/************************************************************************************************************
+ *  muestra_latencia_t *latencia_muestrear(latencia_t *lat, muestra_latencia_t *m)                          *
+ *                                                                                                          *
+ *  Proposito: Decidir si el mensaje actual se mide.                                                        *
+ *                                                                                                          *
+ *  Retorno:   m (en cero) si toca medirlo; NULL si no. Las marcas sobre NULL no hacen nada.                *
+ ************************************************************************************************************/
+muestra_latencia_t *latencia_muestrear(latencia_t *lat, muestra_latencia_t *m)
+{
+    if (lat->muestreo == 0) {
+        return NULL;
+    }
+    if (lat->contador++ % (uint64_t) lat->muestreo != 0) {
+        return NULL;
+    }
+
+    memset(m, 0, sizeof(*m));
+    return m;
+}
+
+/************************************************************************************************************
+ *  void latencia_marcar(muestra_latencia_t *m, marca_latencia_t marca)                                     *
+ ************************************************************************************************************/
+void latencia_marcar(muestra_latencia_t *m, marca_latencia_t marca)
+{
+    if (m != NULL) {
+        m->t[marca] = reloj_monotonico_ns();
+    }
+}
+
+/************************************************************************************************************
+ *  void latencia_registrar(latencia_t *lat, const muestra_latencia_t *m, const char *tipo)                 *
+ *                                                                                                          *
+ *  Proposito: Pasar las marcas de una muestra a duraciones por etapa. Una marca que no se tomo (p. ej. el  *
+ *             mutex en una respuesta OCUPADO) toma el valor de la anterior, y su etapa dura cero.          *
+ ************************************************************************************************************/
+void latencia_registrar(latencia_t *lat, const muestra_latencia_t *m, const char *tipo)
+{
+    uint64_t t[NUM_MARCAS];
+    int i;
+
+    if (m == NULL) return;
+
+    t[0] = m->t[0];
+    for (i = 1; i < NUM_MARCAS; i++) {
+        t[i] = (m->t[i] >= t[i - 1]) ? m->t[i] : t[i - 1];
+    }
+
+    for (i = 0; i < ETAPA_TOTAL; i++) {
+        sumar_valor(&lat->etapas[i], t[i + 1] - t[i]);
+    }
+    sumar_valor(&lat->etapas[ETAPA_TOTAL], t[MARCA_RESPONDIDO] - t[MARCA_RECIBIDO]);
+
+    /* ---- Eventos "X" (duracion completa) en microsegundos, uno por etapa ---- */
+    if (lat->chrome != NULL) {
+        for (i = 0; i < ETAPA_TOTAL; i++) {
+            double ts  = (double) (t[i] - lat->t_base_ns) / 1000.0;
+            double dur = (double) (t[i + 1] - t[i]) / 1000.0;
+
+            fprintf(lat->chrome,
+                    "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"pid\":1,\"tid\":1}",
+                    lat->eventos_chrome++ ? ",\n" : "", nombres_etapa[i],
+                    (tipo != NULL) ? tipo : "?", ts, dur);
+        }
+    }
+}
+
+/************************************************************************************************************
+ *  uint64_t latencia_percentil(const histograma_latencia_t *h, double percentil)                           *
+ *                                                                                                          *
+ *  Retorno:   Cota superior (en ns) del valor en el percentil pedido (0-100), o 0 si no hay datos.         *
+ ************************************************************************************************************/
+uint64_t latencia_percentil(const histograma_latencia_t *h, double percentil)
+{
+    uint64_t objetivo, acumulado = 0;
+    int i;
+
+    if (h->cuenta == 0) return 0;
+
+    objetivo = (uint64_t) ((percentil / 100.0) * (double) h->cuenta + 0.5);
+    if (objetivo == 0)        objetivo = 1;
+    if (objetivo > h->cuenta) objetivo = h->cuenta;
+
+    for (i = 0; i < LATENCIA_CUBETAS; i++) {
+        acumulado += h->cubetas[i];
+        if (acumulado >= objetivo) {
+            uint64_t limite = limite_cubeta(i);
+            return (limite < h->maximo) ? limite : h->maximo;
+        }
+    }
+
+    return h->maximo;
+}
+
+/************************************************************************************************************
+ *  int latencia_escribir_reporte(const latencia_t *lat, FILE *fp)                                          *
+ *                                                                                                          *
+ *  Proposito: Tabla de percentiles por etapa, en microsegundos.                                            *
+ *                                                                                                          *
+ *  Retorno:   0 si habia muestras; -1 si la medicion estaba desactivada o vacia.                           *
+ ************************************************************************************************************/
+int latencia_escribir_reporte(const latencia_t *lat, FILE *fp)
+{
+    int i;
+
+    if (lat->muestreo == 0 || lat->etapas[ETAPA_TOTAL].cuenta == 0) {
+        return -1;
+    }
+
+    fprintf(fp, "Latencia por etapa (us), muestreo 1/%d, %llu muestras:\n",
+            lat->muestreo, (unsigned long long) lat->etapas[ETAPA_TOTAL].cuenta);
+    fprintf(fp, "   %-14s %10s %10s %10s %10s %10s %10s\n",
+            "etapa", "media", "p50", "p90", "p99", "p99.9", "max");
+
+    for (i = 0; i < NUM_ETAPAS; i++) {
+        const histograma_latencia_t *h = &lat->etapas[i];
+
+        fprintf(fp, "   %-14s %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                nombres_etapa[i],
+                (double) h->suma / (double) h->cuenta / 1000.0,
+                latencia_percentil(h, 50.0)  / 1000.0,
+                latencia_percentil(h, 90.0)  / 1000.0,
+                latencia_percentil(h, 99.0)  / 1000.0,
+                latencia_percentil(h, 99.9)  / 1000.0,
+                (double) h->maximo / 1000.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 23/11/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera para la medicion de latencia por etapas de cada mensaje.        *
+ *               Para uno de cada N mensajes se toma CLOCK_MONOTONIC al recibirlo, al terminar el    *
+ *               parseo, al obtener el mutex, al decidir y al escribir la respuesta (cuando termina  *
+ *               el writev() de su tanda, ver salida.h; incluye la espera en cola). Las duraciones   *
+ *               se acumulan en histogramas log-lineales (estilo HDR) y opcionalmente se vuelcan     *
+ *               como eventos de Chrome (chrome://tracing, Perfetto).                                *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __LATENCIA_H__
+#define __LATENCIA_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdint.h>
+
+/* ---- Histograma log-lineal: 2^SUBBITS sub-cubetas por cada potencia de 2 (error < 1/2^SUBBITS) ---- */
+#define LATENCIA_SUBBITS              4
+#define LATENCIA_SUBCUBETAS           (1 << LATENCIA_SUBBITS)
+#define LATENCIA_MAX_EXPONENTE        40      /* 2^40 ns ~ 18 minutos                         */
+#define LATENCIA_CUBETAS              ((LATENCIA_MAX_EXPONENTE + 1) * LATENCIA_SUBCUBETAS)
+
+#define ARCHIVO_REPORTE_LATENCIA      "reporte_latencia.txt"
+
+/* ---- Marcas de tiempo de un mensaje ---- */
+typedef enum {
+    MARCA_RECIBIDO = 0,
+    MARCA_PARSEADO,
+    MARCA_BLOQUEO,
+    MARCA_DECISION,
+    MARCA_RESPONDIDO,
+    NUM_MARCAS
+} marca_latencia_t;
+
+/* ---- Etapas: diferencia entre marcas consecutivas, mas el total ---- */
+typedef enum {
+    ETAPA_PARSEO = 0,        /* recibido  -> parseado   */
+    ETAPA_ESPERA_MUTEX,      /* parseado  -> bloqueo    */
+    ETAPA_DECISION,          /* bloqueo   -> decision   */
+    ETAPA_RESPUESTA,         /* decision  -> respondido (cola + writev) */
+    ETAPA_TOTAL,             /* recibido  -> respondido */
+    NUM_ETAPAS
+} etapa_latencia_t;
+
+typedef struct {
+    uint64_t t[NUM_MARCAS];
+} muestra_latencia_t;
+
+typedef struct {
+    uint64_t cubetas[LATENCIA_CUBETAS];
+    uint64_t cuenta;
+    uint64_t maximo;
+    uint64_t suma;
+} histograma_latencia_t;
+
+/* ---- Estado de la medicion (lo registra la salida de respuestas, con su mutex) ---- */
+typedef struct {
+    int      muestreo;       /* 1 de cada N mensajes (0 = desactivado)             */
+    uint64_t contador;
+
+    histograma_latencia_t etapas[NUM_ETAPAS];
+
+    FILE    *chrome;         /* Eventos de Chrome, NULL si no se pidieron          */
+    int      eventos_chrome;
+    uint64_t t_base_ns;
+} latencia_t;
+
+/***************************************** Prototipos *******************************************************/
+
+int  latencia_inicializar(latencia_t *lat, int muestreo, const char *ruta_chrome);
+void latencia_cerrar(latencia_t *lat);
+
+muestra_latencia_t *latencia_muestrear(latencia_t *lat, muestra_latencia_t *m);
+void latencia_marcar(muestra_latencia_t *m, marca_latencia_t marca);
+void latencia_registrar(latencia_t *lat, const muestra_latencia_t *m, const char *tipo);
+
+uint64_t latencia_percentil(const histograma_latencia_t *h, double percentil);
+int      latencia_escribir_reporte(const latencia_t *lat, FILE *fp);
+
+#endif /* __LATENCIA_H__ */
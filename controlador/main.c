@@ -22,26 +22,206 @@
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <signal.h>
 
 #include "controlador.h"
+#include "traza.h"
+#include "parques.h"
+#include "replica.h"
+#include "exportacion.h"
+
+#define USO_CONTROLADOR \
+    "Uso: %s -i horaIni -f horaFin -s segHoras -t total -p pipeRecibe\n" \
+    "          [-r solicitudesPorSegundo] [-b rafaga] [-w bytesPendientes]\n" \
+    "          [-g trazaGrabar] [-m muestreoLatencia] [-j eventosChrome.json]\n" \
+    "          [-k /memoriaDisponibilidad] [-e] [-P socketRespaldo | -S socketRespaldo]\n" \
+    "          [-u nucleo[:giroMaxUs]] [-X reservas.col] [-d horasReserva] [-l plazoRespuestasUs]\n" \
+    "   o: %s -R trazaRepetir [-x] [-i horaIni] [-f horaFin] [-t total] [-r ...] [-b ...] [-w ...]\n" \
+    "          [-m muestreoLatencia] [-j eventosChrome.json] [-e] [-X reservas.col] [-d horasReserva]\n" \
+    "   o: %s -c parques.conf\n"
+
+/************************************************************************************************************
+ *  static int repetir_traza(controlador_t *ctrl, const char *ruta, int ritmoOriginal, ...)                 *
+ *                                                                                                          *
+ *  Proposito: Modo repeticion. Toma la configuracion de la cabecera de la traza (salvo lo que se haya      *
+ *             indicado por linea de comandos: duracion = -1 si no se dio -d; -e solo puede activar la      *
+ *             lista de espera) y pasa los mensajes directo al motor de reservas. Los archivos de salida    *
+ *             llevan el prefijo "repeticion_" para no pisar los de la ejecucion grabada.                   *
+ ************************************************************************************************************/
+static int repetir_traza(controlador_t *ctrl, const char *ruta, int ritmoOriginal,
+                         int horaIni, int horaFin, int aforoTotal, int duracion)
+{
+    traza_t *tr = traza_abrir_lectura(ruta);
+    if (tr == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    ctrl->hora_ini          = (horaIni    != -1) ? horaIni    : tr->cabecera.hora_ini;
+    ctrl->hora_fin          = (horaFin    != -1) ? horaFin    : tr->cabecera.hora_fin;
+    ctrl->aforo_maximo      = (aforoTotal != -1) ? aforoTotal : tr->cabecera.aforo_maximo;
+    ctrl->segundos_por_hora = tr->cabecera.segundos_por_hora;
+    ctrl->duracion_reserva  = (duracion   != -1) ? duracion   : tr->cabecera.duracion_reserva;
+    ctrl->lista_espera      = ctrl->lista_espera || tr->cabecera.lista_espera;
+    ctrl->silencioso        = 1;
+    ctrl->sin_respuestas    = 1;
+    strncpy(ctrl->prefijo_archivos, "repeticion_", sizeof(ctrl->prefijo_archivos) - 1);
+
+    if (ctrl->hora_ini < 0 || ctrl->hora_fin > MAX_HORAS_DIA ||
+        ctrl->hora_fin < ctrl->hora_ini || ctrl->aforo_maximo <= 0 ||
+        ctrl->duracion_reserva <= 0 || ctrl->duracion_reserva > MAX_HORAS_DIA) {
+        fprintf(stderr, "Error: configuracion invalida para la repeticion.\n");
+        traza_cerrar(tr);
+        return EXIT_FAILURE;
+    }
+
+    if (servidor_inicializar_estado(ctrl) != 0) {
+        traza_cerrar(tr);
+        return EXIT_FAILURE;
+    }
+
+    /* Los instantes de la traza ya son relativos al inicio de la grabacion */
+    if (ctrl->exportacion != NULL) {
+        ctrl->exportacion->t_inicio_ns = 0;
+    }
+
+    int r = traza_repetir(ctrl, tr, ritmoOriginal);
+
+    traza_cerrar(tr);
+    servidor_destruir(ctrl);
+
+    return (r == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/************************************************************************************************************
+ *  static int ejecutar_parques(const char *ruta)                                                           *
+ *                                                                                                          *
+ *  Proposito: Modo multi-parque. Toda la configuracion sale del archivo (ver parques.h).                   *
+ ************************************************************************************************************/
+static int ejecutar_parques(const char *ruta)
+{
+    static multiparque_t mp;
+
+    if (parques_cargar_configuracion(&mp, ruta) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    if (parques_inicializar(&mp) != 0) {
+        fprintf(stderr, "Error: no fue posible inicializar los parques.\n");
+        parques_destruir(&mp);
+        return EXIT_FAILURE;
+    }
+
+    while (parques_activo(&mp)) {
+        sleep(1);
+    }
+
+    parques_destruir(&mp);
+    return EXIT_SUCCESS;
+}
+
+/************************************************************************************************************
+ *  static int ejecutar_respaldo(controlador_t *ctrl, const char *socket_respaldo)                          *
+ *                                                                                                          *
+ *  Proposito: Modo respaldo. Aplica los deltas del primario sin abrir el FIFO; si la conexion se cierra    *
+ *             antes del fin del dia, el primario cayo: se abre el FIFO de entrada (los agentes que estaban *
+ *             bloqueados en open() continuan) y el reloj sigue desde la ultima hora replicada. Los         *
+ *             archivos de salida llevan el prefijo "respaldo_".                                            *
+ ************************************************************************************************************/
+static int ejecutar_respaldo(controlador_t *ctrl, const char *socket_respaldo)
+{
+    strncpy(ctrl->prefijo_archivos, "respaldo_", sizeof(ctrl->prefijo_archivos) - 1);
+
+    if (servidor_inicializar_estado(ctrl) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    if (replica_seguir(socket_respaldo, ctrl) != 0) {
+        ctrl->pipe_entrada[0] = '\0';      /* El FIFO es del primario: no borrarlo */
+        servidor_destruir(ctrl);
+        return EXIT_FAILURE;
+    }
+
+    if (CTRL_HORA_ACTUAL(ctrl) >= ctrl->hora_fin) {
+        ctrl->pipe_entrada[0] = '\0';
+    } else {
+        printf("[RESPALDO] El primario cayo a las %d:00: se toma el FIFO %s\n",
+               CTRL_HORA_ACTUAL(ctrl), ctrl->pipe_entrada);
+
+        if (servidor_arrancar(ctrl) != 0) {
+            servidor_destruir(ctrl);
+            return EXIT_FAILURE;
+        }
+
+        while (CTRL_ACTIVO(ctrl)) {
+            sleep(1);
+        }
+    }
+
+    servidor_destruir(ctrl);
+    return EXIT_SUCCESS;
+}
 
 int main(int argc, char *argv[])
 {
     controlador_t ctrl;
 
+    memset(&ctrl, 0, sizeof(ctrl));
+
+    /* Los FIFOs de respuesta quedan abiertos: si un agente termina, write() debe fallar con EPIPE
+     * (y reabrirse) en lugar de matar al controlador */
+    signal(SIGPIPE, SIG_IGN);
+
     /* ---- Variables auxiliares para argumentos ---- */
     int horaIni    = -1;
     int horaFin    = -1;
     int segHoras   = -1;
     int aforoTotal = -1;
+    int duracion   = -1;           /* -1 = sin -d: por defecto, o la de la traza al repetir */
     char pipeRecibe[MAX_LONG_NOMBRE_PIPE] = {0};
 
+    /* ---- Control de admision (opcionales, 0 = sin limite) ---- */
+    double tasaAgente  = 0;
+    double rafaga      = 0;
+    int    marcaAgua   = 0;
+
+    /* ---- Grabacion / repeticion de trazas ---- */
+    char trazaGrabar[MAX_LONG_NOMBRE_PIPE]  = {0};
+    char trazaRepetir[MAX_LONG_NOMBRE_PIPE] = {0};
+    int  ritmoOriginal = 0;
+
+    /* ---- Latencia por etapas (0 = desactivada) ---- */
+    int  muestreo = 0;
+
+    /* ---- Modo multi-parque ---- */
+    char configParques[MAX_LONG_NOMBRE_PIPE] = {0};
+
+    /* ---- Replicacion: socket hacia el respaldo (-P) o en el que escucha el respaldo (-S) ---- */
+    char socketPrimario[MAX_LONG_NOMBRE_PIPE] = {0};
+    char socketRespaldo[MAX_LONG_NOMBRE_PIPE] = {0};
+
+    /* ---- Baja latencia: nucleo del hilo de agentes (-1 = lectura bloqueante) ---- */
+    int nucleoSondeo = -1;
+    int giroMaxUs    = 0;
+
+    /* ---- Respuestas agrupadas por agente (-1 = plazo por defecto, 0 = sin agrupar) ---- */
+    int plazoRespuestas = -1;
+
     /* ---- Procesar argumentos de la linea de comandos ----
      * Sintaxis esperada:
      *     ./controlador -i horaIni -f horaFin -s segHoras -t total -p pipeRecibe
+     *                   [-r solicitudesPorSegundo] [-b rafaga] [-w bytesPendientes]
+     *                   [-g trazaGrabar] [-m muestreoLatencia] [-j eventosChrome.json]
+     *                   [-k /memoriaDisponibilidad] [-e]      (-e = lista de espera)
+     *                   [-P socket | -S socket]   (primario que replica / respaldo que lo sigue)
+     *                   [-u nucleo[:giroMaxUs]]   (hilo de agentes fijo al nucleo, girando sobre el FIFO)
+     *                   [-X reservas.col]         (exportacion columnar de cada reserva)
+     *                   [-d horasReserva]         (horas que ocupa cada reserva, 2 por defecto)
+     *                   [-l plazoRespuestasUs]    (espera maxima de una respuesta en cola, 0 = inmediata)
+     *     ./controlador -R trazaRepetir [-x]      (repeticion sin FIFOs; -x = ritmo original)
+     *     ./controlador -c parques.conf           (varios parques en un solo proceso)
      */
     int opt;
-    while ((opt = getopt(argc, argv, "i:f:s:t:p:")) != -1) {
+    while ((opt = getopt(argc, argv, "i:f:s:t:p:r:b:w:g:R:xm:j:c:k:eP:S:u:X:d:l:")) != -1) {
         switch (opt) {
         case 'i':
             horaIni = atoi(optarg);
@@ -59,34 +239,142 @@ int main(int argc, char *argv[])
             strncpy(pipeRecibe, optarg, MAX_LONG_NOMBRE_PIPE - 1);
             pipeRecibe[MAX_LONG_NOMBRE_PIPE - 1] = '\0';
             break;
+        case 'r':
+            tasaAgente = atof(optarg);
+            break;
+        case 'b':
+            rafaga = atof(optarg);
+            break;
+        case 'w':
+            marcaAgua = atoi(optarg);
+            break;
+        case 'g':
+            strncpy(trazaGrabar, optarg, sizeof(trazaGrabar) - 1);
+            break;
+        case 'R':
+            strncpy(trazaRepetir, optarg, sizeof(trazaRepetir) - 1);
+            break;
+        case 'x':
+            ritmoOriginal = 1;
+            break;
+        case 'm':
+            muestreo = atoi(optarg);
+            break;
+        case 'j':
+            strncpy(ctrl.ruta_eventos_chrome, optarg, MAX_LONG_NOMBRE_PIPE - 1);
+            break;
+        case 'k':
+            strncpy(ctrl.nombre_memoria, optarg, MAX_LONG_NOMBRE_MEMORIA - 1);
+            break;
+        case 'e':
+            ctrl.lista_espera = 1;
+            break;
+        case 'X':
+            strncpy(ctrl.ruta_exportacion, optarg, MAX_LONG_NOMBRE_PIPE - 1);
+            break;
+        case 'P':
+            strncpy(socketPrimario, optarg, sizeof(socketPrimario) - 1);
+            break;
+        case 'S':
+            strncpy(socketRespaldo, optarg, sizeof(socketRespaldo) - 1);
+            break;
+        case 'u':
+            if (sscanf(optarg, "%d:%d", &nucleoSondeo, &giroMaxUs) < 1 || nucleoSondeo < 0) {
+                fprintf(stderr, "Error: -u espera nucleo[:giroMaxUs].\n");
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'd':
+            duracion = atoi(optarg);
+            break;
+        case 'l':
+            plazoRespuestas = atoi(optarg);
+            if (plazoRespuestas < 0) {
+                fprintf(stderr, "Error: -l espera un plazo en microsegundos (0 = sin agrupar).\n");
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'c':
+            strncpy(configParques, optarg, sizeof(configParques) - 1);
+            break;
         default:
             fprintf(stderr,
-                    "Uso: %s -i horaIni -f horaFin -s segHoras -t total -p pipeRecibe\n",
-                    argv[0]);
+                    USO_CONTROLADOR,
+                    argv[0], argv[0], argv[0]);
             return EXIT_FAILURE;
         }
     }
 
+    ctrl.muestreo_latencia = muestreo;
+    ctrl.duracion_reserva  = (duracion != -1) ? duracion : DURACION_RESERVA_DEFECTO;
+    ctrl.plazo_respuestas_us = (plazoRespuestas != -1) ? plazoRespuestas : PLAZO_RESPUESTAS_US_DEFECTO;
+
+    if (duracion != -1 && (duracion <= 0 || duracion > MAX_HORAS_DIA)) {
+        fprintf(stderr, "Error: -d espera una duracion de reserva entre 1 y %d horas.\n", MAX_HORAS_DIA);
+        return EXIT_FAILURE;
+    }
+
+    /* ---- Modo multi-parque: la grabacion y la repeticion son solo de un parque ---- */
+    if (configParques[0] != '\0') {
+        if (trazaGrabar[0] != '\0' || trazaRepetir[0] != '\0' ||
+            socketPrimario[0] != '\0' || socketRespaldo[0] != '\0' || nucleoSondeo != -1 ||
+            plazoRespuestas != -1) {
+            fprintf(stderr, "Error: -c no se puede combinar con -g, -R, -P, -S, -u ni -l "
+                            "(el plazo va en parques.conf).\n");
+            return EXIT_FAILURE;
+        }
+        return ejecutar_parques(configParques);
+    }
+
+    if (socketPrimario[0] != '\0' && socketRespaldo[0] != '\0') {
+        fprintf(stderr, "Error: -P y -S son excluyentes.\n");
+        return EXIT_FAILURE;
+    }
+
+    /* ---- La lista de espera no se replica: tras la conmutacion se perderia sin avisos ---- */
+    if (ctrl.lista_espera && (socketPrimario[0] != '\0' || socketRespaldo[0] != '\0')) {
+        fprintf(stderr, "Error: -e no se puede combinar con -P ni -S (la lista de espera no se replica).\n");
+        return EXIT_FAILURE;
+    }
+
+    /* ---- Modo repeticion: no se necesitan FIFO ni reloj ---- */
+    if (trazaRepetir[0] != '\0') {
+        if (nucleoSondeo != -1) {
+            fprintf(stderr, "Error: -u no aplica a la repeticion (no hay FIFO).\n");
+            return EXIT_FAILURE;
+        }
+        if (tasaAgente < 0 || rafaga < 0 || marcaAgua < 0 || muestreo < 0) {
+            fprintf(stderr, "Error: parametros invalidos.\n");
+            return EXIT_FAILURE;
+        }
+        ctrl.tasa_por_agente   = tasaAgente;
+        ctrl.rafaga_por_agente = rafaga;
+        ctrl.marca_agua_fifo   = marcaAgua;
+
+        return repetir_traza(&ctrl, trazaRepetir, ritmoOriginal, horaIni, horaFin, aforoTotal, duracion);
+    }
+
     /* ---- Verificar que todos los parametros obligatorios fueron suministrados ---- */
     if (horaIni == -1 || horaFin == -1 || segHoras == -1 ||
         aforoTotal == -1 || pipeRecibe[0] == '\0') {
 
         fprintf(stderr, "Error: faltan parametros obligatorios.\n");
         fprintf(stderr,
-                "Uso: %s -i horaIni -f horaFin -s segHoras -t total -p pipeRecibe\n",
-                argv[0]);
+                USO_CONTROLADOR,
+                argv[0], argv[0], argv[0]);
         return EXIT_FAILURE;
     }
 
     /* ---- Validar rangos de los parametros ---- */
     if (horaIni < HORA_MINIMA_SIMULACION || horaIni > HORA_MAXIMA_SIMULACION ||
         horaFin < HORA_MINIMA_SIMULACION || horaFin > HORA_MAXIMA_SIMULACION ||
-        horaFin < horaIni || segHoras <= 0 || aforoTotal <= 0) {
+        horaFin < horaIni || segHoras <= 0 || aforoTotal <= 0 ||
+        tasaAgente < 0 || rafaga < 0 || marcaAgua < 0 || muestreo < 0) {
 
         fprintf(stderr, "Error: parametros invalidos.\n");
         fprintf(stderr,
-                "Uso: %s -i horaIni -f horaFin -s segHoras -t total -p pipeRecibe\n",
-                argv[0]);
+                USO_CONTROLADOR,
+                argv[0], argv[0], argv[0]);
         return EXIT_FAILURE;
     }
 
@@ -95,11 +383,41 @@ int main(int argc, char *argv[])
     ctrl.hora_fin          = horaFin;
     ctrl.segundos_por_hora = segHoras;
     ctrl.aforo_maximo      = aforoTotal;
+    ctrl.tasa_por_agente   = tasaAgente;
+    ctrl.rafaga_por_agente = rafaga;
+    ctrl.marca_agua_fifo   = marcaAgua;
 
     /* Nombre del FIFO de entrada (pipeRecibe) -> campo pipe_entrada */
     strncpy(ctrl.pipe_entrada, pipeRecibe, MAX_LONG_NOMBRE_PIPE - 1);
     ctrl.pipe_entrada[MAX_LONG_NOMBRE_PIPE - 1] = '\0';
 
+    /* ---- Baja latencia: ningun otro hilo (reloj, replicacion) usa el nucleo del lector ---- */
+    if (nucleoSondeo != -1) {
+        sondeo_inicializar(&ctrl.sondeo, nucleoSondeo, giroMaxUs);
+        sondeo_excluir_nucleo(nucleoSondeo);
+    }
+
+    /* ---- Grabar la traza de entrada, si se pidio ---- */
+    if (trazaGrabar[0] != '\0') {
+        ctrl.traza = traza_abrir_escritura(trazaGrabar, &ctrl);
+        if (ctrl.traza == NULL) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* ---- Respaldo: seguir al primario y tomar su lugar si cae antes del fin del dia ---- */
+    if (socketRespaldo[0] != '\0') {
+        return ejecutar_respaldo(&ctrl, socketRespaldo);
+    }
+
+    /* ---- Primario: conectar con el respaldo antes de la primera decision ---- */
+    if (socketPrimario[0] != '\0') {
+        ctrl.replica = replica_conectar(socketPrimario, &ctrl);
+        if (ctrl.replica == NULL) {
+            return EXIT_FAILURE;
+        }
+    }
+
     /* ---- Inicializar el servidor (estructuras internas, FIFO y hilos) ---- */
     if (servidor_inicializar(&ctrl) != 0) {
         fprintf(stderr, "Error: no fue posible inicializar el servidor de reservas.\n");
@@ -107,7 +425,7 @@ int main(int argc, char *argv[])
     }
 
     /* ---- Bucle de espera del proceso principal ---- */
-    while (ctrl.simulacion_activa) {
+    while (CTRL_ACTIVO(&ctrl)) {
         sleep(1);
     }
 
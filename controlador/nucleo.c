@@ -0,0 +1,84 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 05/12/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    nucleo.c                                                                                    *
+ *                                                                                                         *
+ * Descripcion: Nucleo generico de admision, nucleos de sede generados al compilar y eleccion del nucleo   *
+ *              de cada parque (ver nucleo.h).                                                             *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include "nucleo.h"
+
+/************************************************************************************************************
+ *  int nucleo_buscar_generico(const int *ocupacion, int desde, int num_pers, int hora_fin, int aforo, ...) *
+ *                                                                                                          *
+ *  Proposito: Recorrido hora por hora: para cada inicio se revisan la hora y las siguientes de su bloque   *
+ *             (las que quedan antes del cierre). Sirve para cualquier configuracion.                       *
+ ************************************************************************************************************/
+int nucleo_buscar_generico(const int *ocupacion, int desde, int num_pers,
+                           int hora_fin, int aforo, int duracion)
+{
+    int hora, h;
+
+    for (hora = desde; hora < hora_fin; hora++) {
+        if (ocupacion[hora] + num_pers > aforo) continue;
+
+        for (h = hora + 1; h < hora + duracion && h < hora_fin; h++) {
+            if (ocupacion[h] + num_pers > aforo) break;
+        }
+        if (h >= hora + duracion || h >= hora_fin) return hora;
+    }
+    return -1;
+}
+
+/* ---- Nucleos de sede: una funcion por linea NUCLEO_SEDE(cierre, aforo, duracion) ---- */
+#define NUCLEO_SEDE(fin, aforo, dur)                                                                        \
+    static int buscar_sede_##fin##_##aforo##_##dur(const int *ocupacion, int desde, int num_pers,          \
+                                                   int hora_fin, int aforo_parque, int duracion)           \
+    {                                                                                                       \
+        (void) hora_fin; (void) aforo_parque; (void) duracion;                                              \
+        return nucleo_buscar_mascara(ocupacion, desde, num_pers, fin, aforo, dur);                          \
+    }
+#include "nucleos_sede.h"
+#undef NUCLEO_SEDE
+
+#define NUCLEO_SEDE(fin, aforo, dur) { buscar_sede_##fin##_##aforo##_##dur, 1, fin, aforo, dur },
+static const nucleo_admision_t nucleos_sede[] = {
+#include "nucleos_sede.h"
+    { nucleo_buscar_generico, 0, 0, 0, 0 }      /* Centinela */
+};
+#undef NUCLEO_SEDE
+
+/************************************************************************************************************
+ *  void nucleo_elegir(nucleo_admision_t *n, int hora_fin, int aforo, int duracion)                         *
+ *                                                                                                          *
+ *  Proposito: Dejar en n el nucleo generado para esta configuracion, o el generico si no hay ninguno.      *
+ ************************************************************************************************************/
+void nucleo_elegir(nucleo_admision_t *n, int hora_fin, int aforo, int duracion)
+{
+    const nucleo_admision_t *s;
+
+    for (s = nucleos_sede; s->especializado; s++) {
+        if (s->hora_fin == hora_fin && s->aforo == aforo && s->duracion == duracion) {
+            *n = *s;
+            return;
+        }
+    }
+
+    *n = *s;
+    n->hora_fin = hora_fin;
+    n->aforo    = aforo;
+    n->duracion = duracion;
+}
+
+int nucleo_num_especializados(void)
+{
+    return (int) (sizeof(nucleos_sede) / sizeof(nucleos_sede[0])) - 1;
+}
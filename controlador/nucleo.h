@@ -0,0 +1,109 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 05/12/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera de los nucleos de admision: buscan la primera hora, desde una   *
+ *               hora dada y antes del cierre, en la que un grupo cabe durante todo su bloque.       *
+ *                                                                                                   *
+ *               - Nucleo generico: recorre hora por hora con la configuracion del parque.           *
+ *               - Nucleos de sede: uno por cada configuracion (cierre, aforo, duracion) listada en  *
+ *                 el archivo que se pasa a "make SEDE=parques.conf". generar_nucleos.sh escribe     *
+ *                 nucleos_sede.h y nucleo.c compila una copia de nucleo_buscar_mascara() con esos   *
+ *                 valores como constantes: el bloque de la hora pedida, el numero de vectores a     *
+ *                 comparar y la ventana quedan fijos y desenrollados.                               *
+ *                                                                                                   *
+ *               nucleo_elegir() se llama al iniciar el parque y devuelve el nucleo de su            *
+ *               configuracion, o el generico si no se genero ninguno para ella.                     *
+ *                                                                                                   *
+ *               No depende de controlador.h.                                                        *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __NUCLEO_H__
+#define __NUCLEO_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdint.h>
+#include <string.h>
+
+#define HORAS_POR_VECTOR_NUCLEO       4       /* Enteros por comparacion (un registro SSE)    */
+
+/* ---- Firma comun: los nucleos de sede ignoran los tres ultimos parametros ---- */
+typedef int (*nucleo_buscar_fn)(const int *ocupacion, int desde, int num_pers,
+                                int hora_fin, int aforo, int duracion);
+
+typedef struct {
+    nucleo_buscar_fn buscar;
+    int              especializado;     /* 0 = generico                                       */
+    int              hora_fin;          /* Configuracion para la que se genero                */
+    int              aforo;
+    int              duracion;
+} nucleo_admision_t;
+
+typedef int vector_horas_t __attribute__((vector_size(HORAS_POR_VECTOR_NUCLEO * sizeof(int))));
+
+/************************************************************************************************************
+ *  static inline int nucleo_buscar_mascara(const int *ocupacion, int desde, int num_pers, ...)             *
+ *                                                                                                          *
+ *  Proposito: Primero se revisa el bloque de la hora pedida, hora por hora: es el caso comun y sale con    *
+ *             pocas comparaciones. Si no cabe, la ocupacion desde esa hora hasta el cierre se compara de   *
+ *             a 4 horas contra (aforo - num_pers) y se arma una mascara con las horas en las que el grupo  *
+ *             no cabe. Una hora sirve de inicio si ninguna de las 'duracion' horas de su bloque (las que   *
+ *             quedan antes del cierre) esta marcada: la ventana sale de desplazar la mascara y la primera  *
+ *             hora libre de contar ceros. Con los parametros constantes todo queda desenrollado.           *
+ *             Lee ocupacion hasta hora_fin redondeado a 4 (con hora_fin <= 24 no pasa del arreglo).        *
+ *                                                                                                          *
+ *  Retorno:   La primera hora valida en [desde, hora_fin), o -1 si no hay ninguna.                         *
+ ************************************************************************************************************/
+static inline __attribute__((always_inline))
+int nucleo_buscar_mascara(const int *ocupacion, int desde, int num_pers,
+                          int hora_fin, int aforo, int duracion)
+{
+    const vector_horas_t pesos  = { 1, 2, 4, 8 };
+    const vector_horas_t limite = (vector_horas_t) { 0 } + (aforo - num_pers);
+    uint32_t llenas = 0, ventana, validas;
+    int v, k;
+
+    if (desde >= hora_fin) return -1;
+
+    /* ---- La hora pedida ---- */
+    for (k = 0; k < duracion && desde + k < hora_fin; k++) {
+        if (ocupacion[desde + k] + num_pers > aforo) break;
+    }
+    if (k == duracion || desde + k >= hora_fin) return desde;
+
+    /* ---- Las siguientes, de a un vector: bit h = el grupo no cabe a la hora h ---- */
+    for (v = (desde + 1) / HORAS_POR_VECTOR_NUCLEO; v * HORAS_POR_VECTOR_NUCLEO < hora_fin; v++) {
+        vector_horas_t horas;
+
+        memcpy(&horas, ocupacion + v * HORAS_POR_VECTOR_NUCLEO, sizeof(horas));
+        vector_horas_t bits = (horas > limite) & pesos;
+        bits |= __builtin_shuffle(bits, (vector_horas_t) { 2, 3, 0, 1 });
+        bits |= __builtin_shuffle(bits, (vector_horas_t) { 1, 0, 3, 2 });
+        llenas |= (uint32_t) bits[0] << (v * HORAS_POR_VECTOR_NUCLEO);
+    }
+
+    /* ---- Las horas desde el cierre no cuentan para el bloque ---- */
+    llenas &= (1u << hora_fin) - 1u;
+
+    ventana = llenas;
+    for (k = 1; k < duracion; k++) {
+        ventana |= llenas >> k;
+    }
+
+    validas = ~ventana & ((1u << hora_fin) - 1u) & ~((2u << desde) - 1u);
+    return (validas != 0) ? __builtin_ctz(validas) : -1;
+}
+
+/***************************************** Prototipos *******************************************************/
+
+int  nucleo_buscar_generico(const int *ocupacion, int desde, int num_pers,
+                            int hora_fin, int aforo, int duracion);
+void nucleo_elegir(nucleo_admision_t *n, int hora_fin, int aforo, int duracion);
+int  nucleo_num_especializados(void);
+
+#endif /* __NUCLEO_H__ */
@@ -0,0 +1,648 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 24/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    parques.c                                                                                   *
+ *                                                                                                         *
+ * Descripcion: Controlador multi-parque. El enrutador solo mira el campo de parque de cada mensaje y lo   *
+ *              encola; todo el trabajo de admision ocurre en el hilo del parque, que es el unico que toca *
+ *              su controlador_t (salvo el reloj de ese mismo parque, bajo su mutex). Entre parques no hay *
+ *              ningun lock compartido.                                                                    *
+ ************************************************************************************************************/
+
+#define _GNU_SOURCE
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "parques.h"
+
+#define ESPERA_ENRUTADOR_MS           500     /* Cada cuanto revisa el enrutador si termino  */
+
+/************************************************************************************************************
+ *  static int cola_encolar(cola_parque_t *c, const char *linea, int longitud, uint64_t t_ns,              *
+ *                          int pendientes)                                                                 *
+ *                                                                                                          *
+ *  Proposito: Lado productor (enrutador). Publica la entrada con store-release sobre la cabeza.            *
+ *                                                                                                          *
+ *  Retorno:   1 si se encolo; 0 si la cola esta llena.                                                     *
+ ************************************************************************************************************/
+static int cola_encolar(cola_parque_t *c, const char *linea, int longitud, uint64_t t_ns,
+                        int pendientes)
+{
+    size_t cabeza = atomic_load_explicit(&c->cabeza, memory_order_relaxed);
+    size_t cola   = atomic_load_explicit(&c->cola,   memory_order_acquire);
+
+    if (cabeza - cola >= TAM_COLA_PARQUE) {
+        return 0;
+    }
+
+    entrada_cola_t *e = &c->entradas[cabeza & (TAM_COLA_PARQUE - 1)];
+    e->t_ns       = t_ns;
+    e->pendientes = pendientes;
+    memcpy(e->linea, linea, longitud + 1);
+
+    atomic_store_explicit(&c->cabeza, cabeza + 1, memory_order_release);
+    atomic_fetch_add_explicit(&c->bytes, longitud + 1, memory_order_relaxed);
+    sem_post(&c->disponibles);
+
+    return 1;
+}
+
+/************************************************************************************************************
+ *  static int cola_desencolar(cola_parque_t *c, entrada_cola_t *destino)                                   *
+ *                                                                                                          *
+ *  Proposito: Lado consumidor (hilo del parque). Copia la entrada y libera su posicion.                    *
+ *                                                                                                          *
+ *  Retorno:   1 si habia una entrada; 0 si la cola estaba vacia.                                           *
+ ************************************************************************************************************/
+static int cola_desencolar(cola_parque_t *c, entrada_cola_t *destino)
+{
+    size_t cola   = atomic_load_explicit(&c->cola,   memory_order_relaxed);
+    size_t cabeza = atomic_load_explicit(&c->cabeza, memory_order_acquire);
+
+    if (cola == cabeza) {
+        return 0;
+    }
+
+    const entrada_cola_t *e = &c->entradas[cola & (TAM_COLA_PARQUE - 1)];
+    int longitud = (int) strlen(e->linea);
+
+    destino->t_ns       = e->t_ns;
+    destino->pendientes = e->pendientes;
+    memcpy(destino->linea, e->linea, longitud + 1);
+
+    atomic_store_explicit(&c->cola, cola + 1, memory_order_release);
+    atomic_fetch_sub_explicit(&c->bytes, longitud + 1, memory_order_relaxed);
+
+    return 1;
+}
+
+/************************************************************************************************************
+ *  static int campo_mensaje(const char *linea, int n, char *destino, size_t tam)                           *
+ *                                                                                                          *
+ *  Proposito: Copiar el campo n (desde 0) de una linea separada por ';' sin modificarla.                   *
+ *                                                                                                          *
+ *  Retorno:   1 si el campo existe; 0 si la linea tiene menos campos.                                      *
+ ************************************************************************************************************/
+static int campo_mensaje(const char *linea, int n, char *destino, size_t tam)
+{
+    const char *p = linea;
+    size_t largo;
+
+    while (n-- > 0) {
+        p = strchr(p, ';');
+        if (p == NULL) return 0;
+        p++;
+    }
+
+    largo = strcspn(p, ";");
+    if (largo >= tam) largo = tam - 1;
+
+    memcpy(destino, p, largo);
+    destino[largo] = '\0';
+    return 1;
+}
+
+/************************************************************************************************************
+ *  static int parque_de_mensaje(const char *linea, char *pipe_resp, char *id_solicitud)                    *
+ *                                                                                                          *
+ *  Proposito: Extraer el parque destino, el pipe de respuesta y el identificador de solicitud (opcional,   *
+ *             ver servidor_etiquetar_respuesta) de un mensaje:                                             *
+ *               REGISTRO;Nombre;Pipe[;Parque]                                                              *
+ *               SOLICITUD;Familia;Personas;HoraIni;HoraFin;Pipe[;Parque[;Id]]                              *
+ *               DISPONIBILIDAD;Pipe[;Parque[;Id]]                                                          *
+ *               CANCELACION;Familia;Pipe[;Parque[;Id]]                                                     *
+ *             Sin campo de parque se usa el parque 0, igual que el controlador de un solo parque.          *
+ *                                                                                                          *
+ *  Retorno:   Id del parque, o -1 si el tipo de mensaje no se reconoce.                                    *
+ ************************************************************************************************************/
+static int parque_de_mensaje(const char *linea, char *pipe_resp, char *id_solicitud)
+{
+    char campo[MAX_LONG_NOMBRE_PIPE];
+    int  pos_pipe;
+
+    if (strncmp(linea, "REGISTRO;", 9) == 0) {
+        pos_pipe = 2;
+    } else if (strncmp(linea, "SOLICITUD;", 10) == 0) {
+        pos_pipe = 5;
+    } else if (strncmp(linea, "DISPONIBILIDAD;", 15) == 0) {
+        pos_pipe = 1;
+    } else if (strncmp(linea, "CANCELACION;", 12) == 0) {
+        pos_pipe = 2;
+    } else {
+        return -1;
+    }
+
+    if (!campo_mensaje(linea, pos_pipe, pipe_resp, MAX_LONG_NOMBRE_PIPE)) {
+        pipe_resp[0] = '\0';
+    }
+
+    if (!campo_mensaje(linea, pos_pipe + 2, id_solicitud, MAX_LONG_NOMBRE_FAMILIA)) {
+        id_solicitud[0] = '\0';
+    }
+
+    if (!campo_mensaje(linea, pos_pipe + 1, campo, sizeof(campo)) || campo[0] == '\0') {
+        return 0;
+    }
+
+    return atoi(campo);
+}
+
+/************************************************************************************************************
+ *  static void responder_cerrado(salida_respuestas_t *s, const char *linea, int id)                        *
+ *                                                                                                          *
+ *  Proposito: Negar una solicitud o cancelacion para un parque cuyo dia ya termino (su reloj llamo a       *
+ *             CTRL_DETENER). Con un solo parque el controlador deja de leer al cierre; aqui los demas      *
+ *             parques siguen abiertos, asi que se responde sin pasar por el motor.                         *
+ ************************************************************************************************************/
+static void responder_cerrado(salida_respuestas_t *s, const char *linea, int id)
+{
+    char pipe_resp[MAX_LONG_NOMBRE_PIPE];
+    char texto[MAX_LONG_MENSAJE];
+    char id_solicitud[MAX_LONG_NOMBRE_FAMILIA];
+
+    if (parque_de_mensaje(linea, pipe_resp, id_solicitud) == -1 || pipe_resp[0] == '\0') return;
+
+    snprintf(texto, sizeof(texto), "NEGADA: Parque %d cerrado", id);
+    servidor_etiquetar_respuesta(texto, sizeof(texto), id_solicitud);
+    salida_encolar(s, pipe_resp, texto, NULL, NULL);
+}
+
+/************************************************************************************************************
+ *  static void *hilo_parque(void *arg)                                                                     *
+ *                                                                                                          *
+ *  Proposito: Hilo de admision de un parque: toma mensajes de su cola y los pasa al motor de reservas.     *
+ *             Las solicitudes y cancelaciones que quedaron en cola al cerrar se niegan sin pasar por el    *
+ *             motor.                                                                                       *
+ ************************************************************************************************************/
+static void *hilo_parque(void *arg)
+{
+    parque_t      *p    = (parque_t *) arg;
+    controlador_t *ctrl = p->ctrl;
+
+    entrada_cola_t entrada;
+    char texto_respuesta[MAX_LONG_MENSAJE];
+    char pipe_resp[MAX_LONG_NOMBRE_PIPE];
+
+    sondeo_fijar_nucleo(p->cpu);
+
+    for (;;) {
+        /* ---- Sin mensajes en la cola: las respuestas pendientes salen antes de dormir ---- */
+        if (sem_trywait(&p->cola->disponibles) != 0) {
+            salida_vaciar(&ctrl->salida);
+            while (sem_wait(&p->cola->disponibles) == -1 && errno == EINTR) {
+                /* reintentar */
+            }
+        }
+
+        if (!cola_desencolar(p->cola, &entrada)) {
+            /* Despertar sin mensaje: solo ocurre al apagar */
+            if (!atomic_load(p->activo)) break;
+            continue;
+        }
+
+        if ((entrada.linea[0] == 'S' || entrada.linea[0] == 'C') && !CTRL_ACTIVO(ctrl)) {
+            responder_cerrado(&ctrl->salida, entrada.linea, p->id);
+            salida_vencer(&ctrl->salida);
+            continue;
+        }
+
+        mensaje_entrada_t  msg;
+        muestra_latencia_t muestra;
+
+        msg.linea      = entrada.linea;
+        msg.t_ns       = entrada.t_ns;
+        msg.pendientes = entrada.pendientes;
+        msg.muestra    = latencia_muestrear(&ctrl->latencia, &muestra);
+        if (msg.muestra != NULL) {
+            msg.muestra->t[MARCA_RECIBIDO] = entrada.t_ns;
+        }
+
+        /* ---- La muestra de un mensaje con respuesta se cierra al escribirla (ver salida.h) ---- */
+        if (servidor_procesar_mensaje(ctrl, &msg, texto_respuesta,
+                                      sizeof(texto_respuesta), pipe_resp)) {
+            salida_encolar(&ctrl->salida, pipe_resp, texto_respuesta, msg.muestra, msg.linea);
+        } else {
+            salida_registrar(&ctrl->salida, msg.muestra, msg.linea);
+        }
+        salida_vencer(&ctrl->salida);
+    }
+
+    return NULL;
+}
+
+/************************************************************************************************************
+ *  static void enrutar_linea(multiparque_t *mp, const char *linea, int longitud, int pendientes_locales)   *
+ *                                                                                                          *
+ *  Proposito: Encolar la linea en su parque. Si el parque no existe, ya cerro o su cola esta llena se      *
+ *             responde de inmediato desde el enrutador. Las consultas DISPONIBILIDAD tambien se responden  *
+ *             aqui, desde la instantanea del parque, sin pasar por su hilo de admision.                    *
+ ************************************************************************************************************/
+static void enrutar_linea(multiparque_t *mp, const char *linea, int longitud, int pendientes_locales)
+{
+    char pipe_resp[MAX_LONG_NOMBRE_PIPE];
+    char texto[MAX_LONG_MENSAJE];
+    char id_solicitud[MAX_LONG_NOMBRE_FAMILIA];
+    int  id;
+
+    if (longitud >= MAX_LONG_MENSAJE) {
+        fprintf(stderr, "[PARQUES] Mensaje demasiado largo, descartado.\n");
+        return;
+    }
+
+    id = parque_de_mensaje(linea, pipe_resp, id_solicitud);
+    if (id == -1) {
+        fprintf(stderr, "[PARQUES] Mensaje desconocido: \"%s\"\n", linea);
+        return;
+    }
+
+    if (id < 0 || id >= MAX_PARQUES || mp->parques[id].ctrl == NULL) {
+        if (pipe_resp[0] != '\0') {
+            snprintf(texto, sizeof(texto), "NEGADA: Parque %d no existe", id);
+            servidor_etiquetar_respuesta(texto, sizeof(texto), id_solicitud);
+            salida_encolar(&mp->salida, pipe_resp, texto, NULL, NULL);
+        }
+        return;
+    }
+
+    parque_t *p = &mp->parques[id];
+
+    /* ---- Dia terminado: los demas parques siguen, este ya no admite (el registro si se atiende) ---- */
+    if ((linea[0] == 'S' || linea[0] == 'C') && !CTRL_ACTIVO(p->ctrl)) {
+        responder_cerrado(&mp->salida, linea, id);
+        return;
+    }
+
+    if (linea[0] == 'D') {
+        vista_disponibilidad_t vista;
+
+        if (pipe_resp[0] != '\0') {
+            if (disponibilidad_leer(p->ctrl->disponibilidad.inst, &vista) != 0) {
+                /* Publicacion en curso que no termina: con el mutex del parque no hay escritor */
+                pthread_mutex_lock(&p->ctrl->mutex);
+                disponibilidad_leer(p->ctrl->disponibilidad.inst, &vista);
+                pthread_mutex_unlock(&p->ctrl->mutex);
+            }
+            disponibilidad_formatear(&vista, texto, sizeof(texto));
+            servidor_etiquetar_respuesta(texto, sizeof(texto), id_solicitud);
+            salida_encolar(&mp->salida, pipe_resp, texto, NULL, NULL);
+        }
+        return;
+    }
+
+    int pendientes = admision_pendientes_fifo(&p->ctrl->admision, mp->fifo_fd, pendientes_locales);
+    if (p->ctrl->admision.marca_agua_fifo > 0) {
+        pendientes += atomic_load_explicit(&p->cola->bytes, memory_order_relaxed);
+    }
+
+    if (!cola_encolar(p->cola, linea, longitud, reloj_monotonico_ns(), pendientes)) {
+        if (pipe_resp[0] != '\0') {
+            snprintf(texto, sizeof(texto), "OCUPADO: reintentar en %d ms", REINTENTO_MINIMO_MS);
+            servidor_etiquetar_respuesta(texto, sizeof(texto), id_solicitud);
+            salida_encolar(&mp->salida, pipe_resp, texto, NULL, NULL);
+        }
+    }
+}
+
+/************************************************************************************************************
+ *  static void *hilo_enrutador(void *arg)                                                                  *
+ *                                                                                                          *
+ *  Proposito: Leer el FIFO de entrada y repartir los mensajes. Espera con poll() para poder notar que      *
+ *             todos los parques terminaron su dia, y sin pasar del plazo de sus propias respuestas.        *
+ ************************************************************************************************************/
+static void *hilo_enrutador(void *arg)
+{
+    multiparque_t  *mp = (multiparque_t *) arg;
+    lector_lineas_t lector;
+
+    lector_inicializar(&lector);
+
+    while (atomic_load(&mp->activo) && parques_activo(mp)) {
+
+        int listo = salida_esperar_entrada(&mp->salida, mp->fifo_fd, ESPERA_ENRUTADOR_MS);
+        if (listo <= 0) {
+            if (listo < 0 && errno != EINTR) perror("[PARQUES] poll(FIFO)");
+            continue;
+        }
+
+        int read_bytes = lector_leer(&lector, mp->fifo_fd);
+        if (read_bytes <= 0) {
+            if (read_bytes < 0 && errno != EINTR) perror("[PARQUES] read(FIFO)");
+            continue;
+        }
+
+        char *linea;
+        int   longitud, pendientes_locales;
+
+        while ((linea = lector_siguiente(&lector, &longitud, &pendientes_locales)) != NULL) {
+            if (linea[0] != '\0') {
+                enrutar_linea(mp, linea, longitud, pendientes_locales);
+            }
+        }
+        salida_vencer(&mp->salida);
+    }
+
+    return NULL;
+}
+
+/************************************************************************************************************
+ *  int parques_cargar_configuracion(multiparque_t *mp, const char *ruta)                                   *
+ *                                                                                                          *
+ *  Proposito: Leer el archivo de configuracion y crear un controlador_t por cada linea "parque".           *
+ *                                                                                                          *
+ *  Retorno:   0 si la configuracion es valida; -1 si hay errores (se informan por stderr).                 *
+ ************************************************************************************************************/
+int parques_cargar_configuracion(multiparque_t *mp, const char *ruta)
+{
+    FILE *fp;
+    char  linea[MAX_LONG_MENSAJE];
+    char  clave[64], valor[MAX_LONG_NOMBRE_PIPE];
+    int   num_linea = 0, errores = 0;
+
+    memset(mp, 0, sizeof(*mp));
+    mp->fifo_fd           = -1;
+    mp->segundos_por_hora = -1;
+    mp->plazo_respuestas_us = PLAZO_RESPUESTAS_US_DEFECTO;
+
+    fp = fopen(ruta, "r");
+    if (fp == NULL) {
+        perror("fopen (configuracion de parques)");
+        return -1;
+    }
+
+    while (fgets(linea, sizeof(linea), fp) != NULL) {
+        num_linea++;
+
+        char *c = linea + strspn(linea, " \t");
+        if (*c == '#' || *c == '\n' || *c == '\0') continue;
+
+        if (strncmp(c, "parque", 6) == 0 && (c[6] == ' ' || c[6] == '\t')) {
+            int id, ini, fin, aforo, cpu = -1;
+            int n = sscanf(c + 6, "%d %d %d %d %d", &id, &ini, &fin, &aforo, &cpu);
+
+            if (n < 4 || id < 0 || id >= MAX_PARQUES ||
+                ini < HORA_MINIMA_SIMULACION || fin > HORA_MAXIMA_SIMULACION ||
+                fin < ini || aforo <= 0) {
+                fprintf(stderr, "%s:%d: parque invalido\n", ruta, num_linea);
+                errores++;
+                continue;
+            }
+            if (mp->parques[id].ctrl != NULL) {
+                fprintf(stderr, "%s:%d: parque %d repetido\n", ruta, num_linea, id);
+                errores++;
+                continue;
+            }
+
+            /* controlador_t esta alineado a linea de cache: calloc no lo garantiza */
+            controlador_t *ctrl = aligned_alloc(TAM_LINEA_CACHE, sizeof(controlador_t));
+            if (ctrl == NULL) {
+                perror("aligned_alloc (parque)");
+                errores++;
+                break;
+            }
+            memset(ctrl, 0, sizeof(*ctrl));
+
+            ctrl->id_parque    = id;
+            ctrl->hora_ini     = ini;
+            ctrl->hora_fin     = fin;
+            ctrl->aforo_maximo = aforo;
+            snprintf(ctrl->prefijo_archivos, sizeof(ctrl->prefijo_archivos), "parque%d_", id);
+
+            mp->parques[id].ctrl = ctrl;
+            mp->parques[id].cpu  = cpu;
+            mp->parques[id].id   = id;
+            mp->num_parques++;
+            continue;
+        }
+
+        if (sscanf(c, "%63s %127s", clave, valor) != 2) {
+            fprintf(stderr, "%s:%d: linea invalida\n", ruta, num_linea);
+            errores++;
+        } else if (strcmp(clave, "pipe") == 0) {
+            snprintf(mp->pipe_entrada, sizeof(mp->pipe_entrada), "%s", valor);
+        } else if (strcmp(clave, "segundos_por_hora") == 0) {
+            mp->segundos_por_hora = atoi(valor);
+        } else if (strcmp(clave, "tasa_por_agente") == 0) {
+            mp->tasa_por_agente = atof(valor);
+        } else if (strcmp(clave, "rafaga") == 0) {
+            mp->rafaga_por_agente = atof(valor);
+        } else if (strcmp(clave, "marca_agua") == 0) {
+            mp->marca_agua_fifo = atoi(valor);
+        } else if (strcmp(clave, "muestreo_latencia") == 0) {
+            mp->muestreo_latencia = atoi(valor);
+        } else if (strcmp(clave, "lista_espera") == 0) {
+            mp->lista_espera = atoi(valor);
+        } else if (strcmp(clave, "memoria_compartida") == 0) {
+            if (snprintf(mp->nombre_memoria, sizeof(mp->nombre_memoria), "%s", valor) >=
+                (int) sizeof(mp->nombre_memoria)) {
+                fprintf(stderr, "%s:%d: nombre de memoria demasiado largo\n", ruta, num_linea);
+                errores++;
+            }
+        } else if (strcmp(clave, "duracion_reserva") == 0) {
+            mp->duracion_reserva = atoi(valor);
+        } else if (strcmp(clave, "plazo_respuestas_us") == 0) {
+            mp->plazo_respuestas_us = atoi(valor);
+        } else if (strcmp(clave, "exportacion") == 0) {
+            snprintf(mp->ruta_exportacion, sizeof(mp->ruta_exportacion), "%s", valor);
+        } else {
+            fprintf(stderr, "%s:%d: clave desconocida '%s'\n", ruta, num_linea, clave);
+            errores++;
+        }
+    }
+    fclose(fp);
+
+    if (mp->pipe_entrada[0] == '\0' || mp->segundos_por_hora <= 0 || mp->num_parques == 0 ||
+        mp->tasa_por_agente < 0 || mp->rafaga_por_agente < 0 || mp->marca_agua_fifo < 0 ||
+        mp->muestreo_latencia < 0 || mp->duracion_reserva < 0 || mp->duracion_reserva > MAX_HORAS_DIA ||
+        mp->plazo_respuestas_us < 0) {
+        fprintf(stderr, "%s: se requieren 'pipe', 'segundos_por_hora' y al menos un 'parque'\n", ruta);
+        errores++;
+    }
+
+    /* ---- Copiar los parametros comunes a cada parque ---- */
+    int id;
+    for (id = 0; id < MAX_PARQUES; id++) {
+        controlador_t *ctrl = mp->parques[id].ctrl;
+        if (ctrl == NULL) continue;
+
+        ctrl->segundos_por_hora = mp->segundos_por_hora;
+        ctrl->tasa_por_agente   = mp->tasa_por_agente;
+        ctrl->rafaga_por_agente = mp->rafaga_por_agente;
+        ctrl->marca_agua_fifo   = mp->marca_agua_fifo;
+        ctrl->muestreo_latencia = mp->muestreo_latencia;
+        ctrl->lista_espera      = mp->lista_espera;
+        ctrl->duracion_reserva  = mp->duracion_reserva;
+        ctrl->plazo_respuestas_us = mp->plazo_respuestas_us;
+        strcpy(ctrl->ruta_exportacion, mp->ruta_exportacion);
+        if (mp->nombre_memoria[0] != '\0') {
+            snprintf(ctrl->nombre_memoria, sizeof(ctrl->nombre_memoria), "%.40s_parque%d",
+                     mp->nombre_memoria, id);
+        }
+    }
+
+    if (errores > 0) {
+        parques_destruir(mp);
+        return -1;
+    }
+
+    return 0;
+}
+
+/************************************************************************************************************
+ *  int parques_inicializar(multiparque_t *mp)                                                              *
+ *                                                                                                          *
+ *  Proposito: Crear el FIFO de entrada, el estado, la cola, el reloj y el hilo de admision de cada         *
+ *             parque, y por ultimo el enrutador.                                                           *
+ *                                                                                                          *
+ *  Retorno:   0 si todo quedo en marcha; -1 ante error (lo ya creado se libera con parques_destruir).      *
+ ************************************************************************************************************/
+int parques_inicializar(multiparque_t *mp)
+{
+    int id;
+
+    if (mkfifo(mp->pipe_entrada, 0666) == -1 && errno != EEXIST) {
+        perror("mkfifo (pipe de entrada del servidor)");
+        return -1;
+    }
+
+    mp->fifo_fd = open(mp->pipe_entrada, O_RDWR);
+    if (mp->fifo_fd == -1) {
+        perror("open (pipe de entrada del servidor)");
+        return -1;
+    }
+
+    /* ---- Respuestas del enrutador (parque inexistente, DISPONIBILIDAD, cola llena) ---- */
+    if (salida_inicializar(&mp->salida, mp->plazo_respuestas_us, NULL) != 0) {
+        close(mp->fifo_fd);
+        mp->fifo_fd = -1;
+        unlink(mp->pipe_entrada);
+        return -1;
+    }
+
+    atomic_store(&mp->activo, 1);
+
+    for (id = 0; id < MAX_PARQUES; id++) {
+        parque_t *p = &mp->parques[id];
+        if (p->ctrl == NULL) continue;
+
+        if (servidor_inicializar_estado(p->ctrl) != 0) {
+            return -1;
+        }
+        p->estado_inicializado = 1;
+
+        p->cola = aligned_alloc(TAM_LINEA_CACHE, sizeof(cola_parque_t));
+        if (p->cola == NULL) {
+            perror("aligned_alloc (cola de parque)");
+            return -1;
+        }
+        atomic_init(&p->cola->cabeza, 0);
+        atomic_init(&p->cola->cola,   0);
+        atomic_init(&p->cola->bytes,  0);
+        sem_init(&p->cola->disponibles, 0, 0);
+        p->activo = &mp->activo;
+
+        if (pthread_create(&p->ctrl->hilo_reloj, NULL, servidor_hilo_reloj, p->ctrl) != 0) {
+            perror("pthread_create (reloj de parque)");
+            return -1;
+        }
+        if (pthread_create(&p->hilo_admision, NULL, hilo_parque, p) != 0) {
+            perror("pthread_create (admision de parque)");
+            CTRL_DETENER(p->ctrl);
+            pthread_join(p->ctrl->hilo_reloj, NULL);
+            return -1;
+        }
+        p->hilos_creados = 1;
+
+        printf("[PARQUES] Parque %d: %d:00-%d:00, aforo %d, nucleo %d\n", id,
+               p->ctrl->hora_ini, p->ctrl->hora_fin, p->ctrl->aforo_maximo, p->cpu);
+    }
+
+    if (pthread_create(&mp->hilo_enrutador, NULL, hilo_enrutador, mp) != 0) {
+        perror("pthread_create (enrutador)");
+        return -1;
+    }
+    mp->enrutador_creado = 1;
+
+    return 0;
+}
+
+/************************************************************************************************************
+ *  int parques_activo(multiparque_t *mp)                                                                   *
+ *                                                                                                          *
+ *  Retorno:   1 mientras algun parque siga con su dia abierto.                                             *
+ ************************************************************************************************************/
+int parques_activo(multiparque_t *mp)
+{
+    int id;
+
+    for (id = 0; id < MAX_PARQUES; id++) {
+        if (mp->parques[id].ctrl != NULL && CTRL_ACTIVO(mp->parques[id].ctrl)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/************************************************************************************************************
+ *  void parques_destruir(multiparque_t *mp)                                                                *
+ *                                                                                                          *
+ *  Proposito: Detener el enrutador, despertar y esperar a los hilos de cada parque, escribir los reportes  *
+ *             (con prefijo "parqueN_") y liberar todo.                                                     *
+ ************************************************************************************************************/
+void parques_destruir(multiparque_t *mp)
+{
+    int id;
+
+    atomic_store(&mp->activo, 0);
+
+    if (mp->enrutador_creado) {
+        pthread_join(mp->hilo_enrutador, NULL);
+        mp->enrutador_creado = 0;
+    }
+
+    for (id = 0; id < MAX_PARQUES; id++) {
+        parque_t *p = &mp->parques[id];
+        if (p->ctrl == NULL) continue;
+
+        if (p->hilos_creados) {
+            CTRL_DETENER(p->ctrl);
+            sem_post(&p->cola->disponibles);
+            pthread_join(p->hilo_admision, NULL);
+            pthread_join(p->ctrl->hilo_reloj, NULL);
+            p->hilos_creados = 0;
+        }
+
+        /* ---- Aunque el arranque haya fallado despues: memoria compartida, exportacion, etc. ---- */
+        if (p->estado_inicializado) {
+            servidor_destruir(p->ctrl);
+            p->estado_inicializado = 0;
+        }
+
+        if (p->cola != NULL) {
+            sem_destroy(&p->cola->disponibles);
+            free(p->cola);
+            p->cola = NULL;
+        }
+        free(p->ctrl);
+        p->ctrl = NULL;
+    }
+
+    if (mp->fifo_fd != -1) {
+        salida_cerrar(&mp->salida, "[PARQUES] Enrutador:");
+        close(mp->fifo_fd);
+        mp->fifo_fd = -1;
+        unlink(mp->pipe_entrada);
+    }
+}
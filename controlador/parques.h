@@ -0,0 +1,106 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 24/11/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera del Controlador multi-parque.                                   *
+ *               Un solo proceso atiende varios parques independientes. Cada parque es un            *
+ *               controlador_t con su propio estado, mutex, reloj y contadores, y con un hilo de     *
+ *               admision fijado a un nucleo. Un hilo enrutador lee el FIFO de entrada y pasa cada   *
+ *               mensaje a la cola de su parque (productor unico / consumidor unico, sin locks).     *
+ *                                                                                                   *
+ *               La configuracion se lee de un archivo de texto:                                     *
+ *                   pipe               /tmp/pipe_controlador                                        *
+ *                   segundos_por_hora  2                                                            *
+ *                   tasa_por_agente    0        (opcional, ver admision.h)                          *
+ *                   rafaga             0        (opcional)                                          *
+ *                   marca_agua         0        (opcional)                                          *
+ *                   muestreo_latencia  0        (opcional, ver latencia.h)                          *
+ *                   lista_espera       0        (opcional: 1 = activar, ver espera.h)               *
+ *                   memoria_compartida /rsv     (opcional: /rsv_parque<id>, ver disponibilidad.h)   *
+ *                   exportacion reservas.col    (opcional: parque<id>_reservas.col)                 *
+ *                   duracion_reserva   2        (opcional: horas que ocupa cada reserva)            *
+ *                   plazo_respuestas_us 200     (opcional: 0 = responder sin agrupar, ver salida.h) *
+ *                   parque <id> <horaIni> <horaFin> <aforo> [cpu]                                   *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __PARQUES_H__
+#define __PARQUES_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdatomic.h>
+#include <semaphore.h>
+
+#include "controlador.h"
+
+#define MAX_PARQUES                   16
+#define TAM_COLA_PARQUE               1024    /* Potencia de 2                               */
+
+/* ---- Mensaje encolado para un parque ---- */
+typedef struct {
+    uint64_t t_ns;
+    int      pendientes;
+    char     linea[MAX_LONG_MENSAJE];
+} entrada_cola_t;
+
+/* ---- Cola anillo de un productor (enrutador) y un consumidor (hilo del parque) ----
+ * Los indices van en lineas de cache distintas para que productor y consumidor no se invaliden
+ * mutuamente. El semaforo solo entra al kernel cuando el consumidor esta dormido.
+ */
+typedef struct {
+    _Alignas(TAM_LINEA_CACHE) atomic_size_t cabeza;    /* Siguiente posicion a escribir     */
+    _Alignas(TAM_LINEA_CACHE) atomic_size_t cola;      /* Siguiente posicion a leer         */
+    _Alignas(TAM_LINEA_CACHE) atomic_int    bytes;     /* Bytes encolados (marca de agua)   */
+    sem_t          disponibles;
+    entrada_cola_t entradas[TAM_COLA_PARQUE];
+} cola_parque_t;
+
+/* ---- Un parque (shard) ---- */
+typedef struct {
+    controlador_t *ctrl;
+    int            id;
+    int            cpu;             /* Nucleo del hilo de admision (-1 = sin fijar)        */
+    cola_parque_t *cola;
+    pthread_t      hilo_admision;
+    atomic_int    *activo;          /* Apunta a multiparque_t.activo                       */
+    char           estado_inicializado;     /* servidor_inicializar_estado() sin error     */
+    char           hilos_creados;
+} parque_t;
+
+/* ---- Controlador multi-parque ---- */
+typedef struct {
+    char   pipe_entrada[MAX_LONG_NOMBRE_PIPE];
+    int    fifo_fd;
+    int    segundos_por_hora;
+    double tasa_por_agente;
+    double rafaga_por_agente;
+    int    marca_agua_fifo;
+    int    muestreo_latencia;
+    int    lista_espera;
+    int    duracion_reserva;
+    int    plazo_respuestas_us;
+    char   nombre_memoria[MAX_LONG_NOMBRE_MEMORIA];
+    char   ruta_exportacion[MAX_LONG_NOMBRE_PIPE];
+
+    parque_t parques[MAX_PARQUES];  /* Indexado por id de parque; ctrl == NULL si no existe */
+    int      num_parques;
+
+    salida_respuestas_t salida;     /* Respuestas que da el propio enrutador                */
+
+    pthread_t   hilo_enrutador;
+    char        enrutador_creado;
+    atomic_int  activo;
+} multiparque_t;
+
+/***************************************** Prototipos *******************************************************/
+
+int  parques_cargar_configuracion(multiparque_t *mp, const char *ruta);
+int  parques_inicializar(multiparque_t *mp);
+int  parques_activo(multiparque_t *mp);
+void parques_destruir(multiparque_t *mp);
+
+#endif /* __PARQUES_H__ */
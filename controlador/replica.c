@@ -0,0 +1,315 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 29/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    replica.c                                                                                   *
+ *                                                                                                         *
+ * Descripcion: Replicacion primario / respaldo por socket UNIX (ver replica.h).                           *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "replica.h"
+
+/************************************************************************************************************
+ *  static int direccion_socket(struct sockaddr_un *dir, const char *ruta)                                  *
+ ************************************************************************************************************/
+static int direccion_socket(struct sockaddr_un *dir, const char *ruta)
+{
+    memset(dir, 0, sizeof(*dir));
+    dir->sun_family = AF_UNIX;
+
+    if (strlen(ruta) >= sizeof(dir->sun_path)) {
+        fprintf(stderr, "[REPLICA] Ruta de socket demasiado larga: %s\n", ruta);
+        return -1;
+    }
+    strcpy(dir->sun_path, ruta);
+    return 0;
+}
+
+/************************************************************************************************************
+ *  static int escribir_todo(int fd, const void *datos, size_t largo)                                       *
+ *                                                                                                          *
+ *  MSG_NOSIGNAL: si el respaldo murio, send() falla con EPIPE en lugar de terminar el primario.            *
+ ************************************************************************************************************/
+static int escribir_todo(int fd, const void *datos, size_t largo)
+{
+    const char *p = datos;
+
+    while (largo > 0) {
+        ssize_t n = send(fd, p, largo, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p     += n;
+        largo -= (size_t) n;
+    }
+    return 0;
+}
+
+/************************************************************************************************************
+ *  static void *hilo_envio(void *arg)                                                                      *
+ *                                                                                                          *
+ *  Proposito: Intercambiar los buffers y escribir todo lo acumulado en un solo send(). Mientras se envia   *
+ *             un lote los productores siguen llenando el otro, asi que bajo carga los lotes crecen solos.  *
+ ************************************************************************************************************/
+static void *hilo_envio(void *arg)
+{
+    replica_t *r = (replica_t *) arg;
+
+    for (;;) {
+        pthread_mutex_lock(&r->mutex);
+        while (r->num == 0 && !r->terminar) {
+            pthread_cond_wait(&r->hay_deltas, &r->mutex);
+        }
+        if (r->num == 0) {
+            pthread_mutex_unlock(&r->mutex);
+            break;
+        }
+
+        delta_replica_t *lote = r->llenando;
+        int              num  = r->num;
+        int              fd   = r->fd;
+
+        r->llenando = r->enviando;
+        r->enviando = lote;
+        r->num      = 0;
+        pthread_cond_broadcast(&r->hay_espacio);
+        pthread_mutex_unlock(&r->mutex);
+
+        if (fd != -1 && escribir_todo(fd, lote, sizeof(delta_replica_t) * num) != 0) {
+            fprintf(stderr, "[REPLICA] Respaldo desconectado: %s\n", strerror(errno));
+            pthread_mutex_lock(&r->mutex);
+            close(r->fd);
+            r->fd = -1;
+            pthread_mutex_unlock(&r->mutex);
+        }
+
+        r->enviados += num;
+        r->lotes++;
+    }
+
+    return NULL;
+}
+
+/************************************************************************************************************
+ *  replica_t *replica_conectar(const char *ruta, const controlador_t *ctrl)                                *
+ *                                                                                                          *
+ *  Proposito: Conectar con el respaldo (que ya debe estar escuchando), enviar la cabecera con la           *
+ *             configuracion del parque y lanzar el hilo de envio.                                          *
+ *                                                                                                          *
+ *  Retorno:   La replica, o NULL si no se pudo conectar.                                                   *
+ ************************************************************************************************************/
+replica_t *replica_conectar(const char *ruta, const controlador_t *ctrl)
+{
+    struct sockaddr_un dir;
+    cabecera_replica_t cab;
+    replica_t *r;
+    int fd;
+
+    if (direccion_socket(&dir, ruta) != 0) return NULL;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        perror("socket (replica)");
+        return NULL;
+    }
+    if (connect(fd, (struct sockaddr *) &dir, sizeof(dir)) == -1) {
+        fprintf(stderr, "[REPLICA] No se pudo conectar con el respaldo en %s: %s\n",
+                ruta, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    memcpy(cab.magico, REPLICA_MAGICO, 4);
+    cab.hora_ini         = ctrl->hora_ini;
+    cab.hora_fin         = ctrl->hora_fin;
+    cab.aforo_maximo     = ctrl->aforo_maximo;
+    cab.duracion_reserva = ctrl->duracion_reserva;
+
+    if (escribir_todo(fd, &cab, sizeof(cab)) != 0) {
+        perror("send (cabecera de replica)");
+        close(fd);
+        return NULL;
+    }
+
+    r = calloc(1, sizeof(*r));
+    if (r == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    r->fd       = fd;
+    r->llenando = malloc(sizeof(delta_replica_t) * REPLICA_MAX_LOTE);
+    r->enviando = malloc(sizeof(delta_replica_t) * REPLICA_MAX_LOTE);
+    pthread_mutex_init(&r->mutex, NULL);
+    pthread_cond_init(&r->hay_deltas, NULL);
+    pthread_cond_init(&r->hay_espacio, NULL);
+
+    if (r->llenando == NULL || r->enviando == NULL ||
+        pthread_create(&r->hilo, NULL, hilo_envio, r) != 0) {
+        fprintf(stderr, "[REPLICA] No se pudo iniciar el envio.\n");
+        close(fd);
+        free(r->llenando);
+        free(r->enviando);
+        free(r);
+        return NULL;
+    }
+
+    printf("[REPLICA] Conectado con el respaldo en %s\n", ruta);
+    return r;
+}
+
+/************************************************************************************************************
+ *  void replica_registrar(replica_t *r, const delta_replica_t *d)                                          *
+ *                                                                                                          *
+ *  Proposito: Copiar el delta al buffer en llenado. Se llama con el mutex del controlador tomado, asi que  *
+ *             los deltas quedan en el mismo orden en que se aplicaron. Solo se despierta al hilo de envio  *
+ *             cuando el buffer pasa de vacio a no vacio. Si el buffer esta lleno se espera al envio: un    *
+ *             respaldo atrasado frena al primario en lugar de quedar inconsistente.                        *
+ ************************************************************************************************************/
+void replica_registrar(replica_t *r, const delta_replica_t *d)
+{
+    pthread_mutex_lock(&r->mutex);
+
+    while (r->num == REPLICA_MAX_LOTE && r->fd != -1) {
+        pthread_cond_wait(&r->hay_espacio, &r->mutex);
+    }
+
+    if (r->fd != -1) {
+        r->llenando[r->num++] = *d;
+        if (r->num == 1) {
+            pthread_cond_signal(&r->hay_deltas);
+        }
+    }
+
+    pthread_mutex_unlock(&r->mutex);
+}
+
+/************************************************************************************************************
+ *  void replica_cerrar(replica_t *r)                                                                       *
+ *                                                                                                          *
+ *  Proposito: Enviar lo pendiente, cerrar la conexion (el respaldo ve EOF) y liberar la replica.           *
+ ************************************************************************************************************/
+void replica_cerrar(replica_t *r)
+{
+    if (r == NULL) return;
+
+    pthread_mutex_lock(&r->mutex);
+    r->terminar = 1;
+    pthread_cond_signal(&r->hay_deltas);
+    pthread_mutex_unlock(&r->mutex);
+
+    pthread_join(r->hilo, NULL);
+
+    if (r->fd != -1) {
+        close(r->fd);
+    }
+
+    printf("[REPLICA] %llu deltas enviados en %llu lotes (%.1f por lote)\n",
+           (unsigned long long) r->enviados, (unsigned long long) r->lotes,
+           (r->lotes > 0) ? (double) r->enviados / (double) r->lotes : 0.0);
+
+    pthread_cond_destroy(&r->hay_deltas);
+    pthread_cond_destroy(&r->hay_espacio);
+    pthread_mutex_destroy(&r->mutex);
+    free(r->llenando);
+    free(r->enviando);
+    free(r);
+}
+
+/************************************************************************************************************
+ *  int replica_seguir(const char *ruta, controlador_t *ctrl)                                               *
+ *                                                                                                          *
+ *  Proposito: Lado respaldo. Escuchar en el socket, aceptar al primario y aplicar sus deltas hasta que la  *
+ *             conexion se cierre. El estado ya debe estar inicializado (servidor_inicializar_estado).      *
+ *                                                                                                          *
+ *  Retorno:   0 si el primario se conecto y luego se desconecto; -1 ante error antes de conectar.          *
+ ************************************************************************************************************/
+int replica_seguir(const char *ruta, controlador_t *ctrl)
+{
+    struct sockaddr_un dir;
+    cabecera_replica_t cab;
+    char   buffer[sizeof(delta_replica_t) * 256];
+    size_t usados = 0;
+    long   aplicados = 0;
+    int    fd_escucha, fd;
+
+    if (direccion_socket(&dir, ruta) != 0) return -1;
+
+    fd_escucha = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_escucha == -1) {
+        perror("socket (respaldo)");
+        return -1;
+    }
+
+    unlink(ruta);
+    if (bind(fd_escucha, (struct sockaddr *) &dir, sizeof(dir)) == -1 || listen(fd_escucha, 1) == -1) {
+        perror("bind/listen (respaldo)");
+        close(fd_escucha);
+        return -1;
+    }
+
+    printf("[RESPALDO] Esperando al primario en %s\n", ruta);
+    do {
+        fd = accept(fd_escucha, NULL, NULL);
+    } while (fd == -1 && errno == EINTR);
+
+    close(fd_escucha);
+    unlink(ruta);
+
+    if (fd == -1) {
+        perror("accept (respaldo)");
+        return -1;
+    }
+
+    /* ---- Cabecera: la configuracion debe coincidir ---- */
+    if (recv(fd, &cab, sizeof(cab), MSG_WAITALL) != (ssize_t) sizeof(cab) ||
+        memcmp(cab.magico, REPLICA_MAGICO, 4) != 0 ||
+        cab.hora_ini != ctrl->hora_ini || cab.hora_fin != ctrl->hora_fin ||
+        cab.aforo_maximo != ctrl->aforo_maximo || cab.duracion_reserva != ctrl->duracion_reserva) {
+        fprintf(stderr, "[RESPALDO] Cabecera invalida o configuracion distinta a la del primario.\n");
+        close(fd);
+        return -1;
+    }
+    printf("[RESPALDO] Primario conectado; replicando.\n");
+
+    /* ---- Aplicar deltas completos; un resto parcial espera a la siguiente lectura ---- */
+    for (;;) {
+        ssize_t n = read(fd, buffer + usados, sizeof(buffer) - usados);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        usados += (size_t) n;
+
+        size_t completos = usados / sizeof(delta_replica_t);
+        size_t i;
+        for (i = 0; i < completos; i++) {
+            delta_replica_t d;
+            memcpy(&d, buffer + i * sizeof(delta_replica_t), sizeof(d));
+            servidor_aplicar_replica(ctrl, &d);
+        }
+        aplicados += (long) completos;
+
+        usados -= completos * sizeof(delta_replica_t);
+        memmove(buffer, buffer + completos * sizeof(delta_replica_t), usados);
+    }
+
+    close(fd);
+    printf("[RESPALDO] Conexion con el primario cerrada (%ld deltas aplicados, hora %d:00).\n",
+           aplicados, CTRL_HORA_ACTUAL(ctrl));
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 29/11/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera de la replicacion primario / respaldo.                          *
+ *               El primario conecta con el respaldo por un socket UNIX y le envia cada cambio de    *
+ *               estado (decision, reserva promovida, cancelacion, tick del reloj) como un delta de  *
+ *               tamaño fijo. Registrar un delta solo lo copia a un buffer; un hilo de envio lo      *
+ *               escribe por lotes, sin esperar confirmacion (replicacion asincrona).                *
+ *                                                                                                   *
+ *               El respaldo aplica los deltas sobre su propio estado y, si la conexion se cierra    *
+ *               antes del fin del dia, abre el FIFO de entrada y sigue atendiendo a los agentes.    *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __REPLICA_H__
+#define __REPLICA_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdint.h>
+#include <pthread.h>
+
+#include "controlador.h"
+
+#define REPLICA_MAGICO                "RSVR"
+#define REPLICA_MAX_LOTE              4096    /* Deltas por buffer (el productor espera si se llena) */
+
+/* ---- Tipos de delta ---- */
+enum {
+    DELTA_DECISION = 1,     /* Respuesta a una SOLICITUD (reserva si hora >= 0)           */
+    DELTA_RESERVA,          /* Reserva sin solicitud (promocion de la lista de espera)    */
+    DELTA_LIBERACION,       /* Cancelacion de la reserva de familia en hora               */
+    DELTA_HORA              /* Tick del reloj                                             */
+};
+
+/* ---- Delta de estado (misma maquina y arquitectura en ambos lados: se envia tal cual) ---- */
+typedef struct delta_replica {
+    uint8_t tipo;
+    int8_t  respuesta;              /* tipo_respuesta_t de una DELTA_DECISION             */
+    int8_t  hora_solicitada;
+    int8_t  hora;                   /* Asignada (-1 = ninguna), liberada o nueva          */
+    int32_t personas;
+    char    familia[MAX_LONG_NOMBRE_FAMILIA];
+} delta_replica_t;
+
+/* ---- Cabecera que envia el primario al conectar ---- */
+typedef struct {
+    char    magico[4];
+    int32_t hora_ini;
+    int32_t hora_fin;
+    int32_t aforo_maximo;
+    int32_t duracion_reserva;
+} cabecera_replica_t;
+
+/* ---- Lado primario ---- */
+typedef struct replica {
+    int             fd;             /* -1 si el respaldo se desconecto                    */
+    pthread_mutex_t mutex;
+    pthread_cond_t  hay_deltas;
+    pthread_cond_t  hay_espacio;
+    delta_replica_t *llenando;      /* Donde copian los productores                       */
+    delta_replica_t *enviando;      /* Lo que escribe el hilo de envio                    */
+    int             num;
+    int             terminar;
+    pthread_t       hilo;
+
+    uint64_t        enviados;
+    uint64_t        lotes;
+} replica_t;
+
+/***************************************** Prototipos *******************************************************/
+
+replica_t *replica_conectar(const char *ruta, const controlador_t *ctrl);
+void       replica_registrar(replica_t *r, const delta_replica_t *d);
+void       replica_cerrar(replica_t *r);
+
+int        replica_seguir(const char *ruta, controlador_t *ctrl);
+
+#endif /* __REPLICA_H__ */
@@ -0,0 +1,460 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 21/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    reporte.c                                                                                   *
+ *                                                                                                         *
+ * Descripcion: Reporte incremental del Controlador. Las funciones de actualizacion se llaman con el       *
+ *              mutex del controlador tomado; las de escritura trabajan sobre una copia del resumen para   *
+ *              no hacer E/S dentro de la seccion critica.                                                 *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "controlador.h"
+
+/************************************************************************************************************
+ *  static int en_horario(const reporte_t *rep, int hora)                                                   *
+ *                                                                                                          *
+ *  Proposito: Indicar si la hora pertenece al horario de atencion [hora_ini, hora_fin).                    *
+ ************************************************************************************************************/
+static int en_horario(const reporte_t *rep, int hora)
+{
+    return hora >= rep->hora_ini && hora < rep->hora_fin;
+}
+
+/************************************************************************************************************
+ *  static void recalcular_extremos(reporte_t *rep)                                                         *
+ *                                                                                                          *
+ *  Proposito: Recalcular pico y valle recorriendo el horario. Solo se usa cuando la ultima hora que tenia  *
+ *             el maximo (o el minimo) deja de tenerlo; son a lo sumo MAX_HORAS_DIA horas.                  *
+ ************************************************************************************************************/
+static void recalcular_extremos(reporte_t *rep)
+{
+    resumen_reporte_t *r = &rep->resumen;
+    int h;
+
+    r->horas_max = 0;
+    r->horas_min = 0;
+
+    for (h = rep->hora_ini; h < rep->hora_fin; h++) {
+        int oc = rep->ocupacion[h];
+
+        if (r->horas_max == 0 || oc > r->ocupacion_max) {
+            r->ocupacion_max = oc;
+            r->horas_max     = 1u << h;
+        } else if (oc == r->ocupacion_max) {
+            r->horas_max |= 1u << h;
+        }
+
+        if (r->horas_min == 0 || oc < r->ocupacion_min) {
+            r->ocupacion_min = oc;
+            r->horas_min     = 1u << h;
+        } else if (oc == r->ocupacion_min) {
+            r->horas_min |= 1u << h;
+        }
+    }
+}
+
+/************************************************************************************************************
+ *  static totales_reporte_t *buscar_familia(reporte_t *rep, const char *familia)                           *
+ *                                                                                                          *
+ *  Proposito: Tabla hash (FNV-1a, sondeo lineal) con los totales por familia. Si la tabla se llena, las    *
+ *             familias nuevas se acumulan en una entrada comun "(otras)".                                  *
+ ************************************************************************************************************/
+static totales_reporte_t *buscar_familia(reporte_t *rep, const char *familia)
+{
+    uint32_t hash = 2166136261u;
+    const unsigned char *c;
+
+    for (c = (const unsigned char *) familia; *c != '\0'; c++) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+
+    uint32_t i = hash & (MAX_FAMILIAS_REPORTE - 1);
+    int sondeos;
+
+    for (sondeos = 0; sondeos < MAX_FAMILIAS_REPORTE; sondeos++) {
+        totales_reporte_t *t = &rep->familias[i];
+
+        if (t->nombre[0] == '\0') {
+            /* Se deja un hueco libre para que las busquedas siempre terminen */
+            if (rep->num_familias >= MAX_FAMILIAS_REPORTE - 1) break;
+
+            strncpy(t->nombre, familia, MAX_LONG_NOMBRE_FAMILIA - 1);
+            rep->num_familias++;
+            return t;
+        }
+        if (strcmp(t->nombre, familia) == 0) {
+            return t;
+        }
+        i = (i + 1) & (MAX_FAMILIAS_REPORTE - 1);
+    }
+
+    return &rep->familias_sin_espacio;
+}
+
+/************************************************************************************************************
+ *  static void sumar_totales(totales_reporte_t *t, tipo_respuesta_t tipo, int personas)                    *
+ ************************************************************************************************************/
+static void sumar_totales(totales_reporte_t *t, tipo_respuesta_t tipo, int personas)
+{
+    t->solicitudes++;
+
+    switch (tipo) {
+    case RESPUESTA_RESERVA_OK:
+        t->aceptadas++;
+        t->personas_admitidas += personas;
+        break;
+    case RESPUESTA_RESERVA_REPROGRAMADA:
+        t->reprogramadas++;
+        t->personas_admitidas += personas;
+        break;
+    default:
+        t->negadas++;
+        break;
+    }
+}
+
+/************************************************************************************************************
+ *  static void escribir_horas(FILE *fp, uint32_t horas, const char *sep)                                   *
+ *                                                                                                          *
+ *  Proposito: Escribir las horas encendidas en la mascara separadas por sep.                               *
+ ************************************************************************************************************/
+static void escribir_horas(FILE *fp, uint32_t horas, const char *sep)
+{
+    int h, primero = 1;
+
+    for (h = 0; h <= MAX_HORAS_DIA; h++) {
+        if (horas & (1u << h)) {
+            fprintf(fp, "%s%d", primero ? "" : sep, h);
+            primero = 0;
+        }
+    }
+}
+
+/************************************************************************************************************
+ *  static void escribir_arreglo_json(FILE *fp, const int *v, int n)                                        *
+ ************************************************************************************************************/
+static void escribir_arreglo_json(FILE *fp, const int *v, int n)
+{
+    int i;
+
+    fputc('[', fp);
+    for (i = 0; i < n; i++) {
+        fprintf(fp, "%s%d", i ? "," : "", v[i]);
+    }
+    fputc(']', fp);
+}
+
+/************************************************************************************************************
+ *  int reporte_inicializar(reporte_t *rep, int hora_ini, int hora_fin, const char *prefijo)                *
+ *                                                                                                          *
+ *  Proposito: Dejar el reporte en cero y abrir los archivos de instantaneas horarias (CSV y JSON lines).   *
+ *             El prefijo distingue los archivos de cada parque en modo multi-parque ("" si hay uno).       *
+ *             Con prefijo NULL no se abre ningun archivo (simulador de capacidad: solo importan totales).  *
+ *                                                                                                          *
+ *  Retorno:   0 si todo fue bien; -1 si no se pudieron abrir los archivos.                                 *
+ ************************************************************************************************************/
+int reporte_inicializar(reporte_t *rep, int hora_ini, int hora_fin, const char *prefijo)
+{
+    char ruta_csv[256], ruta_json[256];
+
+    memset(rep, 0, sizeof(*rep));
+
+    rep->hora_ini = hora_ini;
+    rep->hora_fin = hora_fin;
+    strcpy(rep->familias_sin_espacio.nombre, "(otras)");
+
+    /* ---- Todas las horas empiezan vacias: son pico y valle a la vez ---- */
+    recalcular_extremos(rep);
+
+    if (prefijo == NULL) {
+        return 0;
+    }
+
+    snprintf(ruta_csv,  sizeof(ruta_csv),  "%s%s", prefijo, ARCHIVO_REPORTE_CSV);
+    snprintf(ruta_json, sizeof(ruta_json), "%s%s", prefijo, ARCHIVO_REPORTE_JSON);
+
+    rep->csv  = fopen(ruta_csv,  "w");
+    rep->json = fopen(ruta_json, "w");
+
+    if (rep->csv == NULL || rep->json == NULL) {
+        perror("Error creando archivos de reporte horario");
+        reporte_cerrar(rep);
+        return -1;
+    }
+
+    fprintf(rep->csv, "hora,ocupacion,solicitudes,aceptadas,reprogramadas,negadas,"
+                      "ocupacion_pico,horas_pico,ocupacion_valle,horas_valle\n");
+    fflush(rep->csv);
+
+    return 0;
+}
+
+/************************************************************************************************************
+ *  void reporte_cerrar(reporte_t *rep)                                                                     *
+ ************************************************************************************************************/
+void reporte_cerrar(reporte_t *rep)
+{
+    if (rep->csv != NULL) {
+        fclose(rep->csv);
+        rep->csv = NULL;
+    }
+    if (rep->json != NULL) {
+        fclose(rep->json);
+        rep->json = NULL;
+    }
+}
+
+/************************************************************************************************************
+ *  void reporte_ocupacion(reporte_t *rep, int hora, int ocupacion_nueva)                                   *
+ *                                                                                                          *
+ *  Proposito: Registrar el nuevo valor de ocupacion de una hora y mantener pico y valle con mascaras de    *
+ *             bits. Solo se recorre el horario cuando se vacia la mascara del extremo afectado.            *
+ ************************************************************************************************************/
+void reporte_ocupacion(reporte_t *rep, int hora, int ocupacion_nueva)
+{
+    resumen_reporte_t *r = &rep->resumen;
+    uint32_t bit = 1u << hora;
+    int recalcular = 0;
+
+    rep->ocupacion[hora] = ocupacion_nueva;
+
+    if (!en_horario(rep, hora)) return;
+
+    /* ---- Hora pico ---- */
+    if (ocupacion_nueva > r->ocupacion_max) {
+        r->ocupacion_max = ocupacion_nueva;
+        r->horas_max     = bit;
+    } else if (ocupacion_nueva == r->ocupacion_max) {
+        r->horas_max |= bit;
+    } else if (r->horas_max & bit) {
+        r->horas_max &= ~bit;
+        recalcular = (r->horas_max == 0);
+    }
+
+    /* ---- Hora valle ---- */
+    if (ocupacion_nueva < r->ocupacion_min) {
+        r->ocupacion_min = ocupacion_nueva;
+        r->horas_min     = bit;
+    } else if (ocupacion_nueva == r->ocupacion_min) {
+        r->horas_min |= bit;
+    } else if (r->horas_min & bit) {
+        r->horas_min &= ~bit;
+        recalcular = recalcular || (r->horas_min == 0);
+    }
+
+    if (recalcular) {
+        recalcular_extremos(rep);
+    }
+}
+
+/************************************************************************************************************
+ *  void reporte_decision(reporte_t *rep, tipo_respuesta_t tipo, int idx_agente, const char *agente,        *
+ *                        const char *familia, int personas, int hora_solicitada, int hora_asignada)        *
+ *                                                                                                          *
+ *  Proposito: Acumular una decision del motor de reservas: contadores, histograma de tamaño de grupo,      *
+ *             histograma de distancia de reprogramacion y totales por agente y por familia.                *
+ ************************************************************************************************************/
+void reporte_decision(reporte_t *rep, tipo_respuesta_t tipo, int idx_agente, const char *agente,
+                      const char *familia, int personas, int hora_solicitada, int hora_asignada)
+{
+    resumen_reporte_t *r = &rep->resumen;
+
+    r->solicitudes++;
+
+    switch (tipo) {
+    case RESPUESTA_RESERVA_OK:
+        r->aceptadas++;
+        break;
+    case RESPUESTA_RESERVA_REPROGRAMADA: {
+        int distancia = hora_asignada - hora_solicitada;
+        if (distancia < 0)            distancia = 0;
+        if (distancia > MAX_HORAS_DIA) distancia = MAX_HORAS_DIA;
+        r->hist_distancia[distancia]++;
+        r->reprogramadas++;
+        break;
+    }
+    default:
+        r->negadas++;
+        break;
+    }
+
+    /* ---- Histograma de tamaño de grupo ---- */
+    if (personas < 0)                personas = 0;
+    r->hist_personas[(personas < MAX_BIN_PERSONAS) ? personas : MAX_BIN_PERSONAS]++;
+
+    /* ---- Totales por agente (mismo indice que la tabla de admision) ---- */
+    if (idx_agente >= 0 && idx_agente < MAX_AGENTES_REGISTRADOS) {
+        totales_reporte_t *t = &rep->agentes[idx_agente];
+        if (agente != NULL) {
+            strncpy(t->nombre, agente, MAX_LONG_NOMBRE_FAMILIA - 1);
+        }
+        sumar_totales(t, tipo, personas);
+    }
+
+    /* ---- Totales por familia ---- */
+    sumar_totales(buscar_familia(rep, familia), tipo, personas);
+}
+
+/************************************************************************************************************
+ *  void reporte_espera(reporte_t *rep, int en_espera, int promovidas, int vencidas, int canceladas)       *
+ *                                                                                                          *
+ *  Proposito: Sumar los eventos de la lista de espera. La solicitud original ya se conto como negada en    *
+ *             reporte_decision; una promocion posterior no la cambia, se cuenta aparte.                    *
+ ************************************************************************************************************/
+void reporte_espera(reporte_t *rep, int en_espera, int promovidas, int vencidas, int canceladas)
+{
+    rep->resumen.en_espera  += en_espera;
+    rep->resumen.promovidas += promovidas;
+    rep->resumen.vencidas   += vencidas;
+    rep->resumen.canceladas += canceladas;
+}
+
+/************************************************************************************************************
+ *  void reporte_tomar_resumen(const reporte_t *rep, int hora_actual, resumen_reporte_t *res)               *
+ *                                                                                                          *
+ *  Proposito: Copiar el resumen actual (se llama con el mutex tomado, la copia es de tamaño fijo).         *
+ ************************************************************************************************************/
+void reporte_tomar_resumen(const reporte_t *rep, int hora_actual, resumen_reporte_t *res)
+{
+    *res = rep->resumen;
+    res->hora_actual           = hora_actual;
+    res->ocupacion_hora_actual = rep->ocupacion[hora_actual];
+}
+
+/************************************************************************************************************
+ *  void reporte_escribir_instantanea(reporte_t *rep, const resumen_reporte_t *res)                         *
+ *                                                                                                          *
+ *  Proposito: Agregar una linea al CSV y al JSON horario. Se vacia el buffer en cada hora para que las     *
+ *             instantaneas sobrevivan a una caida del proceso.                                             *
+ ************************************************************************************************************/
+void reporte_escribir_instantanea(reporte_t *rep, const resumen_reporte_t *res)
+{
+    if (rep->csv != NULL) {
+        fprintf(rep->csv, "%d,%d,%d,%d,%d,%d,%d,",
+                res->hora_actual, res->ocupacion_hora_actual, res->solicitudes,
+                res->aceptadas, res->reprogramadas, res->negadas, res->ocupacion_max);
+        escribir_horas(rep->csv, res->horas_max, "|");
+        fprintf(rep->csv, ",%d,", res->ocupacion_min);
+        escribir_horas(rep->csv, res->horas_min, "|");
+        fputc('\n', rep->csv);
+        fflush(rep->csv);
+    }
+
+    if (rep->json != NULL) {
+        fprintf(rep->json,
+                "{\"hora\":%d,\"ocupacion\":%d,\"solicitudes\":%d,\"aceptadas\":%d,"
+                "\"reprogramadas\":%d,\"negadas\":%d,",
+                res->hora_actual, res->ocupacion_hora_actual, res->solicitudes,
+                res->aceptadas, res->reprogramadas, res->negadas);
+        fprintf(rep->json, "\"pico\":{\"ocupacion\":%d,\"horas\":[", res->ocupacion_max);
+        escribir_horas(rep->json, res->horas_max, ",");
+        fprintf(rep->json, "]},\"valle\":{\"ocupacion\":%d,\"horas\":[", res->ocupacion_min);
+        escribir_horas(rep->json, res->horas_min, ",");
+        fprintf(rep->json, "]},\"hist_personas\":");
+        escribir_arreglo_json(rep->json, res->hist_personas, MAX_BIN_PERSONAS + 1);
+        fprintf(rep->json, ",\"hist_distancia\":");
+        escribir_arreglo_json(rep->json, res->hist_distancia, MAX_HORAS_DIA + 1);
+        fprintf(rep->json, "}\n");
+        fflush(rep->json);
+    }
+}
+
+/************************************************************************************************************
+ *  int reporte_escribir_final(const reporte_t *rep, const char *ruta, int solicitudes_ocupado)             *
+ *                                                                                                          *
+ *  Proposito: Volcar el estado ya calculado al reporte final. No recorre las horas para buscar pico ni     *
+ *             valle: solo imprime lo acumulado.                                                            *
+ *                                                                                                          *
+ *  Retorno:   0 si se escribio el archivo; -1 si no se pudo crear.                                         *
+ ************************************************************************************************************/
+int reporte_escribir_final(const reporte_t *rep, const char *ruta, int solicitudes_ocupado)
+{
+    const resumen_reporte_t *r = &rep->resumen;
+    FILE *fp = fopen(ruta, "w");
+    int h, i;
+
+    if (fp == NULL) {
+        perror("Error creando reporte final");
+        return -1;
+    }
+
+    fprintf(fp, "================ REPORTE FINAL DEL SISTEMA DE RESERVAS ================\n\n");
+
+    /* ---- Horas pico (A) y valle (B) ---- */
+    fprintf(fp, "a. Horas pico (Mayor ocupacion: %d personas):\n", r->ocupacion_max);
+    for (h = 0; h <= MAX_HORAS_DIA; h++) {
+        if (r->horas_max & (1u << h)) fprintf(fp, "   - %02d:00\n", h);
+    }
+    fprintf(fp, "\n");
+
+    fprintf(fp, "b. Horas valle (Menor ocupacion: %d personas):\n", r->ocupacion_min);
+    for (h = 0; h <= MAX_HORAS_DIA; h++) {
+        if (r->horas_min & (1u << h)) fprintf(fp, "   - %02d:00\n", h);
+    }
+    fprintf(fp, "\n");
+
+    /* ---- Estadisticas de solicitudes (C, D, E, F) ---- */
+    fprintf(fp, "c. Cantidad de solicitudes negadas        : %d\n", r->negadas);
+    fprintf(fp, "d. Cantidad de solicitudes aceptadas      : %d\n", r->aceptadas);
+    fprintf(fp, "e. Cantidad de solicitudes reprogramadas  : %d\n", r->reprogramadas);
+    fprintf(fp, "f. Solicitudes rechazadas por sobrecarga  : %d\n", solicitudes_ocupado);
+
+    /* ---- Histogramas ---- */
+    fprintf(fp, "\ng. Tamaño de grupo (personas : solicitudes):\n");
+    for (i = 0; i <= MAX_BIN_PERSONAS; i++) {
+        if (r->hist_personas[i] == 0) continue;
+        fprintf(fp, "   %s%2d : %d\n", (i == MAX_BIN_PERSONAS) ? ">=" : "  ", i, r->hist_personas[i]);
+    }
+
+    fprintf(fp, "\nh. Distancia de reprogramacion (horas : reservas):\n");
+    for (i = 0; i <= MAX_HORAS_DIA; i++) {
+        if (r->hist_distancia[i] == 0) continue;
+        fprintf(fp, "   %2d : %d\n", i, r->hist_distancia[i]);
+    }
+
+    /* ---- Totales por agente y por familia ---- */
+    fprintf(fp, "\ni. Totales por agente (solicitudes/aceptadas/reprogramadas/negadas/personas):\n");
+    for (i = 0; i < MAX_AGENTES_REGISTRADOS; i++) {
+        const totales_reporte_t *t = &rep->agentes[i];
+        if (t->solicitudes == 0) continue;
+        fprintf(fp, "   %-20s %d/%d/%d/%d/%d\n", t->nombre, t->solicitudes, t->aceptadas,
+                t->reprogramadas, t->negadas, t->personas_admitidas);
+    }
+
+    fprintf(fp, "\nj. Totales por familia (solicitudes/aceptadas/reprogramadas/negadas/personas):\n");
+    for (i = 0; i < MAX_FAMILIAS_REPORTE; i++) {
+        const totales_reporte_t *t = &rep->familias[i];
+        if (t->nombre[0] == '\0') continue;
+        fprintf(fp, "   %-20s %d/%d/%d/%d/%d\n", t->nombre, t->solicitudes, t->aceptadas,
+                t->reprogramadas, t->negadas, t->personas_admitidas);
+    }
+    if (rep->familias_sin_espacio.solicitudes > 0) {
+        const totales_reporte_t *t = &rep->familias_sin_espacio;
+        fprintf(fp, "   %-20s %d/%d/%d/%d/%d\n", t->nombre, t->solicitudes, t->aceptadas,
+                t->reprogramadas, t->negadas, t->personas_admitidas);
+    }
+
+    /* ---- Lista de espera (solo si se uso) ---- */
+    if (r->en_espera > 0 || r->canceladas > 0) {
+        fprintf(fp, "\nk. Lista de espera y cancelaciones:\n");
+        fprintf(fp, "   Solicitudes en lista de espera         : %d\n", r->en_espera);
+        fprintf(fp, "   Promovidas al liberarse cupo           : %d\n", r->promovidas);
+        fprintf(fp, "   Vencidas sin cupo                      : %d\n", r->vencidas);
+        fprintf(fp, "   Reservas canceladas                    : %d\n", r->canceladas);
+    }
+
+    fprintf(fp, "\n=======================================================================\n");
+    fclose(fp);
+
+    return 0;
+}
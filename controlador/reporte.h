@@ -0,0 +1,99 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 21/11/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera para el reporte incremental del Controlador.                    *
+ *               El estado del reporte (horas pico/valle, histogramas y totales por agente y por     *
+ *               familia) se actualiza en cada decision con costo O(1), y en cada tick del reloj se  *
+ *               escribe una instantanea en CSV y en JSON (una linea por hora).                      *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __REPORTE_H__
+#define __REPORTE_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdint.h>
+
+/* Este archivo se incluye desde controlador.h, que define tipo_respuesta_t y las longitudes maximas. */
+
+#define MAX_FAMILIAS_REPORTE          1024    /* Potencia de 2: tabla hash de familias       */
+#define MAX_BIN_PERSONAS              32      /* Ultimo bin acumula grupos >= MAX_BIN        */
+
+#define ARCHIVO_REPORTE_FINAL         "reporte_final.txt"
+#define ARCHIVO_REPORTE_CSV           "reporte_horario.csv"
+#define ARCHIVO_REPORTE_JSON          "reporte_horario.jsonl"
+
+/* ---- Totales acumulados por agente o por familia ---- */
+typedef struct {
+    char nombre[MAX_LONG_NOMBRE_FAMILIA];
+    int  solicitudes;
+    int  aceptadas;
+    int  reprogramadas;
+    int  negadas;
+    int  personas_admitidas;
+} totales_reporte_t;
+
+/* ---- Resumen que se copia bajo el mutex y se escribe fuera de el ---- */
+typedef struct {
+    int hora_actual;
+    int ocupacion_hora_actual;
+
+    int solicitudes;
+    int aceptadas;
+    int reprogramadas;
+    int negadas;
+
+    int      ocupacion_max, ocupacion_min;
+    uint32_t horas_max,     horas_min;      /* Bit h encendido: la hora h alcanza el max/min */
+
+    int hist_personas[MAX_BIN_PERSONAS + 1];
+    int hist_distancia[MAX_HORAS_DIA + 1];  /* Horas entre la hora pedida y la asignada      */
+
+    /* ---- Lista de espera y cancelaciones (ver espera.h) ---- */
+    int en_espera;
+    int promovidas;
+    int vencidas;
+    int canceladas;
+} resumen_reporte_t;
+
+/* ---- Estado incremental del reporte ---- */
+typedef struct {
+    int hora_ini;
+    int hora_fin;
+    int ocupacion[MAX_HORAS_DIA + 1];
+
+    resumen_reporte_t resumen;
+
+    totales_reporte_t agentes[MAX_AGENTES_REGISTRADOS];
+    int               num_familias;
+    totales_reporte_t familias[MAX_FAMILIAS_REPORTE];
+    totales_reporte_t familias_sin_espacio;
+
+    FILE *csv;
+    FILE *json;
+} reporte_t;
+
+/***************************************** Prototipos *******************************************************/
+
+int  reporte_inicializar(reporte_t *rep, int hora_ini, int hora_fin, const char *prefijo);
+void reporte_cerrar(reporte_t *rep);
+
+void reporte_ocupacion(reporte_t *rep, int hora, int ocupacion_nueva);
+
+void reporte_decision(reporte_t *rep, tipo_respuesta_t tipo, int idx_agente, const char *agente,
+                      const char *familia, int personas, int hora_solicitada, int hora_asignada);
+
+void reporte_espera(reporte_t *rep, int en_espera, int promovidas, int vencidas, int canceladas);
+
+void reporte_tomar_resumen(const reporte_t *rep, int hora_actual, resumen_reporte_t *res);
+void reporte_escribir_instantanea(reporte_t *rep, const resumen_reporte_t *res);
+
+int  reporte_escribir_final(const reporte_t *rep, const char *ruta, int solicitudes_ocupado);
+
+#endif /* __REPORTE_H__ */
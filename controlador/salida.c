@@ -0,0 +1,389 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 03/12/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    salida.c                                                                                    *
+ *                                                                                                         *
+ * Descripcion: Respuestas a los agentes encoladas por destino y enviadas por tandas con writev()          *
+ *              (ver salida.h).                                                                            *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "salida.h"
+
+static uint64_t ahora_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/************************************************************************************************************
+ *  int salida_inicializar(salida_respuestas_t *s, int plazo_us, latencia_t *latencia)                      *
+ ************************************************************************************************************/
+int salida_inicializar(salida_respuestas_t *s, int plazo_us, latencia_t *latencia)
+{
+    memset(s, 0, sizeof(*s));
+    s->plazo_us = (plazo_us > 0) ? plazo_us : 0;
+    s->latencia = latencia;
+
+    if (pthread_mutex_init(&s->mutex, NULL) != 0) {
+        perror("mutex_init (salida de respuestas)");
+        return -1;
+    }
+    return 0;
+}
+
+/************************************************************************************************************
+ *  static int abrir_destino(salida_respuestas_t *s, destino_respuesta_t *d)                                *
+ *                                                                                                          *
+ *  Proposito: Abrir el FIFO del agente sin bloquear (falla con ENXIO si nadie lo tiene abierto).           *
+ ************************************************************************************************************/
+static int abrir_destino(salida_respuestas_t *s, destino_respuesta_t *d)
+{
+    d->fd = open(d->pipe, O_WRONLY | O_NONBLOCK);
+    if (d->fd == -1) {
+        fprintf(stderr, "[AGENTES] No se pudo responder a %s: %s\n", d->pipe, strerror(errno));
+        return -1;
+    }
+    s->aperturas++;
+    return 0;
+}
+
+/************************************************************************************************************
+ *  static void cerrar_muestras(salida_respuestas_t *s, const destino_respuesta_t *d, int escrita)          *
+ *                                                                                                          *
+ *  Proposito: Las muestras de las respuestas del destino que acaban de salir toman MARCA_RESPONDIDO y se   *
+ *             registran; si la tanda se descarto, se sueltan sin registrar.                                *
+ ************************************************************************************************************/
+static void cerrar_muestras(salida_respuestas_t *s, const destino_respuesta_t *d, int escrita)
+{
+    int indice = (int) (d - s->destinos);
+    int i = 0;
+
+    while (i < s->num_muestras) {
+        muestra_salida_t *m = &s->muestras[i];
+
+        if (m->destino != indice) {
+            i++;
+            continue;
+        }
+        if (escrita) {
+            latencia_marcar(&m->m, MARCA_RESPONDIDO);
+            latencia_registrar(s->latencia, &m->m, m->tipo);
+        }
+        *m = s->muestras[--s->num_muestras];
+    }
+}
+
+/************************************************************************************************************
+ *  static void enviar_destino(salida_respuestas_t *s, destino_respuesta_t *d)                              *
+ *                                                                                                          *
+ *  Proposito: Escribir con un solo writev() todas las respuestas en cola del destino. La tanda no pasa de  *
+ *             PIPE_BUF bytes, asi que en un FIFO no bloqueante se escribe completa o no se escribe. Con    *
+ *             EPIPE el FIFO abierto ya no tiene lector (el agente termino): se reabre una vez por nombre.  *
+ *             Se llama con s->mutex tomado.                                                                *
+ ************************************************************************************************************/
+static void enviar_destino(salida_respuestas_t *s, destino_respuesta_t *d)
+{
+    int intento;
+
+    if (d->num == 0) return;
+
+    for (intento = 0; intento < 2; intento++) {
+        if (d->fd == -1 && abrir_destino(s, d) != 0) break;
+
+        ssize_t n;
+        do {
+            n = writev(d->fd, d->iov, d->num);
+        } while (n == -1 && errno == EINTR);
+        s->escrituras++;
+
+        if (n >= 0) {
+            if (s->num_muestras > 0) cerrar_muestras(s, d, 1);
+            d->num   = 0;
+            d->bytes = 0;
+            return;
+        }
+
+        int error = errno;
+        if (error != EPIPE) {
+            fprintf(stderr, "[AGENTES] writev(%s): %s\n", d->pipe, strerror(error));
+            break;
+        }
+        close(d->fd);
+        d->fd = -1;
+    }
+
+    s->descartadas += (uint64_t) d->num;
+    if (s->num_muestras > 0) cerrar_muestras(s, d, 0);
+    d->num   = 0;
+    d->bytes = 0;
+}
+
+/* ---- Recalcular la respuesta mas antigua y liberar el texto si ya no queda nada en cola ---- */
+static void actualizar_cola(salida_respuestas_t *s)
+{
+    int i;
+
+    s->primera_ns = 0;
+    for (i = 0; i < s->num_destinos; i++) {
+        const destino_respuesta_t *d = &s->destinos[i];
+
+        if (d->num > 0 && (s->primera_ns == 0 || d->primera_ns < s->primera_ns)) {
+            s->primera_ns = d->primera_ns;
+        }
+    }
+    if (s->primera_ns == 0) {
+        s->usados = 0;
+    }
+}
+
+static void vaciar_todo(salida_respuestas_t *s)
+{
+    int i;
+
+    for (i = 0; i < s->num_destinos; i++) {
+        enviar_destino(s, &s->destinos[i]);
+    }
+    s->primera_ns = 0;
+    s->usados     = 0;
+}
+
+/************************************************************************************************************
+ *  static destino_respuesta_t *buscar_destino(salida_respuestas_t *s, const char *pipe)                    *
+ *                                                                                                          *
+ *  Retorno:   Destino del FIFO (se crea si no existia), o NULL si la tabla esta llena y no hay ninguno     *
+ *             ocioso que se pueda reemplazar.                                                              *
+ ************************************************************************************************************/
+static destino_respuesta_t *buscar_destino(salida_respuestas_t *s, const char *pipe)
+{
+    destino_respuesta_t *d;
+    int i;
+
+    if (s->num_destinos > 0 && strcmp(s->destinos[s->ultimo].pipe, pipe) == 0) {
+        return &s->destinos[s->ultimo];
+    }
+
+    for (i = 0; i < s->num_destinos; i++) {
+        if (strcmp(s->destinos[i].pipe, pipe) == 0) {
+            s->ultimo = i;
+            return &s->destinos[i];
+        }
+    }
+
+    /* ---- Tabla llena: se reutiliza un destino sin respuestas en cola ---- */
+    if (s->num_destinos < MAX_DESTINOS_RESPUESTA) {
+        i = s->num_destinos++;
+    } else {
+        for (i = 0; i < MAX_DESTINOS_RESPUESTA && s->destinos[i].num > 0; i++) {
+            /* buscar */
+        }
+        if (i == MAX_DESTINOS_RESPUESTA) return NULL;
+        if (s->destinos[i].fd != -1) close(s->destinos[i].fd);
+    }
+
+    d = &s->destinos[i];
+    memset(d, 0, sizeof(*d));
+    snprintf(d->pipe, sizeof(d->pipe), "%s", pipe);
+    d->fd     = -1;
+    s->ultimo = i;
+    return d;
+}
+
+/************************************************************************************************************
+ *  void salida_encolar(salida_respuestas_t *s, const char *pipe, const char *texto, ...)                   *
+ *                                                                                                          *
+ *  Proposito: Agregar la respuesta (con '\n' al final si no lo trae) a la cola del agente. Si no cabe en   *
+ *             la tanda actual del agente, esa tanda se envia antes. Con muestra != NULL se guarda una      *
+ *             copia hasta que la respuesta se escriba (tipo: nombre del evento de Chrome).                 *
+ ************************************************************************************************************/
+void salida_encolar(salida_respuestas_t *s, const char *pipe, const char *texto,
+                    const muestra_latencia_t *muestra, const char *tipo)
+{
+    size_t largo = strlen(texto);
+    int    con_salto = (largo > 0 && texto[largo - 1] == '\n');
+    size_t total = largo + (con_salto ? 0 : 1);
+
+    if (total > PIPE_BUF || total > TAM_TEXTO_SALIDA) {
+        return;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+
+    destino_respuesta_t *d = buscar_destino(s, pipe);
+    if (d == NULL) {
+        vaciar_todo(s);
+        d = buscar_destino(s, pipe);
+    }
+
+    if (d->num == MAX_RESPUESTAS_DESTINO || d->bytes + total > PIPE_BUF) {
+        enviar_destino(s, d);
+        actualizar_cola(s);
+    }
+    if (s->usados + total > TAM_TEXTO_SALIDA ||
+        (muestra != NULL && s->num_muestras == MAX_MUESTRAS_SALIDA)) {
+        vaciar_todo(s);
+    }
+
+    uint64_t ahora = ahora_ns();
+    char    *destino = s->texto + s->usados;
+
+    memcpy(destino, texto, largo);
+    if (!con_salto) destino[largo] = '\n';
+
+    if (d->num == 0) {
+        d->primera_ns = ahora;
+        if (s->primera_ns == 0) s->primera_ns = ahora;
+    }
+    d->iov[d->num].iov_base = destino;
+    d->iov[d->num].iov_len  = total;
+    d->num++;
+    d->bytes  += total;
+    s->usados += total;
+    s->respuestas++;
+
+    if (muestra != NULL && s->latencia != NULL) {
+        muestra_salida_t *m = &s->muestras[s->num_muestras++];
+
+        m->m       = *muestra;
+        m->destino = (int) (d - s->destinos);
+        snprintf(m->tipo, sizeof(m->tipo), "%s", (tipo != NULL) ? tipo : "?");
+    }
+
+    if (s->plazo_us == 0) {
+        enviar_destino(s, d);
+        actualizar_cola(s);
+    }
+
+    pthread_mutex_unlock(&s->mutex);
+}
+
+/************************************************************************************************************
+ *  void salida_registrar(salida_respuestas_t *s, muestra_latencia_t *muestra, const char *tipo)            *
+ *                                                                                                          *
+ *  Proposito: Cerrar la muestra de un mensaje que no tuvo respuesta. Toma el mutex porque el reloj puede   *
+ *             estar registrando las de sus envios al mismo tiempo.                                         *
+ ************************************************************************************************************/
+void salida_registrar(salida_respuestas_t *s, muestra_latencia_t *muestra, const char *tipo)
+{
+    if (muestra == NULL || s->latencia == NULL) return;
+
+    pthread_mutex_lock(&s->mutex);
+    latencia_marcar(muestra, MARCA_RESPONDIDO);
+    latencia_registrar(s->latencia, muestra, tipo);
+    pthread_mutex_unlock(&s->mutex);
+}
+
+/************************************************************************************************************
+ *  void salida_vencer(salida_respuestas_t *s)                                                              *
+ *                                                                                                          *
+ *  Proposito: Enviar los destinos cuya respuesta mas antigua ya cumplio el plazo. Se llama despues de cada *
+ *             mensaje; si nada vence solo compara un instante.                                             *
+ ************************************************************************************************************/
+void salida_vencer(salida_respuestas_t *s)
+{
+    uint64_t plazo_ns = (uint64_t) s->plazo_us * 1000ULL;
+    int i;
+
+    pthread_mutex_lock(&s->mutex);
+
+    uint64_t ahora = ahora_ns();
+    if (s->primera_ns != 0 && ahora - s->primera_ns >= plazo_ns) {
+        for (i = 0; i < s->num_destinos; i++) {
+            destino_respuesta_t *d = &s->destinos[i];
+
+            if (d->num > 0 && ahora - d->primera_ns >= plazo_ns) {
+                enviar_destino(s, d);
+            }
+        }
+        actualizar_cola(s);
+    }
+
+    pthread_mutex_unlock(&s->mutex);
+}
+
+/************************************************************************************************************
+ *  void salida_vaciar(salida_respuestas_t *s)                                                              *
+ ************************************************************************************************************/
+void salida_vaciar(salida_respuestas_t *s)
+{
+    pthread_mutex_lock(&s->mutex);
+    if (s->primera_ns != 0) {
+        vaciar_todo(s);
+    }
+    pthread_mutex_unlock(&s->mutex);
+}
+
+/************************************************************************************************************
+ *  int salida_esperar_entrada(salida_respuestas_t *s, int fd, int timeout_ms)                              *
+ *                                                                                                          *
+ *  Proposito: Esperar datos en fd (el FIFO de entrada) sin retener respuestas mientras se espera: si hay   *
+ *             respuestas en cola y no hay nada que leer, se envian antes de dormir. Mientras sigan         *
+ *             llegando mensajes las respuestas se acumulan, y salida_vencer() pone el tope del plazo.      *
+ *             Con timeout_ms < 0 no se espera: la lectura bloqueante que sigue hace la espera.             *
+ *                                                                                                          *
+ *  Retorno:   Como poll(): > 0 si hay datos (o timeout_ms < 0), 0 si se agoto timeout_ms, -1 ante error.   *
+ ************************************************************************************************************/
+int salida_esperar_entrada(salida_respuestas_t *s, int fd, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    pthread_mutex_lock(&s->mutex);
+    uint64_t primera = s->primera_ns;
+    pthread_mutex_unlock(&s->mutex);
+
+    if (primera != 0) {
+        int listo = poll(&pfd, 1, 0);
+        if (listo != 0) return listo;
+
+        salida_vaciar(s);
+    }
+
+    return (timeout_ms < 0) ? 1 : poll(&pfd, 1, timeout_ms);
+}
+
+/************************************************************************************************************
+ *  void salida_cerrar(salida_respuestas_t *s, const char *prefijo)                                         *
+ *                                                                                                          *
+ *  Proposito: Enviar lo que quede en cola, cerrar los FIFOs de los agentes e imprimir cuantas llamadas     *
+ *             al sistema costo cada respuesta.                                                             *
+ ************************************************************************************************************/
+void salida_cerrar(salida_respuestas_t *s, const char *prefijo)
+{
+    int i;
+
+    pthread_mutex_lock(&s->mutex);
+    vaciar_todo(s);
+    for (i = 0; i < s->num_destinos; i++) {
+        if (s->destinos[i].fd != -1) {
+            close(s->destinos[i].fd);
+            s->destinos[i].fd = -1;
+        }
+    }
+    pthread_mutex_unlock(&s->mutex);
+
+    if (s->respuestas > 0) {
+        printf("%s %llu respuestas en %llu writev (%.3f por respuesta), %llu aperturas de FIFO, "
+               "%llu descartadas; plazo %d us\n", prefijo,
+               (unsigned long long) s->respuestas, (unsigned long long) s->escrituras,
+               (double) s->escrituras / (double) s->respuestas, (unsigned long long) s->aperturas,
+               (unsigned long long) s->descartadas, s->plazo_us);
+    }
+
+    pthread_mutex_destroy(&s->mutex);
+}
@@ -0,0 +1,107 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 03/12/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera de la salida de respuestas hacia los agentes.                   *
+ *               Cada respuesta se termina en '\n' y se encola en el destino de su agente. Los       *
+ *               textos quedan en un solo buffer, en orden de llegada, y cada destino guarda un      *
+ *               iovec por respuesta: al enviar, un writev() junta todas las del agente.             *
+ *                                                                                                   *
+ *               Un destino se envia cuando:                                                         *
+ *                 - la siguiente respuesta haria pasar la tanda de PIPE_BUF bytes (las escrituras   *
+ *                   de hasta PIPE_BUF bytes en un FIFO son atomicas: nunca se mezclan con las de    *
+ *                   otro parque ni se parte una respuesta);                                         *
+ *                 - quien atiende se queda sin mensajes (salida_vaciar o salida_esperar_entrada);   *
+ *                 - con mensajes llegando sin pausa, la respuesta mas antigua cumple el plazo       *
+ *                   (plazo_us, revisado por salida_vencer despues de cada mensaje).                 *
+ *               Con plazo_us = 0 cada respuesta sale de inmediato.                                  *
+ *                                                                                                   *
+ *               Si se pasa una muestra de latencia con la respuesta, su MARCA_RESPONDIDO se toma    *
+ *               cuando el writev() que la contiene termina, y ahi mismo se registra (con el mutex,  *
+ *               porque tambien envia el reloj). Si la respuesta se descarta, la muestra tambien.    *
+ *                                                                                                   *
+ *               El FIFO de cada agente se abre una vez y queda abierto. Si el agente termino y      *
+ *               otro crea de nuevo el FIFO, la escritura falla con EPIPE y se reabre (el proceso    *
+ *               debe ignorar SIGPIPE).                                                              *
+ *                                                                                                   *
+ *               No depende de controlador.h.                                                        *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __SALIDA_H__
+#define __SALIDA_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/uio.h>
+
+#include "latencia.h"
+
+#define PLAZO_RESPUESTAS_US_DEFECTO   200     /* Espera maxima de una respuesta en cola       */
+#define MAX_DESTINOS_RESPUESTA        64      /* Agentes con FIFO abierto a la vez            */
+#define MAX_RESPUESTAS_DESTINO        64      /* Respuestas en cola por agente (iovec)        */
+#define TAM_TEXTO_SALIDA              (PIPE_BUF * 8)
+#define MAX_LONG_PIPE_SALIDA          128
+#define MAX_MUESTRAS_SALIDA           64      /* Muestras esperando su writev (lleno: vaciar) */
+#define MAX_LONG_TIPO_MUESTRA         16
+
+/* ---- Un agente: su FIFO abierto y sus respuestas en cola ---- */
+typedef struct {
+    char         pipe[MAX_LONG_PIPE_SALIDA];
+    int          fd;                /* -1 = se abre en el proximo envio                   */
+    int          num;               /* Respuestas en cola                                 */
+    size_t       bytes;             /* Bytes en cola (nunca mas de PIPE_BUF)              */
+    uint64_t     primera_ns;        /* Cuando se encolo la respuesta mas antigua          */
+    struct iovec iov[MAX_RESPUESTAS_DESTINO];
+} destino_respuesta_t;
+
+/* ---- Muestra de latencia de una respuesta en cola ---- */
+typedef struct {
+    muestra_latencia_t m;
+    int                destino;     /* Indice en destinos                                 */
+    char               tipo[MAX_LONG_TIPO_MUESTRA];
+} muestra_salida_t;
+
+/* ---- Salida de un hilo que responde (la comparten el que atiende y el reloj, con mutex) ---- */
+typedef struct {
+    int             plazo_us;
+    pthread_mutex_t mutex;
+
+    char            texto[TAM_TEXTO_SALIDA];    /* Textos en cola de todos los destinos     */
+    size_t          usados;
+    uint64_t        primera_ns;     /* Respuesta mas antigua en cola (0 = cola vacia)     */
+
+    destino_respuesta_t destinos[MAX_DESTINOS_RESPUESTA];
+    int                 num_destinos;
+    int                 ultimo;     /* Ultimo destino usado: las rafagas van al mismo     */
+
+    latencia_t         *latencia;   /* Donde se registran las muestras (NULL = ninguna)   */
+    muestra_salida_t    muestras[MAX_MUESTRAS_SALIDA];
+    int                 num_muestras;
+
+    /* ---- Contadores (con el mutex) ---- */
+    uint64_t        respuestas;
+    uint64_t        escrituras;     /* Llamadas a writev()                                */
+    uint64_t        aperturas;
+    uint64_t        descartadas;    /* Sin lector, FIFO lleno o error                     */
+} salida_respuestas_t;
+
+/***************************************** Prototipos *******************************************************/
+
+int  salida_inicializar(salida_respuestas_t *s, int plazo_us, latencia_t *latencia);
+void salida_encolar(salida_respuestas_t *s, const char *pipe, const char *texto,
+                    const muestra_latencia_t *muestra, const char *tipo);
+void salida_registrar(salida_respuestas_t *s, muestra_latencia_t *muestra, const char *tipo);
+void salida_vencer(salida_respuestas_t *s);
+void salida_vaciar(salida_respuestas_t *s);
+int  salida_esperar_entrada(salida_respuestas_t *s, int fd, int timeout_ms);
+void salida_cerrar(salida_respuestas_t *s, const char *prefijo);
+
+#endif /* __SALIDA_H__ */
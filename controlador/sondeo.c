@@ -0,0 +1,218 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 30/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    sondeo.c                                                                                    *
+ *                                                                                                         *
+ * Descripcion: Lectura con giro y luego espera (ver sondeo.h) y afinidad de hilos a nucleos.              *
+ ************************************************************************************************************/
+
+#define _GNU_SOURCE
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sondeo.h"
+
+#define SONDEO_LECTURAS_POR_RELOJ     16      /* Lecturas entre consultas al reloj           */
+
+static uint64_t ahora_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* ---- Indica al nucleo que es un bucle de espera (cede recursos al otro hilo SMT) ---- */
+static inline void pausa_cpu(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile ("pause" ::: "memory");
+#elif defined(__aarch64__)
+    __asm__ volatile ("yield" ::: "memory");
+#else
+    __asm__ volatile ("" ::: "memory");
+#endif
+}
+
+/************************************************************************************************************
+ *  void sondeo_inicializar(sondeo_t *s, int nucleo, int giro_max_us)                                       *
+ *                                                                                                          *
+ *  Proposito: Activar el sondeo. giro_max_us <= 0 usa el tope por defecto. El presupuesto arranca en el    *
+ *             tope y se ajusta solo con el trafico.                                                        *
+ ************************************************************************************************************/
+void sondeo_inicializar(sondeo_t *s, int nucleo, int giro_max_us)
+{
+    memset(s, 0, sizeof(*s));
+
+    if (giro_max_us <= 0) {
+        giro_max_us = SONDEO_GIRO_MAX_US_DEFECTO;
+    }
+
+    s->activo      = 1;
+    s->nucleo      = nucleo;
+    s->giro_max_ns = (uint64_t) giro_max_us * 1000ULL;
+    if (s->giro_max_ns < SONDEO_GIRO_MIN_NS) {
+        s->giro_max_ns = SONDEO_GIRO_MIN_NS;
+    }
+    s->giro_ns = s->giro_max_ns;
+}
+
+/************************************************************************************************************
+ *  ssize_t sondeo_leer(sondeo_t *s, int fd, void *destino, size_t largo)                                   *
+ *                                                                                                          *
+ *  Proposito: read() sobre un descriptor con O_NONBLOCK que se comporta como uno bloqueante: gira hasta    *
+ *             agotar el presupuesto y despues se estaciona en poll(). Tras estacionarse vuelve a girar,    *
+ *             porque los mensajes suelen llegar en rafagas.                                                *
+ *                                                                                                          *
+ *  Retorno:   Lo mismo que read(), salvo que nunca devuelve EAGAIN.                                        *
+ ************************************************************************************************************/
+ssize_t sondeo_leer(sondeo_t *s, int fd, void *destino, size_t largo)
+{
+    ssize_t n = read(fd, destino, largo);
+
+    if (n > 0) {
+        s->lecturas_directas++;
+        return n;
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        return n;
+    }
+
+    for (;;) {
+        uint64_t inicio = ahora_ns();
+        uint64_t limite = inicio + s->giro_ns;
+        unsigned vueltas = 0;
+
+        /* ---- Girar ---- */
+        for (;;) {
+            pausa_cpu();
+
+            n = read(fd, destino, largo);
+            if (n > 0) {
+                /* Acercar el presupuesto al doble de lo que hubo que esperar (media movil 1/8) */
+                uint64_t objetivo = 2 * (ahora_ns() - inicio);
+                if (objetivo > s->giro_max_ns) objetivo = s->giro_max_ns;
+                if (objetivo < SONDEO_GIRO_MIN_NS) objetivo = SONDEO_GIRO_MIN_NS;
+
+                s->giro_ns = s->giro_ns - s->giro_ns / 8 + objetivo / 8;
+                s->lecturas_giro++;
+                return n;
+            }
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                return n;
+            }
+
+            if (++vueltas % SONDEO_LECTURAS_POR_RELOJ == 0 && ahora_ns() >= limite) {
+                break;
+            }
+        }
+
+        /* ---- Estacionarse: el trafico es mas lento que el presupuesto ---- */
+        s->giro_ns /= 2;
+        if (s->giro_ns < SONDEO_GIRO_MIN_NS) {
+            s->giro_ns = SONDEO_GIRO_MIN_NS;
+        }
+        s->esperas++;
+
+        struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+        if (poll(&pfd, 1, -1) == -1 && errno != EINTR) {
+            return -1;
+        }
+
+        n = read(fd, destino, largo);
+        if (n > 0 || n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            return n;
+        }
+    }
+}
+
+/************************************************************************************************************
+ *  void sondeo_imprimir(const sondeo_t *s, const char *prefijo)                                            *
+ ************************************************************************************************************/
+void sondeo_imprimir(const sondeo_t *s, const char *prefijo)
+{
+    if (!s->activo) return;
+
+    printf("%s Nucleo %d: %llu lecturas directas, %llu girando, %llu esperas en poll(); "
+           "giro final %.1f us (tope %.1f us)\n",
+           prefijo, s->nucleo,
+           (unsigned long long) s->lecturas_directas,
+           (unsigned long long) s->lecturas_giro,
+           (unsigned long long) s->esperas,
+           (double) s->giro_ns / 1000.0, (double) s->giro_max_ns / 1000.0);
+}
+
+/************************************************************************************************************
+ *  int sondeo_fijar_nucleo(int nucleo)                                                                     *
+ *                                                                                                          *
+ *  Proposito: Fijar el hilo que llama a un nucleo. nucleo < 0 no hace nada.                                *
+ *                                                                                                          *
+ *  Retorno:   0 si se fijo (o no habia que fijarlo); -1 si el sistema no lo permitio.                      *
+ ************************************************************************************************************/
+int sondeo_fijar_nucleo(int nucleo)
+{
+    cpu_set_t conjunto;
+
+    if (nucleo < 0) return 0;
+
+    CPU_ZERO(&conjunto);
+    CPU_SET(nucleo, &conjunto);
+
+    int r = pthread_setaffinity_np(pthread_self(), sizeof(conjunto), &conjunto);
+    if (r != 0) {
+        fprintf(stderr, "[SONDEO] No se pudo fijar el hilo al nucleo %d: %s\n", nucleo, strerror(r));
+        return -1;
+    }
+    return 0;
+}
+
+/************************************************************************************************************
+ *  int sondeo_excluir_nucleo(int nucleo)                                                                   *
+ *                                                                                                          *
+ *  Proposito: Quitar el nucleo de la afinidad del hilo que llama. Los hilos que cree despues la heredan,   *
+ *             asi que llamandolo desde main antes de crear hilos el reloj, la replicacion y el resto       *
+ *             quedan fuera del nucleo del lector. Si era el unico nucleo disponible no se cambia nada.     *
+ *                                                                                                          *
+ *  Retorno:   0 si se excluyo; -1 si no.                                                                   *
+ ************************************************************************************************************/
+int sondeo_excluir_nucleo(int nucleo)
+{
+    cpu_set_t conjunto;
+    int r;
+
+    if (nucleo < 0) return 0;
+
+    r = pthread_getaffinity_np(pthread_self(), sizeof(conjunto), &conjunto);
+    if (r != 0) {
+        fprintf(stderr, "[SONDEO] No se pudo leer la afinidad: %s\n", strerror(r));
+        return -1;
+    }
+
+    CPU_CLR(nucleo, &conjunto);
+    if (CPU_COUNT(&conjunto) == 0) {
+        fprintf(stderr, "[SONDEO] El nucleo %d es el unico disponible: los demas hilos lo comparten.\n",
+                nucleo);
+        return -1;
+    }
+
+    r = pthread_setaffinity_np(pthread_self(), sizeof(conjunto), &conjunto);
+    if (r != 0) {
+        fprintf(stderr, "[SONDEO] No se pudo excluir el nucleo %d: %s\n", nucleo, strerror(r));
+        return -1;
+    }
+    return 0;
+}
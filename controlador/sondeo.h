@@ -0,0 +1,52 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 30/11/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera del modo de baja latencia (sondeo activo).                      *
+ *               El hilo que lee el FIFO se fija a un nucleo y, en lugar de bloquearse en read(),    *
+ *               gira sobre lecturas no bloqueantes durante un presupuesto de tiempo. Si en ese      *
+ *               tiempo no llega nada se estaciona en poll() hasta el siguiente mensaje.             *
+ *                                                                                                   *
+ *               El presupuesto se adapta: se acerca al doble de la espera observada cuando el       *
+ *               mensaje llega girando y se reduce a la mitad cada vez que hay que estacionarse.     *
+ *                                                                                                   *
+ *               No depende de controlador.h para que los benchmarks lo usen por separado.           *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __SONDEO_H__
+#define __SONDEO_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdint.h>
+#include <sys/types.h>
+
+#define SONDEO_GIRO_MIN_NS            1000ULL         /* Nunca se gira menos de 1 us            */
+#define SONDEO_GIRO_MAX_US_DEFECTO    200             /* Tope del presupuesto si no se indica   */
+
+/* ---- Estado del sondeo (solo lo toca el hilo que lee) ---- */
+typedef struct {
+    int      activo;                /* 0 = lectura bloqueante de siempre                  */
+    int      nucleo;                /* Nucleo del hilo lector (-1 = sin fijar)            */
+    uint64_t giro_ns;               /* Presupuesto actual de giro                         */
+    uint64_t giro_max_ns;
+
+    uint64_t lecturas_giro;         /* Datos encontrados girando                          */
+    uint64_t lecturas_directas;     /* Datos ya disponibles en la primera lectura         */
+    uint64_t esperas;               /* Veces que se estaciono en poll()                   */
+} sondeo_t;
+
+/***************************************** Prototipos *******************************************************/
+
+void    sondeo_inicializar(sondeo_t *s, int nucleo, int giro_max_us);
+ssize_t sondeo_leer(sondeo_t *s, int fd, void *destino, size_t largo);
+void    sondeo_imprimir(const sondeo_t *s, const char *prefijo);
+
+int     sondeo_fijar_nucleo(int nucleo);
+int     sondeo_excluir_nucleo(int nucleo);
+
+#endif /* __SONDEO_H__ */
@@ -0,0 +1,302 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 22/11/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    traza.c                                                                                     *
+ *                                                                                                         *
+ * Descripcion: Grabacion y repeticion determinista del trafico de entrada del Controlador. Los enteros    *
+ *              se guardan como varint (LEB128) y los instantes como diferencia con el evento anterior,    *
+ *              asi un mensaje tipico ocupa pocos bytes mas que su propio texto.                           *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "traza.h"
+
+/************************************************************************************************************
+ *  static void escribir_varint(FILE *fp, uint64_t v)                                                       *
+ *                                                                                                          *
+ *  Proposito: Escribir v en 7 bits por byte; el bit alto indica que sigue otro byte.                       *
+ ************************************************************************************************************/
+static void escribir_varint(FILE *fp, uint64_t v)
+{
+    while (v >= 0x80) {
+        fputc((int) (v & 0x7F) | 0x80, fp);
+        v >>= 7;
+    }
+    fputc((int) v, fp);
+}
+
+/************************************************************************************************************
+ *  static int leer_varint(FILE *fp, uint64_t *v)                                                           *
+ *                                                                                                          *
+ *  Retorno: 1 si se leyo un valor; 0 en fin de archivo limpio; -1 si el valor esta truncado.               *
+ ************************************************************************************************************/
+static int leer_varint(FILE *fp, uint64_t *v)
+{
+    int c, desplazamiento = 0;
+
+    *v = 0;
+    while ((c = fgetc(fp)) != EOF) {
+        *v |= (uint64_t) (c & 0x7F) << desplazamiento;
+        if ((c & 0x80) == 0) return 1;
+
+        desplazamiento += 7;
+        if (desplazamiento > 63) return -1;
+    }
+
+    return (desplazamiento == 0) ? 0 : -1;
+}
+
+/************************************************************************************************************
+ *  traza_t *traza_abrir_escritura(const char *ruta, const controlador_t *ctrl)                             *
+ *                                                                                                          *
+ *  Proposito: Crear el archivo de traza y escribir la cabecera con la configuracion del parque.            *
+ *                                                                                                          *
+ *  Retorno:   La traza abierta, o NULL si no se pudo crear.                                                *
+ ************************************************************************************************************/
+traza_t *traza_abrir_escritura(const char *ruta, const controlador_t *ctrl)
+{
+    traza_t *tr = calloc(1, sizeof(traza_t));
+    if (tr == NULL) {
+        perror("calloc (traza)");
+        return NULL;
+    }
+
+    tr->fp = fopen(ruta, "wb");
+    if (tr->fp == NULL) {
+        perror("fopen (traza de escritura)");
+        free(tr);
+        return NULL;
+    }
+
+    memcpy(tr->cabecera.magico, TRAZA_MAGICO, 4);
+    tr->cabecera.version           = TRAZA_VERSION;
+    tr->cabecera.hora_ini          = ctrl->hora_ini;
+    tr->cabecera.hora_fin          = ctrl->hora_fin;
+    tr->cabecera.aforo_maximo      = ctrl->aforo_maximo;
+    tr->cabecera.segundos_por_hora = ctrl->segundos_por_hora;
+    tr->cabecera.duracion_reserva  = (ctrl->duracion_reserva > 0) ? ctrl->duracion_reserva
+                                                                  : DURACION_RESERVA_DEFECTO;
+    tr->cabecera.lista_espera      = ctrl->lista_espera ? 1 : 0;
+
+    if (fwrite(&tr->cabecera, sizeof(tr->cabecera), 1, tr->fp) != 1) {
+        perror("fwrite (cabecera de traza)");
+        fclose(tr->fp);
+        free(tr);
+        return NULL;
+    }
+
+    return tr;
+}
+
+/************************************************************************************************************
+ *  int traza_grabar(traza_t *tr, uint64_t t_ns, int hora_actual, int pendientes,                           *
+ *                   const char *linea, int longitud)                                                       *
+ *                                                                                                          *
+ *  Proposito: Agregar un evento. t_ns es absoluto (CLOCK_MONOTONIC); se guarda la diferencia con el        *
+ *             evento anterior. La escritura queda en el buffer de stdio hasta traza_vaciar().              *
+ *                                                                                                          *
+ *  Retorno:   0 si se grabo; -1 ante error de escritura.                                                   *
+ ************************************************************************************************************/
+int traza_grabar(traza_t *tr, uint64_t t_ns, int hora_actual, int pendientes,
+                 const char *linea, int longitud)
+{
+    if (tr->eventos == 0) {
+        tr->t_inicio_ns = t_ns;
+    }
+
+    uint64_t relativo = (t_ns > tr->t_inicio_ns) ? t_ns - tr->t_inicio_ns : 0;
+    if (relativo < tr->t_anterior_ns) {
+        relativo = tr->t_anterior_ns;
+    }
+
+    escribir_varint(tr->fp, relativo - tr->t_anterior_ns);
+    fputc(hora_actual & 0xFF, tr->fp);
+    escribir_varint(tr->fp, (uint64_t) (pendientes > 0 ? pendientes : 0));
+    escribir_varint(tr->fp, (uint64_t) longitud);
+
+    if (fwrite(linea, 1, (size_t) longitud, tr->fp) != (size_t) longitud) {
+        perror("fwrite (evento de traza)");
+        return -1;
+    }
+
+    tr->t_anterior_ns = relativo;
+    tr->eventos++;
+    return 0;
+}
+
+/************************************************************************************************************
+ *  void traza_vaciar(traza_t *tr)                                                                          *
+ ************************************************************************************************************/
+void traza_vaciar(traza_t *tr)
+{
+    fflush(tr->fp);
+}
+
+/************************************************************************************************************
+ *  traza_t *traza_abrir_lectura(const char *ruta)                                                          *
+ *                                                                                                          *
+ *  Proposito: Abrir una traza y validar su cabecera.                                                       *
+ *                                                                                                          *
+ *  Retorno:   La traza abierta, o NULL si no existe o no es una traza valida.                              *
+ ************************************************************************************************************/
+traza_t *traza_abrir_lectura(const char *ruta)
+{
+    traza_t *tr = calloc(1, sizeof(traza_t));
+    if (tr == NULL) {
+        perror("calloc (traza)");
+        return NULL;
+    }
+
+    tr->fp = fopen(ruta, "rb");
+    if (tr->fp == NULL) {
+        perror("fopen (traza de lectura)");
+        free(tr);
+        return NULL;
+    }
+
+    if (fread(&tr->cabecera, sizeof(tr->cabecera), 1, tr->fp) != 1 ||
+        memcmp(tr->cabecera.magico, TRAZA_MAGICO, 4) != 0 ||
+        tr->cabecera.version != TRAZA_VERSION) {
+        fprintf(stderr, "Error: '%s' no es una traza valida.\n", ruta);
+        fclose(tr->fp);
+        free(tr);
+        return NULL;
+    }
+
+    return tr;
+}
+
+/************************************************************************************************************
+ *  int traza_leer(traza_t *tr, evento_traza_t *ev)                                                         *
+ *                                                                                                          *
+ *  Retorno:   1 si se leyo un evento; 0 al final de la traza; -1 si la traza esta truncada o corrupta.     *
+ ************************************************************************************************************/
+int traza_leer(traza_t *tr, evento_traza_t *ev)
+{
+    uint64_t delta, pendientes, longitud;
+    int hora, r;
+
+    r = leer_varint(tr->fp, &delta);
+    if (r <= 0) return r;
+
+    if ((hora = fgetc(tr->fp)) == EOF)          return -1;
+    if (leer_varint(tr->fp, &pendientes) != 1)  return -1;
+    if (leer_varint(tr->fp, &longitud) != 1)    return -1;
+    if (longitud >= MAX_LONG_LINEA_TRAZA)       return -1;
+
+    if (fread(ev->linea, 1, (size_t) longitud, tr->fp) != (size_t) longitud) {
+        return -1;
+    }
+
+    tr->t_anterior_ns += delta;
+    tr->eventos++;
+
+    ev->t_ns         = tr->t_anterior_ns;
+    ev->hora_actual  = hora;
+    ev->pendientes   = (int) pendientes;
+    ev->longitud     = (int) longitud;
+    ev->linea[longitud] = '\0';
+
+    return 1;
+}
+
+/************************************************************************************************************
+ *  void traza_cerrar(traza_t *tr)                                                                          *
+ ************************************************************************************************************/
+void traza_cerrar(traza_t *tr)
+{
+    if (tr == NULL) return;
+
+    if (tr->fp != NULL) {
+        fclose(tr->fp);
+    }
+    free(tr);
+}
+
+/************************************************************************************************************
+ *  int traza_repetir(controlador_t *ctrl, traza_t *tr, int ritmo_original)                                 *
+ *                                                                                                          *
+ *  Proposito: Alimentar el motor de reservas con los eventos de la traza, sin FIFOs ni hilos. Antes de     *
+ *             cada mensaje se fija la hora de simulacion grabada (avanzando el reloj si cambio), asi el    *
+ *             resultado no depende de la velocidad de la repeticion. Con ritmo_original se respetan los    *
+ *             tiempos entre mensajes; si no, se procesan tan rapido como sea posible.                      *
+ *             Las respuestas se calculan pero no se envian.                                                *
+ *                                                                                                          *
+ *  Retorno:   0 si se repitio toda la traza; -1 si estaba truncada o corrupta.                             *
+ ************************************************************************************************************/
+int traza_repetir(controlador_t *ctrl, traza_t *tr, int ritmo_original)
+{
+    evento_traza_t ev;
+    char respuesta[MAX_LONG_MENSAJE];
+    char pipe_destino[MAX_LONG_NOMBRE_PIPE];
+    long respondidos = 0;
+    int  r;
+
+    uint64_t t_inicio = reloj_monotonico_ns();
+
+    while ((r = traza_leer(tr, &ev)) == 1) {
+
+        /* ---- Ritmo original: esperar hasta el instante relativo del evento ---- */
+        if (ritmo_original) {
+            uint64_t ahora = reloj_monotonico_ns() - t_inicio;
+
+            if (ev.t_ns > ahora) {
+                struct timespec espera;
+                uint64_t falta = ev.t_ns - ahora;
+
+                espera.tv_sec  = (time_t) (falta / 1000000000ULL);
+                espera.tv_nsec = (long) (falta % 1000000000ULL);
+                nanosleep(&espera, NULL);
+            }
+        }
+
+        /* ---- Reproducir los cambios de hora tal como se vieron al grabar ---- */
+        if (ev.hora_actual != CTRL_HORA_ACTUAL(ctrl) &&
+            ev.hora_actual >= 0 && ev.hora_actual <= MAX_HORAS_DIA) {
+            servidor_avanzar_reloj(ctrl, ev.hora_actual);
+        }
+
+        mensaje_entrada_t  msg;
+        muestra_latencia_t muestra;
+
+        msg.linea      = ev.linea;
+        msg.t_ns       = ev.t_ns;
+        msg.pendientes = ev.pendientes;
+        msg.muestra    = latencia_muestrear(&ctrl->latencia, &muestra);
+        latencia_marcar(msg.muestra, MARCA_RECIBIDO);
+
+        respondidos += servidor_procesar_mensaje(ctrl, &msg, respuesta, sizeof(respuesta),
+                                                 pipe_destino);
+
+        /* ---- La repeticion no escribe respuestas: la ultima etapa termina con el texto listo ---- */
+        latencia_marcar(msg.muestra, MARCA_RESPONDIDO);
+        latencia_registrar(&ctrl->latencia, msg.muestra, msg.linea);
+    }
+
+    uint64_t transcurrido = reloj_monotonico_ns() - t_inicio;
+    double   segundos     = (double) transcurrido / 1e9;
+
+    printf("[REPETICION] %ld mensajes (%ld respuestas) en %.6f s", tr->eventos, respondidos, segundos);
+    if (transcurrido > 0) {
+        printf(" -> %.0f mensajes/s", (double) tr->eventos / segundos);
+    }
+    printf("\n");
+
+    if (r < 0) {
+        fprintf(stderr, "Error: traza truncada o corrupta despues de %ld eventos.\n", tr->eventos);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+/*****************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                  *
+ *                                                                                                   *
+ * ------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                           *
+ * Fecha       : 22/11/2025                                                                          *
+ *                                                                                                   *
+ * Descripcion : Archivo de cabecera para la grabacion y repeticion de trazas de entrada.            *
+ *               Una traza guarda cada mensaje recibido por el FIFO con su instante monotonico, la   *
+ *               hora de simulacion con la que se decidio y los bytes en cola detras de el. Al       *
+ *               repetirla, los mensajes entran directo al motor de reservas, sin FIFOs ni hilos.    *
+ *                                                                                                   *
+ *               Formato (binario, little-endian):                                                   *
+ *                 cabecera_traza_t                                                                  *
+ *                 por evento: varint delta_ns | u8 hora | varint pendientes | varint long | bytes   *
+ *                                                                                                   *
+ *****************************************************************************************************/
+
+#ifndef __TRAZA_H__
+#define __TRAZA_H__
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdint.h>
+
+#include "controlador.h"
+
+#define TRAZA_MAGICO                  "RSVT"
+#define TRAZA_VERSION                 2
+#define MAX_LONG_LINEA_TRAZA          (MAX_LONG_MENSAJE * 4)
+
+/* ---- Cabecera: configuracion del parque al momento de grabar ---- */
+typedef struct {
+    char     magico[4];
+    uint16_t version;
+    uint16_t reservado;
+    int32_t  hora_ini;
+    int32_t  hora_fin;
+    int32_t  aforo_maximo;
+    int32_t  segundos_por_hora;
+    int32_t  duracion_reserva;      /* Horas de cada reserva (-d)                           */
+    int32_t  lista_espera;          /* 1 si se grabo con lista de espera (-e)               */
+} cabecera_traza_t;
+
+/* ---- Evento leido de una traza ---- */
+typedef struct {
+    uint64_t t_ns;                          /* Relativo al inicio de la grabacion           */
+    int      hora_actual;
+    int      pendientes;
+    int      longitud;
+    char     linea[MAX_LONG_LINEA_TRAZA];
+} evento_traza_t;
+
+typedef struct traza {
+    FILE            *fp;
+    cabecera_traza_t cabecera;
+    uint64_t         t_inicio_ns;           /* Solo escritura: instante del primer evento   */
+    uint64_t         t_anterior_ns;         /* Ultimo instante relativo escrito o leido     */
+    long             eventos;
+} traza_t;
+
+/***************************************** Prototipos *******************************************************/
+
+traza_t *traza_abrir_escritura(const char *ruta, const controlador_t *ctrl);
+int      traza_grabar(traza_t *tr, uint64_t t_ns, int hora_actual, int pendientes,
+                      const char *linea, int longitud);
+void     traza_vaciar(traza_t *tr);
+
+traza_t *traza_abrir_lectura(const char *ruta);
+int      traza_leer(traza_t *tr, evento_traza_t *ev);
+
+void     traza_cerrar(traza_t *tr);
+
+int      traza_repetir(controlador_t *ctrl, traza_t *tr, int ritmo_original);
+
+#endif /* __TRAZA_H__ */
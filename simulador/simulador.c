@@ -0,0 +1,615 @@
+/***********************************************************************************************************
+ *                                   PONTIFICIA UNIVERSIDAD JAVERIANA                                      *
+ *                     Departamento de Ingenieria de Sistemas – Sistemas Operativos                        *
+ *                                                                                                         *
+ * ------------------------------------------------------------------------------------------------------- *
+ * Autor       : Thomas Leal, Carolina Ujueta, Diego Melgarejo, Juan Motta                                 *
+ * Fecha       : 02/12/2025                                                                                *
+ * Materia:    Sistemas Operativos                                                                         *
+ * Profesor:   John Jairo Corredor, PhD                                                                    *
+ * Fichero:    simulador.c                                                                                 *
+ *                                                                                                         *
+ * Descripcion: Simulador de capacidad ("que pasaria si"). Carga la demanda una sola vez (CSV de agentes   *
+ *              o traza grabada con -g) y la pasa por el motor de reservas del controlador para cada       *
+ *              combinacion de aforo, horario y duracion de la reserva, sin FIFOs, sin reloj y sin pausas. *
+ *              Cada configuracion es independiente: un grupo de hilos las toma de una en una y cada hilo  *
+ *              reutiliza su propio controlador_t. Al final se imprime, por configuracion, la tasa de      *
+ *              aceptadas, reprogramadas y negadas y la utilizacion del aforo.                             *
+ *                                                                                                         *
+ *              Llegadas: con traza, cada mensaje llega a la hora de simulacion con la que se grabo (o a   *
+ *              la apertura, si el parque simulado abre despues). Con CSV, la linea k de cada archivo      *
+ *              llega k / solicitudesPorHora horas despues de la apertura (-q; 0 = todas al abrir), como   *
+ *              un agente que envia a ritmo constante. Lo que llega despues del cierre es fuera_horario.   *
+ *                                                                                                         *
+ * Uso:         ./simulador_exec (-a demanda.csv ... | -R traza.bin) [-t aforos] [-i horasIni]             *
+ *                  [-f horasFin] [-d duraciones] [-q solicitudesPorHora] [-n hilos] [-e] [-o salida.csv]  *
+ *              Cada rejilla es una lista "a,b,c" o un rango "ini:fin[:paso]", o una mezcla: "20:60:10,80" *
+ ************************************************************************************************************/
+
+/***************************************** Headers **********************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "controlador.h"
+#include "traza.h"
+
+#define MAX_VALORES_REJILLA           64
+#define MAX_HILOS_SIMULADOR           64
+#define LINEAS_INICIALES_DEMANDA      4096
+
+#define USO_SIMULADOR \
+    "Uso: %s (-a demanda.csv [-a ...] | -R traza.bin) [-t aforos] [-i horasIni] [-f horasFin]\n" \
+    "          [-d duraciones] [-q solicitudesPorHora] [-n hilos] [-e] [-o salida.csv]\n" \
+    "   rejillas: lista \"a,b,c\" o rango \"ini:fin[:paso]\" (por ejemplo -t 20:100:20 -f 17,19)\n"
+
+/* ---- Un mensaje de la demanda, ya con el formato del FIFO ---- */
+typedef struct {
+    int      llegada;               /* Hora absoluta (traza) o horas desde la apertura (CSV)  */
+    uint32_t inicio;                /* Desplazamiento de la linea en demanda_t.texto           */
+    uint16_t longitud;
+    char     es_solicitud;
+} evento_demanda_t;
+
+/* ---- Demanda completa, ordenada por llegada (solo lectura durante la simulacion) ---- */
+typedef struct {
+    evento_demanda_t *eventos;
+    long              num;
+    long              capacidad;
+    long              solicitudes;
+    char             *texto;
+    size_t            usados;
+    size_t            capacidad_texto;
+    int               relativa;     /* 1 = llegadas relativas a la apertura (CSV)              */
+} demanda_t;
+
+/* ---- Configuracion a simular y su resultado ---- */
+typedef struct {
+    int    aforo;
+    int    hora_ini;
+    int    hora_fin;
+    int    duracion;
+
+    long   solicitudes;
+    long   aceptadas;
+    long   reprogramadas;
+    long   negadas;
+    long   fuera_horario;
+    long   promovidas;
+    long   canceladas;
+    double utilizacion;             /* Personas-hora ocupadas / (aforo * horas abiertas)       */
+} resultado_t;
+
+typedef struct {
+    const demanda_t *demanda;
+    resultado_t     *resultados;
+    int              num;
+    int              lista_espera;
+    atomic_int       siguiente;     /* Proxima configuracion libre                             */
+} simulacion_t;
+
+/************************************************************************************************************
+ *  static int leer_rejilla(const char *texto, int *valores, int *num)                                      *
+ *                                                                                                          *
+ *  Proposito: Convertir "a,b,c", "ini:fin[:paso]" o una mezcla separada por comas en una lista de enteros. *
+ *                                                                                                          *
+ *  Retorno:   0 si todo fue bien; -1 si el texto es invalido o hay mas de MAX_VALORES_REJILLA valores.     *
+ ************************************************************************************************************/
+static int leer_rejilla(const char *texto, int *valores, int *num)
+{
+    const char *p = texto;
+
+    *num = 0;
+
+    while (*p != '\0') {
+        int ini, fin, paso = 1, consumidos = 0, v;
+
+        if (sscanf(p, "%d:%d:%d%n", &ini, &fin, &paso, &consumidos) == 3 ||
+            (paso = 1, sscanf(p, "%d:%d%n", &ini, &fin, &consumidos)) == 2) {
+            if (paso <= 0 || fin < ini) return -1;
+        } else if (sscanf(p, "%d%n", &ini, &consumidos) == 1) {
+            fin = ini;
+        } else {
+            return -1;
+        }
+
+        for (v = ini; v <= fin; v += paso) {
+            if (*num >= MAX_VALORES_REJILLA) return -1;
+            valores[(*num)++] = v;
+        }
+
+        p += consumidos;
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+
+    return (*num > 0) ? 0 : -1;
+}
+
+/************************************************************************************************************
+ *  static int agregar_evento(demanda_t *d, int llegada, const char *linea, int longitud)                   *
+ ************************************************************************************************************/
+static int agregar_evento(demanda_t *d, int llegada, const char *linea, int longitud)
+{
+    if (d->num == d->capacidad) {
+        long nueva = (d->capacidad > 0) ? d->capacidad * 2 : LINEAS_INICIALES_DEMANDA;
+        evento_demanda_t *e = realloc(d->eventos, sizeof(evento_demanda_t) * (size_t) nueva);
+        if (e == NULL) {
+            perror("realloc (demanda)");
+            return -1;
+        }
+        d->eventos   = e;
+        d->capacidad = nueva;
+    }
+
+    if (d->usados + (size_t) longitud + 1 > d->capacidad_texto) {
+        size_t nueva = (d->capacidad_texto > 0) ? d->capacidad_texto * 2
+                                                : LINEAS_INICIALES_DEMANDA * 64;
+        while (d->usados + (size_t) longitud + 1 > nueva) nueva *= 2;
+
+        char *t = realloc(d->texto, nueva);
+        if (t == NULL) {
+            perror("realloc (texto de la demanda)");
+            return -1;
+        }
+        d->texto           = t;
+        d->capacidad_texto = nueva;
+    }
+
+    evento_demanda_t *e = &d->eventos[d->num++];
+
+    e->llegada      = llegada;
+    e->inicio       = (uint32_t) d->usados;
+    e->longitud     = (uint16_t) longitud;
+    e->es_solicitud = (strncmp(linea, "SOLICITUD;", 10) == 0);
+    d->solicitudes += e->es_solicitud;
+
+    memcpy(d->texto + d->usados, linea, (size_t) longitud);
+    d->texto[d->usados + (size_t) longitud] = '\0';
+    d->usados += (size_t) longitud + 1;
+
+    return 0;
+}
+
+/************************************************************************************************************
+ *  static int cargar_csv(demanda_t *d, const char *ruta, int num_archivo, int por_hora)                    *
+ *                                                                                                          *
+ *  Proposito: Traducir cada linea "Familia,Hora,Personas" o "Familia,CANCELAR" al mensaje que enviaria el  *
+ *             agente. Cada archivo es un agente con su propio pipe de respuesta (nunca se abre).           *
+ ************************************************************************************************************/
+static int cargar_csv(demanda_t *d, const char *ruta, int num_archivo, int por_hora)
+{
+    char linea[MAX_LONG_MENSAJE], familia[64], accion[16], mensaje[MAX_LONG_MENSAJE];
+    char pipe_resp[MAX_LONG_NOMBRE_PIPE];
+    int  hora, personas, longitud;
+    long k = 0;
+
+    FILE *fp = fopen(ruta, "r");
+    if (fp == NULL) {
+        perror(ruta);
+        return -1;
+    }
+
+    snprintf(pipe_resp, sizeof(pipe_resp), "/tmp/resp_simulador%d", num_archivo);
+
+    while (fgets(linea, sizeof(linea), fp)) {
+        if (sscanf(linea, "%63[^,],%15[^,\r\n]", familia, accion) == 2 &&
+            strcmp(accion, "CANCELAR") == 0) {
+            longitud = snprintf(mensaje, sizeof(mensaje), "CANCELACION;%s;%s", familia, pipe_resp);
+        } else if (sscanf(linea, "%63[^,],%d,%d", familia, &hora, &personas) == 3) {
+            longitud = snprintf(mensaje, sizeof(mensaje), "SOLICITUD;%s;%d;%d;%d;%s", familia, personas,
+                                hora, hora + DURACION_RESERVA_DEFECTO, pipe_resp);
+        } else {
+            continue;
+        }
+
+        if (agregar_evento(d, (por_hora > 0) ? (int) (k / por_hora) : 0, mensaje, longitud) != 0) {
+            fclose(fp);
+            return -1;
+        }
+        k++;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/************************************************************************************************************
+ *  static int cargar_traza(demanda_t *d, const char *ruta, cabecera_traza_t *cabecera)                     *
+ *                                                                                                          *
+ *  Proposito: Tomar de la traza las solicitudes y cancelaciones con la hora a la que llegaron. REGISTRO y  *
+ *             DISPONIBILIDAD no cambian el estado del parque y se descartan.                               *
+ ************************************************************************************************************/
+static int cargar_traza(demanda_t *d, const char *ruta, cabecera_traza_t *cabecera)
+{
+    static evento_traza_t ev;
+    int r;
+
+    traza_t *tr = traza_abrir_lectura(ruta);
+    if (tr == NULL) {
+        return -1;
+    }
+    *cabecera = tr->cabecera;
+
+    while ((r = traza_leer(tr, &ev)) == 1) {
+        if (strncmp(ev.linea, "SOLICITUD;", 10) != 0 && strncmp(ev.linea, "CANCELACION;", 12) != 0) {
+            continue;
+        }
+        if (agregar_evento(d, ev.hora_actual, ev.linea, ev.longitud) != 0) {
+            r = -1;
+            break;
+        }
+    }
+
+    if (r < 0) {
+        fprintf(stderr, "Error: traza truncada o corrupta despues de %ld eventos.\n", tr->eventos);
+    }
+    traza_cerrar(tr);
+
+    return (r < 0) ? -1 : 0;
+}
+
+/* ---- Orden estable por llegada: a igual hora, el orden original (que es el de inicio en el texto) ---- */
+static int comparar_llegada(const void *a, const void *b)
+{
+    const evento_demanda_t *x = a, *y = b;
+
+    if (x->llegada != y->llegada) return (x->llegada > y->llegada) - (x->llegada < y->llegada);
+    return (x->inicio > y->inicio) - (x->inicio < y->inicio);
+}
+
+/************************************************************************************************************
+ *  static void simular(controlador_t *ctrl, const demanda_t *d, int lista_espera, resultado_t *res)        *
+ *                                                                                                          *
+ *  Proposito: Correr un dia completo de la demanda con la configuracion de res sobre ctrl. El reloj se     *
+ *             adelanta hora por hora hasta la llegada de cada mensaje (asi se vencen las esperas igual que *
+ *             con el hilo reloj); como la demanda esta ordenada, al primer mensaje fuera de horario el     *
+ *             resto tambien lo esta.                                                                       *
+ ************************************************************************************************************/
+static void simular(controlador_t *ctrl, const demanda_t *d, int lista_espera, resultado_t *res)
+{
+    char respuesta[MAX_LONG_MENSAJE];
+    char pipe_destino[MAX_LONG_NOMBRE_PIPE];
+    char linea[MAX_LONG_LINEA_TRAZA];
+    long i, atendidas = 0;
+    int  h;
+
+    memset(ctrl, 0, sizeof(*ctrl));
+    ctrl->hora_ini          = res->hora_ini;
+    ctrl->hora_fin          = res->hora_fin;
+    ctrl->aforo_maximo      = res->aforo;
+    ctrl->duracion_reserva  = res->duracion;
+    ctrl->segundos_por_hora = 1;
+    ctrl->lista_espera      = lista_espera;
+    ctrl->silencioso        = 1;
+    ctrl->sin_respuestas    = 1;
+    ctrl->sin_archivos      = 1;
+
+    if (servidor_inicializar_estado(ctrl) != 0) {
+        res->solicitudes = -1;
+        return;
+    }
+
+    for (i = 0; i < d->num; i++) {
+        const evento_demanda_t *e = &d->eventos[i];
+        int llegada = d->relativa ? res->hora_ini + e->llegada
+                                  : (e->llegada > res->hora_ini ? e->llegada : res->hora_ini);
+
+        if (llegada >= res->hora_fin) break;
+
+        while (CTRL_HORA_ACTUAL(ctrl) < llegada) {
+            servidor_avanzar_reloj(ctrl, CTRL_HORA_ACTUAL(ctrl) + 1);
+        }
+
+        mensaje_entrada_t msg;
+
+        memcpy(linea, d->texto + e->inicio, (size_t) e->longitud + 1);
+        msg.linea      = linea;
+        msg.t_ns       = 0;
+        msg.pendientes = 0;
+        msg.muestra    = NULL;
+
+        servidor_procesar_mensaje(ctrl, &msg, respuesta, sizeof(respuesta), pipe_destino);
+        atendidas += e->es_solicitud;
+    }
+
+    res->solicitudes   = d->solicitudes;
+    res->aceptadas     = ctrl->contadores.solicitudes_ok;
+    res->reprogramadas = ctrl->contadores.solicitudes_reprogramadas;
+    res->negadas       = ctrl->contadores.solicitudes_negadas;
+    res->fuera_horario = d->solicitudes - atendidas;
+    res->promovidas    = ctrl->reporte.resumen.promovidas;
+    res->canceladas    = ctrl->reporte.resumen.canceladas;
+
+    long ocupadas = 0;
+    for (h = res->hora_ini; h < res->hora_fin; h++) {
+        ocupadas += ctrl->ocupacion[h];
+    }
+    res->utilizacion = (double) ocupadas / ((double) res->aforo * (res->hora_fin - res->hora_ini));
+
+    servidor_destruir(ctrl);
+}
+
+static void *hilo_simulador(void *arg)
+{
+    simulacion_t  *sim = arg;
+    size_t         tam = (sizeof(controlador_t) + TAM_LINEA_CACHE - 1) / TAM_LINEA_CACHE * TAM_LINEA_CACHE;
+    controlador_t *ctrl = aligned_alloc(TAM_LINEA_CACHE, tam);
+    int            i;
+
+    if (ctrl == NULL) {
+        perror("aligned_alloc (controlador)");
+        return NULL;
+    }
+
+    while ((i = atomic_fetch_add(&sim->siguiente, 1)) < sim->num) {
+        simular(ctrl, sim->demanda, sim->lista_espera, &sim->resultados[i]);
+    }
+
+    free(ctrl);
+    return NULL;
+}
+
+static double tasa(long parte, long total)
+{
+    return (total > 0) ? (double) parte / (double) total : 0.0;
+}
+
+/************************************************************************************************************
+ *  static void escribir_resultados(FILE *fp, const resultado_t *r, int num, int csv)                       *
+ *                                                                                                          *
+ *  Proposito: Una fila por configuracion, como tabla o como CSV. Las tasas son sobre todas las             *
+ *             solicitudes de la demanda: las que llegan despues del cierre cuentan como negadas.           *
+ ************************************************************************************************************/
+static void escribir_resultados(FILE *fp, const resultado_t *r, int num, int csv)
+{
+    int i;
+
+    if (csv) {
+        fprintf(fp, "aforo,hora_ini,hora_fin,duracion,solicitudes,aceptadas,reprogramadas,negadas,"
+                    "fuera_horario,promovidas,canceladas,tasa_aceptadas,tasa_reprogramadas,"
+                    "tasa_negadas,utilizacion\n");
+    } else {
+        fprintf(fp, "%6s %5s %6s %4s %11s %9s %13s %9s %9s %9s %9s %12s\n", "aforo", "abre", "cierra",
+                "dur", "solicitudes", "aceptadas", "reprogramadas", "negadas", "fuera", "%acept",
+                "%negadas", "utilizacion");
+    }
+
+    for (i = 0; i < num; i++, r++) {
+        if (r->solicitudes < 0) {
+            fprintf(stderr, "Configuracion %d/%d/%d/%d: no se pudo simular.\n",
+                    r->aforo, r->hora_ini, r->hora_fin, r->duracion);
+            continue;
+        }
+
+        double acept = tasa(r->aceptadas, r->solicitudes);
+        double repro = tasa(r->reprogramadas, r->solicitudes);
+        double neg   = tasa(r->negadas + r->fuera_horario, r->solicitudes);
+
+        if (csv) {
+            fprintf(fp, "%d,%d,%d,%d,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%.4f,%.4f,%.4f,%.4f\n",
+                    r->aforo, r->hora_ini, r->hora_fin, r->duracion, r->solicitudes, r->aceptadas,
+                    r->reprogramadas, r->negadas, r->fuera_horario, r->promovidas, r->canceladas,
+                    acept, repro, neg, r->utilizacion);
+        } else {
+            fprintf(fp, "%6d %2d:00 %3d:00 %4d %11ld %9ld %13ld %9ld %9ld %8.1f%% %8.1f%% %11.1f%%\n",
+                    r->aforo, r->hora_ini, r->hora_fin, r->duracion, r->solicitudes, r->aceptadas,
+                    r->reprogramadas, r->negadas, r->fuera_horario, acept * 100.0, neg * 100.0,
+                    r->utilizacion * 100.0);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static demanda_t demanda;
+    simulacion_t sim;
+    cabecera_traza_t cabecera;
+    pthread_t hilos[MAX_HILOS_SIMULADOR];
+
+    const char *archivos[MAX_VALORES_REJILLA];
+    int num_archivos = 0;
+    char traza[MAX_LONG_NOMBRE_PIPE] = {0};
+    char salida[MAX_LONG_NOMBRE_PIPE] = {0};
+
+    int aforos[MAX_VALORES_REJILLA],   num_aforos   = 0;
+    int horas_ini[MAX_VALORES_REJILLA], num_ini     = 0;
+    int horas_fin[MAX_VALORES_REJILLA], num_fin     = 0;
+    int duraciones[MAX_VALORES_REJILLA], num_dur    = 0;
+    int por_hora     = 0;
+    int lista_espera = 0;
+    int num_hilos    = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    int opt, i, a, b, c, e;
+
+    memset(&cabecera, 0, sizeof(cabecera));
+
+    while ((opt = getopt(argc, argv, "a:R:t:i:f:d:q:n:eo:")) != -1) {
+        int r = 0;
+
+        switch (opt) {
+        case 'a':
+            if (num_archivos >= MAX_VALORES_REJILLA) {
+                fprintf(stderr, "Error: a lo sumo %d archivos de demanda.\n", MAX_VALORES_REJILLA);
+                return EXIT_FAILURE;
+            }
+            archivos[num_archivos++] = optarg;
+            break;
+        case 'R':
+            strncpy(traza, optarg, sizeof(traza) - 1);
+            break;
+        case 't':
+            r = leer_rejilla(optarg, aforos, &num_aforos);
+            break;
+        case 'i':
+            r = leer_rejilla(optarg, horas_ini, &num_ini);
+            break;
+        case 'f':
+            r = leer_rejilla(optarg, horas_fin, &num_fin);
+            break;
+        case 'd':
+            r = leer_rejilla(optarg, duraciones, &num_dur);
+            break;
+        case 'q':
+            por_hora = atoi(optarg);
+            break;
+        case 'n':
+            num_hilos = atoi(optarg);
+            break;
+        case 'e':
+            lista_espera = 1;
+            break;
+        case 'o':
+            strncpy(salida, optarg, sizeof(salida) - 1);
+            break;
+        default:
+            fprintf(stderr, USO_SIMULADOR, argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        if (r != 0) {
+            fprintf(stderr, "Error: rejilla invalida en -%c '%s'.\n", opt, optarg);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ((num_archivos == 0) == (traza[0] == '\0') || por_hora < 0 || num_hilos <= 0) {
+        fprintf(stderr, USO_SIMULADOR, argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (num_hilos > MAX_HILOS_SIMULADOR) {
+        num_hilos = MAX_HILOS_SIMULADOR;
+    }
+
+    /* ---- Cargar la demanda una sola vez ---- */
+    uint64_t t0 = reloj_monotonico_ns();
+
+    if (traza[0] != '\0') {
+        if (cargar_traza(&demanda, traza, &cabecera) != 0) {
+            return EXIT_FAILURE;
+        }
+    } else {
+        demanda.relativa = 1;
+        for (i = 0; i < num_archivos; i++) {
+            if (cargar_csv(&demanda, archivos[i], i, por_hora) != 0) {
+                return EXIT_FAILURE;
+            }
+        }
+        qsort(demanda.eventos, (size_t) demanda.num, sizeof(evento_demanda_t), comparar_llegada);
+    }
+
+    /* ---- Rejillas por defecto: la configuracion grabada en la traza, o el dia completo ---- */
+    if (num_aforos == 0) {
+        if (traza[0] == '\0') {
+            fprintf(stderr, "Error: sin traza hay que indicar los aforos (-t).\n");
+            return EXIT_FAILURE;
+        }
+        aforos[num_aforos++] = cabecera.aforo_maximo;
+    }
+    if (num_ini == 0) {
+        horas_ini[num_ini++] = (traza[0] != '\0') ? cabecera.hora_ini : HORA_MINIMA_SIMULACION;
+    }
+    if (num_fin == 0) {
+        horas_fin[num_fin++] = (traza[0] != '\0') ? cabecera.hora_fin : HORA_MAXIMA_SIMULACION;
+    }
+    if (num_dur == 0) {
+        duraciones[num_dur++] = (traza[0] != '\0') ? cabecera.duracion_reserva : DURACION_RESERVA_DEFECTO;
+    }
+    if (traza[0] != '\0' && cabecera.lista_espera) {
+        lista_espera = 1;
+    }
+
+    /* ---- Producto de las rejillas (se omiten los horarios vacios) ---- */
+    sim.num        = 0;
+    sim.resultados = calloc((size_t) num_aforos * num_ini * num_fin * num_dur, sizeof(resultado_t));
+    if (sim.resultados == NULL) {
+        perror("calloc (resultados)");
+        return EXIT_FAILURE;
+    }
+
+    int omitidas = 0;
+    for (a = 0; a < num_aforos; a++) {
+        for (b = 0; b < num_ini; b++) {
+            for (c = 0; c < num_fin; c++) {
+                for (e = 0; e < num_dur; e++) {
+                    if (aforos[a] <= 0 || horas_ini[b] < 0 || horas_fin[c] > MAX_HORAS_DIA ||
+                        duraciones[e] <= 0 || duraciones[e] > MAX_HORAS_DIA) {
+                        fprintf(stderr, "Error: aforo, horario o duracion fuera de rango.\n");
+                        return EXIT_FAILURE;
+                    }
+                    if (horas_fin[c] <= horas_ini[b]) {
+                        omitidas++;
+                        continue;
+                    }
+
+                    resultado_t *r = &sim.resultados[sim.num++];
+                    r->aforo    = aforos[a];
+                    r->hora_ini = horas_ini[b];
+                    r->hora_fin = horas_fin[c];
+                    r->duracion = duraciones[e];
+                }
+            }
+        }
+    }
+
+    uint64_t t_carga = reloj_monotonico_ns() - t0;
+
+    printf("[SIMULADOR] Demanda: %ld mensajes (%ld solicitudes) cargados en %.3f s\n",
+           demanda.num, demanda.solicitudes, (double) t_carga / 1e9);
+    if (omitidas > 0) {
+        printf("[SIMULADOR] Se omiten %d combinaciones con horaFin <= horaIni\n", omitidas);
+    }
+
+    /* ---- Repartir las configuraciones entre los hilos ---- */
+    sim.demanda      = &demanda;
+    sim.lista_espera = lista_espera;
+    atomic_init(&sim.siguiente, 0);
+
+    if (num_hilos > sim.num) {
+        num_hilos = (sim.num > 0) ? sim.num : 1;
+    }
+
+    t0 = reloj_monotonico_ns();
+    for (i = 0; i < num_hilos; i++) {
+        if (pthread_create(&hilos[i], NULL, hilo_simulador, &sim) != 0) {
+            perror("pthread_create (simulador)");
+            num_hilos = i;
+            break;
+        }
+    }
+    for (i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    uint64_t t_sim = reloj_monotonico_ns() - t0;
+
+    escribir_resultados(stdout, sim.resultados, sim.num, 0);
+
+    double segundos = (double) t_sim / 1e9;
+    printf("\n[SIMULADOR] %d configuraciones con %d hilos en %.3f s", sim.num, num_hilos, segundos);
+    if (t_sim > 0) {
+        printf(" (%.0f mensajes/s)", (double) demanda.num * sim.num / segundos);
+    }
+    printf("\n");
+
+    if (salida[0] != '\0') {
+        FILE *fp = fopen(salida, "w");
+        if (fp == NULL) {
+            perror(salida);
+        } else {
+            escribir_resultados(fp, sim.resultados, sim.num, 1);
+            fclose(fp);
+            printf("[SIMULADOR] Resultados en '%s'.\n", salida);
+        }
+    }
+
+    free(sim.resultados);
+    free(demanda.eventos);
+    free(demanda.texto);
+
+    return EXIT_SUCCESS;
+}